@@ -0,0 +1,149 @@
+//
+// Allocation policies, small buffer optimization and growth policies
+//
+
+#include "bench_common.h"
+#include "fast_allocators.h"
+#include "fast_small_vector.h"
+
+#include <cstdlib>
+
+// Many short-lived small vectors, the per-request pattern
+
+constexpr std::size_t vectors_per_request = 1000;
+
+template <typename V>
+void fill_request(std::size_t elements)
+{
+    for (std::size_t i = 0; i < vectors_per_request; i++)
+    {
+        V v;
+        for (std::size_t j = 0; j < elements + i % 16; j++)
+            v.push_back(int(j));
+        benchmark::DoNotOptimize(v.data());
+    }
+}
+
+template <typename M>
+void bm_policy_short_lived(benchmark::State& state)
+{
+    std::size_t elements = state.range(0);
+
+    for (auto _ : state)
+    {
+        fill_request<fast_vector<int, false, 16, M>>(elements);
+    }
+    state.SetItemsProcessed(state.iterations() * vectors_per_request);
+}
+
+void bm_arena_short_lived(benchmark::State& state)
+{
+    std::size_t elements = state.range(0);
+    monotonic_arena arena;
+
+    for (auto _ : state)
+    {
+        arena_scope scope(arena);
+        fill_request<fast_vector<int, false, 16, arena_allocator>>(elements);
+        arena.release();
+    }
+    state.SetItemsProcessed(state.iterations() * vectors_per_request);
+}
+
+void bm_std_vector_short_lived(benchmark::State& state)
+{
+    std::size_t elements = state.range(0);
+
+    for (auto _ : state)
+    {
+        fill_request<std::vector<int>>(elements);
+    }
+    state.SetItemsProcessed(state.iterations() * vectors_per_request);
+}
+
+BENCHMARK(bm_std_vector_short_lived)->Arg(4)->Arg(16)->Arg(64)->Arg(1024);
+BENCHMARK_TEMPLATE(bm_policy_short_lived, malloc_allocator)->Arg(4)->Arg(16)->Arg(64)->Arg(1024);
+BENCHMARK_TEMPLATE(bm_policy_short_lived, pool_allocator)->Arg(4)->Arg(16)->Arg(64)->Arg(1024);
+BENCHMARK(bm_arena_short_lived)->Arg(4)->Arg(16)->Arg(64)->Arg(1024);
+
+// Small buffer optimization, allocations per vector
+
+template <typename V, typename Counter>
+void bm_small_vector_traffic(benchmark::State& state)
+{
+    std::size_t elements = state.range(0);
+    Counter::reset();
+
+    for (auto _ : state)
+    {
+        V v;
+        for (std::size_t i = 0; i < elements; i++)
+            v.push_back(int(i));
+        benchmark::DoNotOptimize(v.data());
+    }
+
+    state.counters["allocs_per_vector"] = double(Counter::allocations) / double(state.iterations());
+    state.SetItemsProcessed(state.iterations() * elements);
+}
+
+using counted = counting_allocator<malloc_allocator>;
+
+BENCHMARK_TEMPLATE(bm_small_vector_traffic, fast_vector<int, false, 16, counted>, counted)
+    ->Arg(1)->Arg(4)->Arg(8)->Arg(15)->Arg(16)->Arg(64);
+BENCHMARK_TEMPLATE(bm_small_vector_traffic, fast_small_vector<int, 16, false, 16, counted>, counted)
+    ->Arg(1)->Arg(4)->Arg(8)->Arg(15)->Arg(16)->Arg(64);
+
+template <typename V>
+void bm_small_vector_move(benchmark::State& state)
+{
+    std::size_t elements = state.range(0);
+
+    V a;
+    for (std::size_t i = 0; i < elements; i++)
+        a.push_back(int(i));
+
+    for (auto _ : state)
+    {
+        V b(std::move(a));
+        a = std::move(b);
+        benchmark::DoNotOptimize(a.data());
+    }
+}
+
+BENCHMARK_TEMPLATE(bm_small_vector_move, fast_vector<int>)->Arg(8)->Arg(64);
+BENCHMARK_TEMPLATE(bm_small_vector_move, fast_small_vector<int, 16>)->Arg(8)->Arg(64);
+
+// Growth policies on a push heavy workload: allocation calls, peak bytes, peak RSS
+
+template <typename G>
+void bm_growth_policy(benchmark::State& state)
+{
+    using counter = counting_allocator<malloc_allocator>;
+    std::size_t n = state.range(0);
+    std::size_t allocations = 0;
+    std::size_t peak_bytes = 0;
+
+    for (auto _ : state)
+    {
+        counter::reset();
+        {
+            fast_vector<int, false, 16, counter, G> v;
+            for (std::size_t i = 0; i < n; i++)
+                v.push_back(int(i));
+            benchmark::DoNotOptimize(v.data());
+        }
+        allocations = counter::allocations;
+        peak_bytes = counter::peak_bytes;
+    }
+
+    state.counters["allocations"] = double(allocations);
+    state.counters["peak_bytes"] = double(peak_bytes);
+    state.counters["overhead"] = double(peak_bytes) / double(n * sizeof(int));
+    state.counters["peak_rss"] = peak_rss_bytes();
+    set_processed<int>(state, n);
+}
+
+BENCHMARK_TEMPLATE(bm_growth_policy, factor_growth<2>)->Apply(bench_sizes);
+BENCHMARK_TEMPLATE(bm_growth_policy, factor_growth<3, 2>)->Apply(bench_sizes);
+BENCHMARK_TEMPLATE(bm_growth_policy, page_growth<factor_growth<3, 2>>)->Apply(bench_sizes);
+BENCHMARK_TEMPLATE(bm_growth_policy, size_class_growth<factor_growth<3, 2>>)->Apply(bench_sizes);
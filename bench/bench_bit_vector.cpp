@@ -0,0 +1,161 @@
+//
+// Selection masks: fast_bit_vector (1 bit per flag) vs fast_vector<bool> (8 bits per flag)
+//
+
+#include "bench_common.h"
+
+#include "fast_bit_vector.h"
+
+#include <algorithm>
+#include <random>
+
+namespace
+{
+
+using byte_flags = fast_vector<bool>;
+using bit_flags = fast_bit_vector<>;
+
+// Every density-th flag set on average
+template <typename Flags>
+Flags make_flags(std::size_t n, unsigned density, std::uint64_t seed)
+{
+    std::mt19937_64 rng(seed);
+    Flags flags;
+    flags.reserve(n);
+    for (std::size_t i = 0; i < n; i++)
+        flags.push_back(rng() % density == 0);
+    return flags;
+}
+
+std::size_t footprint(const byte_flags& flags)
+{
+    return flags.size() * sizeof(bool);
+}
+
+std::size_t footprint(const bit_flags& flags)
+{
+    return flags.words().size() * sizeof(bit_flags::word_type);
+}
+
+}
+
+template <typename Flags>
+void bm_flags_push_back(benchmark::State& state)
+{
+    const std::size_t n = std::size_t(state.range(0));
+
+    for (auto _ : state)
+    {
+        Flags flags;
+        for (std::size_t i = 0; i < n; i++)
+            flags.push_back((i & 3) == 0);
+        benchmark::DoNotOptimize(flags);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// The same flags gathered 64 at a time into a word, the way to build a large mask
+void bm_flags_append_word(benchmark::State& state)
+{
+    const std::size_t n = std::size_t(state.range(0));
+
+    for (auto _ : state)
+    {
+        bit_flags flags;
+        for (std::size_t i = 0; i < n; i += bit_flags::word_bits)
+        {
+            const std::size_t count = std::min<std::size_t>(bit_flags::word_bits, n - i);
+            bit_flags::word_type word = 0;
+            for (std::size_t bit = 0; bit < count; bit++)
+                word |= bit_flags::word_type(((i + bit) & 3) == 0) << bit;
+            flags.append_word(word, count);
+        }
+        benchmark::DoNotOptimize(flags);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Counting the selected rows, the footprint counter is the mask size in bytes
+template <typename Flags>
+void bm_flags_count(benchmark::State& state)
+{
+    const Flags flags = make_flags<Flags>(std::size_t(state.range(0)), 2, 42);
+
+    for (auto _ : state)
+    {
+        std::size_t count = 0;
+        if constexpr (std::is_same_v<Flags, bit_flags>)
+        {
+            count = flags.popcount();
+        }
+        else
+        {
+            for (bool flag : flags)
+                count += flag;
+        }
+        benchmark::DoNotOptimize(count);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * std::int64_t(footprint(flags)));
+    state.counters["footprint"] = double(footprint(flags));
+}
+
+// Intersecting two masks in place
+template <typename Flags>
+void bm_flags_and(benchmark::State& state)
+{
+    Flags flags = make_flags<Flags>(std::size_t(state.range(0)), 2, 42);
+    const Flags other = make_flags<Flags>(std::size_t(state.range(0)), 2, 7);
+
+    for (auto _ : state)
+    {
+        if constexpr (std::is_same_v<Flags, bit_flags>)
+        {
+            flags &= other;
+        }
+        else
+        {
+            for (std::size_t i = 0; i < flags.size(); i++)
+                flags[i] = flags[i] & other[i];
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["footprint"] = double(footprint(flags));
+}
+
+// Visiting the selected rows of a sparse mask, 1 in 16 set
+template <typename Flags>
+void bm_flags_iterate(benchmark::State& state)
+{
+    const Flags flags = make_flags<Flags>(std::size_t(state.range(0)), 16, 42);
+
+    for (auto _ : state)
+    {
+        std::size_t sum = 0;
+        if constexpr (std::is_same_v<Flags, bit_flags>)
+        {
+            flags.for_each_set([&](std::size_t i) { sum += i; });
+        }
+        else
+        {
+            for (std::size_t i = 0; i < flags.size(); i++)
+            {
+                if (flags[i])
+                    sum += i;
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_TEMPLATE(bm_flags_push_back, byte_flags)->Apply(bench_sizes);
+BENCHMARK_TEMPLATE(bm_flags_push_back, bit_flags)->Apply(bench_sizes);
+BENCHMARK(bm_flags_append_word)->Apply(bench_sizes);
+BENCHMARK_TEMPLATE(bm_flags_count, byte_flags)->Apply(bench_sizes);
+BENCHMARK_TEMPLATE(bm_flags_count, bit_flags)->Apply(bench_sizes);
+BENCHMARK_TEMPLATE(bm_flags_and, byte_flags)->Apply(bench_sizes);
+BENCHMARK_TEMPLATE(bm_flags_and, bit_flags)->Apply(bench_sizes);
+BENCHMARK_TEMPLATE(bm_flags_iterate, byte_flags)->Apply(bench_sizes);
+BENCHMARK_TEMPLATE(bm_flags_iterate, bit_flags)->Apply(bench_sizes);
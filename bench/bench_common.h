@@ -0,0 +1,188 @@
+//
+// Shared helpers of the fast_vector benchmarks
+//
+
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+#include "fast_vector.h"
+
+#ifndef FAST_VECTOR_BENCH_MAX_SIZE
+#define FAST_VECTOR_BENCH_MAX_SIZE 100000000
+#endif
+
+// Element counts 10, 100, ... up to FAST_VECTOR_BENCH_MAX_SIZE
+inline void bench_sizes(benchmark::internal::Benchmark* b)
+{
+    for (std::int64_t n = 10; n <= FAST_VECTOR_BENCH_MAX_SIZE; n *= 10)
+        b->Arg(n);
+}
+
+// Heap allocated strings need ~80 bytes each, stop ten times earlier than the trivial types
+inline void bench_sizes_nontrivial(benchmark::internal::Benchmark* b)
+{
+    for (std::int64_t n = 10; n <= FAST_VECTOR_BENCH_MAX_SIZE / 10; n *= 10)
+        b->Arg(n);
+}
+
+template <typename T>
+T make_value(std::size_t i);
+
+template <>
+inline int make_value<int>(std::size_t i)
+{
+    return int(i);
+}
+
+template <>
+inline std::uint32_t make_value<std::uint32_t>(std::size_t i)
+{
+    return std::uint32_t(i);
+}
+
+template <>
+inline float make_value<float>(std::size_t i)
+{
+    return float(i);
+}
+
+// Long enough to live on the heap, short strings would only measure the SSO copy
+template <>
+inline std::string make_value<std::string>(std::size_t i)
+{
+    return "fast_vector benchmark item #" + std::to_string(i);
+}
+
+/**
+ * The i-th benchmark value. Arithmetic values are computed on the fly, the others are
+ * prepared up front so their construction cost stays out of the measured loop.
+ */
+template <typename T>
+class value_source
+{
+public:
+    explicit value_source(std::size_t n)
+    {
+        if constexpr (!std::is_arithmetic_v<T>)
+        {
+            m_values.reserve(n);
+            for (std::size_t i = 0; i < n; i++)
+                m_values.push_back(make_value<T>(i));
+        }
+    }
+
+    decltype(auto) operator[](std::size_t i) const
+    {
+        if constexpr (std::is_arithmetic_v<T>)
+            return make_value<T>(i);
+        else
+            return (m_values[i]);
+    }
+
+    const T* data() const
+    {
+        return m_values.data();
+    }
+
+private:
+    std::vector<T> m_values;
+};
+
+template <typename V>
+struct is_std_vector : std::false_type {};
+
+template <typename T, typename Allocator>
+struct is_std_vector<std::vector<T, Allocator>> : std::true_type {};
+
+// Sets the items/bytes processed counters for n elements per iteration
+template <typename T>
+void set_processed(benchmark::State& state, std::int64_t n)
+{
+    state.SetItemsProcessed(state.iterations() * n);
+    state.SetBytesProcessed(state.iterations() * n * std::int64_t(sizeof(T)));
+}
+
+// Peak resident set size of the process in bytes, 0 when unknown
+inline double peak_rss_bytes()
+{
+#if defined(__unix__) || defined(__APPLE__)
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return double(usage.ru_maxrss);
+#else
+    return double(usage.ru_maxrss) * 1024.0;
+#endif
+#else
+    return 0.0;
+#endif
+}
+
+/**
+ * Allocation policy wrapper counting the calls and the live/peak bytes of the Base policy.
+ */
+template <typename Base = malloc_allocator>
+struct counting_allocator
+{
+    static inline std::size_t allocations = 0;
+    static inline std::size_t live_bytes = 0;
+    static inline std::size_t peak_bytes = 0;
+
+    static void reset() noexcept
+    {
+        allocations = live_bytes = peak_bytes = 0;
+    }
+
+    static void* allocate(std::size_t bytes, std::size_t alignment)
+    {
+        allocations++;
+        track(0, bytes);
+        return Base::allocate(bytes, alignment);
+    }
+
+    static void* allocate_zeroed(std::size_t bytes, std::size_t alignment)
+    {
+        allocations++;
+        track(0, bytes);
+        return Base::allocate_zeroed(bytes, alignment);
+    }
+
+    static bool try_expand(void* ptr, std::size_t old_bytes, std::size_t new_bytes, std::size_t alignment) noexcept
+    {
+        if (!Base::try_expand(ptr, old_bytes, new_bytes, alignment))
+            return false;
+        track(old_bytes, new_bytes);
+        return true;
+    }
+
+    static void* reallocate(void* ptr, std::size_t old_bytes, std::size_t new_bytes, std::size_t alignment)
+    {
+        allocations++;
+        track(ptr ? old_bytes : 0, new_bytes);
+        return Base::reallocate(ptr, old_bytes, new_bytes, alignment);
+    }
+
+    static void deallocate(void* ptr, std::size_t bytes, std::size_t alignment) noexcept
+    {
+        if (ptr)
+            track(bytes, 0);
+        Base::deallocate(ptr, bytes, alignment);
+    }
+
+private:
+    static void track(std::size_t released, std::size_t acquired) noexcept
+    {
+        live_bytes += acquired - released;
+        if (live_bytes > peak_bytes)
+            peak_bytes = live_bytes;
+    }
+};
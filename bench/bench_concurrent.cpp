@@ -0,0 +1,94 @@
+//
+// Many producers appending into one vector: fetch_add slot claiming vs a mutex around push_back
+//
+
+#include "bench_common.h"
+
+#include "fast_concurrent_vector.h"
+
+#include <memory>
+#include <mutex>
+
+namespace
+{
+
+// The way producers share a fast_vector without the concurrent sibling
+struct locked_vector
+{
+    using value_type = std::uint64_t;
+
+    void push_back(std::uint64_t value)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        items.push_back(value);
+    }
+
+    void append(const std::uint64_t values[], std::size_t count)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        items.append(values, count);
+    }
+
+    std::mutex mutex;
+    fast_vector<std::uint64_t> items;
+};
+
+using concurrent_vector = fast_concurrent_vector<std::uint64_t>;
+
+constexpr std::size_t producer_batch = 1024;
+
+}
+
+/**
+ * Every thread appends producer_batch elements per iteration into the same shared vector.
+ */
+template <typename V>
+void bm_concurrent_push_back(benchmark::State& state)
+{
+    static std::unique_ptr<V> shared;
+
+    if (state.thread_index() == 0)
+        shared = std::make_unique<V>();
+
+    for (auto _ : state)
+    {
+        for (std::size_t i = 0; i < producer_batch; i++)
+            shared->push_back(i);
+    }
+
+    set_processed<std::uint64_t>(state, producer_batch);
+
+    if (state.thread_index() == 0)
+        shared.reset();
+}
+
+/**
+ * The same producers appending whole batches: one fetch_add and one publication per batch.
+ */
+template <typename V>
+void bm_concurrent_append(benchmark::State& state)
+{
+    static std::unique_ptr<V> shared;
+
+    std::uint64_t batch[producer_batch];
+    for (std::size_t i = 0; i < producer_batch; i++)
+        batch[i] = i;
+
+    if (state.thread_index() == 0)
+        shared = std::make_unique<V>();
+
+    for (auto _ : state)
+    {
+        shared->append(batch, producer_batch);
+    }
+
+    set_processed<std::uint64_t>(state, producer_batch);
+
+    if (state.thread_index() == 0)
+        shared.reset();
+}
+
+BENCHMARK_TEMPLATE(bm_concurrent_push_back, locked_vector)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(bm_concurrent_push_back, concurrent_vector)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(bm_concurrent_append, locked_vector)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(bm_concurrent_append, concurrent_vector)->ThreadRange(1, 64)->UseRealTime();
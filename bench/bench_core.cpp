@@ -0,0 +1,407 @@
+//
+// Every public fast_vector operation against std::vector, trivial & non-trivial elements
+//
+
+#include "bench_common.h"
+
+template <typename V>
+void bm_push_back(benchmark::State& state)
+{
+    using T = typename V::value_type;
+    std::size_t n = state.range(0);
+    value_source<T> values(n);
+
+    for (auto _ : state)
+    {
+        V v;
+        for (std::size_t i = 0; i < n; i++)
+            v.push_back(values[i]);
+        benchmark::DoNotOptimize(v.data());
+    }
+    set_processed<T>(state, n);
+}
+
+template <typename V>
+void bm_reserve_push_back(benchmark::State& state)
+{
+    using T = typename V::value_type;
+    std::size_t n = state.range(0);
+    value_source<T> values(n);
+
+    for (auto _ : state)
+    {
+        V v;
+        v.reserve(n);
+        for (std::size_t i = 0; i < n; i++)
+            v.push_back(values[i]);
+        benchmark::DoNotOptimize(v.data());
+    }
+    set_processed<T>(state, n);
+}
+
+// The status checked push_back, against the plain one above
+template <typename V>
+void bm_try_push_back(benchmark::State& state)
+{
+    using T = typename V::value_type;
+    std::size_t n = state.range(0);
+    value_source<T> values(n);
+
+    for (auto _ : state)
+    {
+        V v;
+        for (std::size_t i = 0; i < n; i++)
+        {
+            if (v.try_push_back(values[i]) != fast_vector_status::ok)
+                state.SkipWithError("Out of memory");
+        }
+        benchmark::DoNotOptimize(v.data());
+    }
+    set_processed<T>(state, n);
+}
+
+template <typename V>
+void bm_emplace_back(benchmark::State& state)
+{
+    using T = typename V::value_type;
+    std::size_t n = state.range(0);
+
+    for (auto _ : state)
+    {
+        V v;
+        for (std::size_t i = 0; i < n; i++)
+            v.emplace_back(64, char('a' + i % 26));
+        benchmark::DoNotOptimize(v.data());
+    }
+    set_processed<T>(state, n);
+}
+
+template <typename V>
+void bm_push_back_pop_back(benchmark::State& state)
+{
+    using T = typename V::value_type;
+    std::size_t n = state.range(0);
+    value_source<T> values(n);
+
+    for (auto _ : state)
+    {
+        V v;
+        for (std::size_t i = 0; i < n; i++)
+            v.push_back(values[i]);
+        while (!v.empty())
+            v.pop_back();
+        benchmark::DoNotOptimize(v.data());
+    }
+    set_processed<T>(state, n);
+}
+
+template <typename V>
+void bm_copy(benchmark::State& state)
+{
+    using T = typename V::value_type;
+    std::size_t n = state.range(0);
+    value_source<T> values(n);
+
+    V source;
+    for (std::size_t i = 0; i < n; i++)
+        source.push_back(values[i]);
+
+    for (auto _ : state)
+    {
+        V copy(source);
+        benchmark::DoNotOptimize(copy.data());
+    }
+    set_processed<T>(state, n);
+}
+
+template <typename V>
+void bm_copy_assign(benchmark::State& state)
+{
+    using T = typename V::value_type;
+    std::size_t n = state.range(0);
+    value_source<T> values(n);
+
+    V source;
+    for (std::size_t i = 0; i < n; i++)
+        source.push_back(values[i]);
+
+    V target;
+    for (auto _ : state)
+    {
+        target = source;
+        benchmark::DoNotOptimize(target.data());
+    }
+    set_processed<T>(state, n);
+}
+
+template <typename V>
+void bm_move(benchmark::State& state)
+{
+    using T = typename V::value_type;
+    std::size_t n = state.range(0);
+    value_source<T> values(n);
+
+    V a;
+    for (std::size_t i = 0; i < n; i++)
+        a.push_back(values[i]);
+
+    for (auto _ : state)
+    {
+        V b(std::move(a));
+        a = std::move(b);
+        benchmark::DoNotOptimize(a.data());
+    }
+}
+
+template <typename V>
+void bm_append(benchmark::State& state)
+{
+    using T = typename V::value_type;
+    std::size_t n = state.range(0);
+    std::vector<T> chunk;
+    for (std::size_t i = 0; i < 64; i++)
+        chunk.push_back(make_value<T>(i));
+
+    for (auto _ : state)
+    {
+        V v;
+        for (std::size_t i = 0; i < n; i += chunk.size())
+        {
+            if constexpr (is_std_vector<V>::value)
+                v.insert(v.end(), chunk.begin(), chunk.end());
+            else
+                v.append(chunk.data(), chunk.size());
+        }
+        benchmark::DoNotOptimize(v.data());
+    }
+    set_processed<T>(state, n);
+}
+
+template <typename V>
+void bm_resize(benchmark::State& state)
+{
+    using T = typename V::value_type;
+    std::size_t n = state.range(0);
+
+    for (auto _ : state)
+    {
+        V v;
+        v.resize(n);
+        benchmark::DoNotOptimize(v.data());
+        v.resize(n / 2);
+        benchmark::DoNotOptimize(v.data());
+    }
+    set_processed<T>(state, n);
+}
+
+template <typename V>
+void bm_sized_construct(benchmark::State& state)
+{
+    using T = typename V::value_type;
+    std::size_t n = state.range(0);
+
+    for (auto _ : state)
+    {
+        V v(n);
+        benchmark::DoNotOptimize(v.data());
+    }
+    set_processed<T>(state, n);
+}
+
+template <typename V>
+void bm_initializer_list(benchmark::State& state)
+{
+    using T = typename V::value_type;
+
+    for (auto _ : state)
+    {
+        V v{make_value<T>(1), make_value<T>(2), make_value<T>(3), make_value<T>(4),
+            make_value<T>(5), make_value<T>(6), make_value<T>(7), make_value<T>(8)};
+        benchmark::DoNotOptimize(v.data());
+    }
+    set_processed<T>(state, 8);
+}
+
+template <typename V>
+void bm_index(benchmark::State& state)
+{
+    using T = typename V::value_type;
+    std::size_t n = state.range(0);
+    value_source<T> values(n);
+
+    V v;
+    for (std::size_t i = 0; i < n; i++)
+        v.push_back(values[i]);
+
+    for (auto _ : state)
+    {
+        std::size_t sum = 0;
+        for (std::size_t i = 0; i < n; i++)
+        {
+            if constexpr (std::is_arithmetic_v<T>)
+                sum += std::size_t(v[i]);
+            else
+                sum += v[i].size();
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    set_processed<T>(state, n);
+}
+
+template <typename V>
+void bm_at(benchmark::State& state)
+{
+    using T = typename V::value_type;
+    std::size_t n = state.range(0);
+    value_source<T> values(n);
+
+    V v;
+    for (std::size_t i = 0; i < n; i++)
+        v.push_back(values[i]);
+
+    for (auto _ : state)
+    {
+        std::size_t sum = 0;
+        for (std::size_t i = 0; i < n; i++)
+        {
+            if constexpr (std::is_arithmetic_v<T>)
+                sum += std::size_t(v.at(i));
+            else
+                sum += v.at(i).size();
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    set_processed<T>(state, n);
+}
+
+template <typename V>
+void bm_iterate(benchmark::State& state)
+{
+    using T = typename V::value_type;
+    std::size_t n = state.range(0);
+    value_source<T> values(n);
+
+    V v;
+    for (std::size_t i = 0; i < n; i++)
+        v.push_back(values[i]);
+
+    for (auto _ : state)
+    {
+        std::size_t sum = 0;
+        for (const T& item : v)
+        {
+            if constexpr (std::is_arithmetic_v<T>)
+                sum += std::size_t(item);
+            else
+                sum += item.size();
+        }
+        benchmark::DoNotOptimize(sum);
+        benchmark::DoNotOptimize(v.front());
+        benchmark::DoNotOptimize(v.back());
+    }
+    set_processed<T>(state, n);
+}
+
+template <typename V>
+void bm_clear_refill(benchmark::State& state)
+{
+    using T = typename V::value_type;
+    std::size_t n = state.range(0);
+    value_source<T> values(n);
+
+    V v;
+    for (auto _ : state)
+    {
+        v.clear();
+        for (std::size_t i = 0; i < n; i++)
+            v.push_back(values[i]);
+        benchmark::DoNotOptimize(v.data());
+    }
+    set_processed<T>(state, n);
+}
+
+template <typename V>
+void bm_shrink_to_fit(benchmark::State& state)
+{
+    using T = typename V::value_type;
+    std::size_t n = state.range(0);
+    value_source<T> values(n);
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        V v;
+        v.reserve(2 * n);
+        for (std::size_t i = 0; i < n; i++)
+            v.push_back(values[i]);
+        state.ResumeTiming();
+
+        v.shrink_to_fit();
+        benchmark::DoNotOptimize(v.data());
+    }
+    set_processed<T>(state, n);
+}
+
+template <typename V>
+void bm_swap(benchmark::State& state)
+{
+    V a(16), b(32);
+
+    for (auto _ : state)
+    {
+        if constexpr (is_std_vector<V>::value)
+            a.swap(b);
+        else
+            V::swap(a, b);
+        benchmark::DoNotOptimize(a.data());
+    }
+}
+
+#define BENCH_BOTH(fn, T, sizes)                                  \
+    BENCHMARK_TEMPLATE(fn, std::vector<T>)->Apply(sizes);         \
+    BENCHMARK_TEMPLATE(fn, fast_vector<T>)->Apply(sizes)
+
+// Trivial data types
+
+BENCH_BOTH(bm_push_back, int, bench_sizes);
+BENCHMARK_TEMPLATE(bm_try_push_back, fast_vector<int>)->Apply(bench_sizes);
+BENCH_BOTH(bm_reserve_push_back, int, bench_sizes);
+BENCH_BOTH(bm_push_back_pop_back, int, bench_sizes);
+BENCH_BOTH(bm_copy, int, bench_sizes);
+BENCH_BOTH(bm_copy_assign, int, bench_sizes);
+BENCH_BOTH(bm_move, int, bench_sizes);
+BENCH_BOTH(bm_append, int, bench_sizes);
+BENCH_BOTH(bm_resize, int, bench_sizes);
+BENCH_BOTH(bm_sized_construct, int, bench_sizes);
+BENCH_BOTH(bm_index, int, bench_sizes);
+BENCH_BOTH(bm_at, int, bench_sizes);
+BENCH_BOTH(bm_iterate, int, bench_sizes);
+BENCH_BOTH(bm_clear_refill, int, bench_sizes);
+BENCH_BOTH(bm_shrink_to_fit, int, bench_sizes);
+BENCHMARK_TEMPLATE(bm_initializer_list, std::vector<int>);
+BENCHMARK_TEMPLATE(bm_initializer_list, fast_vector<int>);
+BENCHMARK_TEMPLATE(bm_swap, std::vector<int>);
+BENCHMARK_TEMPLATE(bm_swap, fast_vector<int>);
+
+// Non-trivial data types
+
+BENCH_BOTH(bm_push_back, std::string, bench_sizes_nontrivial);
+BENCHMARK_TEMPLATE(bm_try_push_back, fast_vector<std::string>)->Apply(bench_sizes_nontrivial);
+BENCH_BOTH(bm_reserve_push_back, std::string, bench_sizes_nontrivial);
+BENCH_BOTH(bm_emplace_back, std::string, bench_sizes_nontrivial);
+BENCH_BOTH(bm_push_back_pop_back, std::string, bench_sizes_nontrivial);
+BENCH_BOTH(bm_copy, std::string, bench_sizes_nontrivial);
+BENCH_BOTH(bm_copy_assign, std::string, bench_sizes_nontrivial);
+BENCH_BOTH(bm_move, std::string, bench_sizes_nontrivial);
+BENCH_BOTH(bm_append, std::string, bench_sizes_nontrivial);
+BENCH_BOTH(bm_resize, std::string, bench_sizes_nontrivial);
+BENCH_BOTH(bm_sized_construct, std::string, bench_sizes_nontrivial);
+BENCH_BOTH(bm_index, std::string, bench_sizes_nontrivial);
+BENCH_BOTH(bm_at, std::string, bench_sizes_nontrivial);
+BENCH_BOTH(bm_iterate, std::string, bench_sizes_nontrivial);
+BENCH_BOTH(bm_clear_refill, std::string, bench_sizes_nontrivial);
+BENCH_BOTH(bm_shrink_to_fit, std::string, bench_sizes_nontrivial);
+BENCHMARK_TEMPLATE(bm_initializer_list, std::vector<std::string>);
+BENCHMARK_TEMPLATE(bm_initializer_list, fast_vector<std::string>);
+BENCHMARK_TEMPLATE(bm_swap, std::vector<std::string>);
+BENCHMARK_TEMPLATE(bm_swap, fast_vector<std::string>);
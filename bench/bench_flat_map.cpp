@@ -0,0 +1,128 @@
+//
+// Lookups and bulk builds: fast_flat_map vs std::map and std::unordered_map
+//
+
+#include "bench_common.h"
+
+#include "fast_flat_map.h"
+
+#include <map>
+#include <random>
+#include <unordered_map>
+
+namespace
+{
+
+// Keys spread over the whole range so the lookups do not walk the memory in order
+std::uint64_t make_key(std::size_t i)
+{
+    return (std::uint64_t(i) + 1) * 0x9e3779b97f4a7c15ull;
+}
+
+template <typename Map>
+Map make_map(std::size_t n)
+{
+    Map map;
+    for (std::size_t i = 0; i < n; i++)
+        map.insert({make_key(i), std::uint64_t(i)});
+    return map;
+}
+
+template <>
+fast_flat_map<std::uint64_t, std::uint64_t> make_map(std::size_t n)
+{
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> items;
+    for (std::size_t i = 0; i < n; i++)
+        items.emplace_back(make_key(i), std::uint64_t(i));
+    return fast_flat_map<std::uint64_t, std::uint64_t>(items.begin(), items.end());
+}
+
+// Random keys present in a map of n, a fixed batch reused by every iteration
+fast_vector<std::uint64_t> make_queries(std::size_t n)
+{
+    std::mt19937_64 rng(42);
+    fast_vector<std::uint64_t> queries(4096);
+    for (auto& query : queries)
+        query = make_key(rng() % n);
+    return queries;
+}
+
+// Maps of 10 ... FAST_VECTOR_BENCH_MAX_SIZE / 10 entries, the node based ones need ~60 bytes each
+void map_sizes(benchmark::internal::Benchmark* b)
+{
+    for (std::int64_t n = 10; n <= FAST_VECTOR_BENCH_MAX_SIZE / 10; n *= 10)
+        b->Arg(n);
+}
+
+}
+
+template <typename Map>
+void bm_map_find(benchmark::State& state)
+{
+    const Map map = make_map<Map>(std::size_t(state.range(0)));
+    const fast_vector<std::uint64_t> queries = make_queries(std::size_t(state.range(0)));
+
+    for (auto _ : state)
+    {
+        std::uint64_t sum = 0;
+        for (std::uint64_t key : queries)
+            sum += map.find(key)->second;
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * std::int64_t(queries.size()));
+}
+
+// Half of the queried keys are missing
+template <typename Map>
+void bm_map_contains_mixed(benchmark::State& state)
+{
+    const Map map = make_map<Map>(std::size_t(state.range(0)));
+    fast_vector<std::uint64_t> queries = make_queries(std::size_t(state.range(0)));
+
+    for (std::size_t i = 0; i < queries.size(); i += 2)
+        queries[i] ^= 1;
+
+    for (auto _ : state)
+    {
+        std::size_t found = 0;
+        for (std::uint64_t key : queries)
+            found += map.count(key);
+        benchmark::DoNotOptimize(found);
+    }
+    state.SetItemsProcessed(state.iterations() * std::int64_t(queries.size()));
+}
+
+// Building the whole map from unsorted items
+template <typename Map>
+void bm_map_build(benchmark::State& state)
+{
+    std::mt19937_64 rng(42);
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> items;
+    for (std::int64_t i = 0; i < state.range(0); i++)
+        items.emplace_back(rng(), std::uint64_t(i));
+
+    for (auto _ : state)
+    {
+        Map map;
+        if constexpr (std::is_same_v<Map, fast_flat_map<std::uint64_t, std::uint64_t>>)
+            map.insert_range(items.begin(), items.end());
+        else
+            map.insert(items.begin(), items.end());
+        benchmark::DoNotOptimize(map);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+using std_map = std::map<std::uint64_t, std::uint64_t>;
+using std_unordered_map = std::unordered_map<std::uint64_t, std::uint64_t>;
+using flat_map = fast_flat_map<std::uint64_t, std::uint64_t>;
+
+BENCHMARK_TEMPLATE(bm_map_find, std_map)->Apply(map_sizes);
+BENCHMARK_TEMPLATE(bm_map_find, std_unordered_map)->Apply(map_sizes);
+BENCHMARK_TEMPLATE(bm_map_find, flat_map)->Apply(map_sizes);
+BENCHMARK_TEMPLATE(bm_map_contains_mixed, std_map)->Apply(map_sizes);
+BENCHMARK_TEMPLATE(bm_map_contains_mixed, std_unordered_map)->Apply(map_sizes);
+BENCHMARK_TEMPLATE(bm_map_contains_mixed, flat_map)->Apply(map_sizes);
+BENCHMARK_TEMPLATE(bm_map_build, std_map)->Apply(map_sizes);
+BENCHMARK_TEMPLATE(bm_map_build, std_unordered_map)->Apply(map_sizes);
+BENCHMARK_TEMPLATE(bm_map_build, flat_map)->Apply(map_sizes);
@@ -0,0 +1,132 @@
+//
+// Inserts, lookups and erasures: fast_hash_map vs std::unordered_map
+//
+
+#include "bench_common.h"
+
+#include "fast_hash_map.h"
+
+#include <random>
+#include <unordered_map>
+
+namespace
+{
+
+// Random keys, distinct with overwhelming probability
+fast_vector<std::uint64_t> make_keys(std::size_t n, std::uint64_t seed)
+{
+    std::mt19937_64 rng(seed);
+    fast_vector<std::uint64_t> keys(n);
+    for (auto& key : keys)
+        key = rng();
+    return keys;
+}
+
+template <typename Map>
+Map make_map(const fast_vector<std::uint64_t>& keys)
+{
+    Map map;
+    map.reserve(keys.size());
+    for (std::size_t i = 0; i < keys.size(); i++)
+        map.insert({keys[i], std::uint64_t(i)});
+    return map;
+}
+
+// Maps of 1000 ... FAST_VECTOR_BENCH_MAX_SIZE entries, std::unordered_map takes ~56 bytes each
+void hash_sizes(benchmark::internal::Benchmark* b)
+{
+    for (std::int64_t n = 1000; n <= FAST_VECTOR_BENCH_MAX_SIZE; n *= 10)
+        b->Arg(n);
+}
+
+}
+
+// Growing from empty, the rehashes included
+template <typename Map>
+void bm_hash_insert(benchmark::State& state)
+{
+    const fast_vector<std::uint64_t> keys = make_keys(std::size_t(state.range(0)), 42);
+
+    for (auto _ : state)
+    {
+        Map map;
+        for (std::size_t i = 0; i < keys.size(); i++)
+            map.insert({keys[i], std::uint64_t(i)});
+        benchmark::DoNotOptimize(map);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// A random batch of present keys reused by every iteration
+template <typename Map>
+void bm_hash_find(benchmark::State& state)
+{
+    const fast_vector<std::uint64_t> keys = make_keys(std::size_t(state.range(0)), 42);
+    const Map map = make_map<Map>(keys);
+
+    std::mt19937_64 rng(7);
+    fast_vector<std::uint64_t> queries(4096);
+    for (auto& query : queries)
+        query = keys[rng() % keys.size()];
+
+    for (auto _ : state)
+    {
+        std::uint64_t sum = 0;
+        for (std::uint64_t key : queries)
+            sum += map.find(key)->second;
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * std::int64_t(queries.size()));
+}
+
+// Keys that are not there, the probing runs until an empty slot or the bucket end
+template <typename Map>
+void bm_hash_find_missing(benchmark::State& state)
+{
+    const Map map = make_map<Map>(make_keys(std::size_t(state.range(0)), 42));
+    const fast_vector<std::uint64_t> queries = make_keys(4096, 7);
+
+    for (auto _ : state)
+    {
+        std::size_t found = 0;
+        for (std::uint64_t key : queries)
+            found += map.count(key);
+        benchmark::DoNotOptimize(found);
+    }
+    state.SetItemsProcessed(state.iterations() * std::int64_t(queries.size()));
+}
+
+// Erasing every key of a full map in random order, the rebuild is not timed
+template <typename Map>
+void bm_hash_erase(benchmark::State& state)
+{
+    const fast_vector<std::uint64_t> keys = make_keys(std::size_t(state.range(0)), 42);
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        Map map = make_map<Map>(keys);
+        state.ResumeTiming();
+
+        for (std::uint64_t key : keys)
+            map.erase(key);
+        benchmark::DoNotOptimize(map);
+
+        state.PauseTiming();
+        map = Map();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+using std_unordered_map = std::unordered_map<std::uint64_t, std::uint64_t>;
+using hash_map = fast_hash_map<std::uint64_t, std::uint64_t>;
+
+BENCHMARK_TEMPLATE(bm_hash_insert, std_unordered_map)->Apply(hash_sizes);
+BENCHMARK_TEMPLATE(bm_hash_insert, hash_map)->Apply(hash_sizes);
+BENCHMARK_TEMPLATE(bm_hash_find, std_unordered_map)->Apply(hash_sizes);
+BENCHMARK_TEMPLATE(bm_hash_find, hash_map)->Apply(hash_sizes);
+BENCHMARK_TEMPLATE(bm_hash_find_missing, std_unordered_map)->Apply(hash_sizes);
+BENCHMARK_TEMPLATE(bm_hash_find_missing, hash_map)->Apply(hash_sizes);
+BENCHMARK_TEMPLATE(bm_hash_erase, std_unordered_map)->Apply(hash_sizes);
+BENCHMARK_TEMPLATE(bm_hash_erase, hash_map)->Apply(hash_sizes);
@@ -0,0 +1,97 @@
+//
+// Construction & resize of large trivial vectors under the initialization policies
+//
+
+#include "bench_common.h"
+
+namespace
+{
+
+// 1 MB and 1 GB of 32 bit elements
+void init_sizes(benchmark::internal::Benchmark* b)
+{
+    b->Arg(std::int64_t(1) << 18)->Arg(std::int64_t(1) << 28);
+}
+
+using element = std::uint32_t;
+
+}
+
+// std::vector always value-initializes, the reference point
+static void bm_construct_std(benchmark::State& state)
+{
+    std::size_t n = state.range(0);
+    for (auto _ : state)
+    {
+        std::vector<element> v(n);
+        benchmark::DoNotOptimize(v.data());
+    }
+    set_processed<element>(state, n);
+}
+
+template <typename Init>
+void bm_construct(benchmark::State& state, Init init)
+{
+    std::size_t n = state.range(0);
+    for (auto _ : state)
+    {
+        fast_vector<element> v(n, init);
+        benchmark::DoNotOptimize(v.data());
+    }
+    set_processed<element>(state, n);
+}
+
+static void bm_resize_std(benchmark::State& state)
+{
+    std::size_t n = state.range(0);
+    for (auto _ : state)
+    {
+        std::vector<element> v;
+        v.resize(n);
+        benchmark::DoNotOptimize(v.data());
+    }
+    set_processed<element>(state, n);
+}
+
+template <typename Init>
+void bm_resize_init(benchmark::State& state, Init init)
+{
+    std::size_t n = state.range(0);
+    for (auto _ : state)
+    {
+        fast_vector<element> v;
+        v.resize(n, init);
+        benchmark::DoNotOptimize(v.data());
+    }
+    set_processed<element>(state, n);
+}
+
+// The untouched zero_init pages are only paid for when written, so every policy
+// is measured again with one pass storing into the buffer
+template <typename Init>
+void bm_construct_write(benchmark::State& state, Init init)
+{
+    std::size_t n = state.range(0);
+    for (auto _ : state)
+    {
+        fast_vector<element> v(n, init);
+        for (std::size_t i = 0; i < n; i++)
+            v[i] = element(i);
+        benchmark::DoNotOptimize(v.data());
+    }
+    set_processed<element>(state, n);
+}
+
+BENCHMARK(bm_construct_std)->Apply(init_sizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(bm_construct, no_init, no_init)->Apply(init_sizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(bm_construct, zero_init, zero_init)->Apply(init_sizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(bm_construct, fill, element(7))->Apply(init_sizes)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(bm_resize_std)->Apply(init_sizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(bm_resize_init, no_init, no_init)->Apply(init_sizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(bm_resize_init, zero_init, zero_init)->Apply(init_sizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(bm_resize_init, fill, element(7))->Apply(init_sizes)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_CAPTURE(bm_construct_write, no_init, no_init)->Apply(init_sizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(bm_construct_write, zero_init, zero_init)->Apply(init_sizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(bm_construct_write, fill, element(7))->Apply(init_sizes)->Unit(benchmark::kMicrosecond);
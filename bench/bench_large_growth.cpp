@@ -0,0 +1,124 @@
+//
+// Growth of very large trivial buffers: copying reallocation vs mremap vs reserved address space
+//
+
+#include "bench_common.h"
+
+#if defined(__linux__)
+
+#include "fast_allocators.h"
+
+#include <chrono>
+
+#ifndef FAST_VECTOR_BENCH_GROWTH_MAX_GB
+#define FAST_VECTOR_BENCH_GROWTH_MAX_GB 32
+#endif
+
+namespace
+{
+
+constexpr std::size_t gigabyte = std::size_t(1) << 30;
+
+// Refuses sizes the kernel will not hand out, instead of dying in the middle of a run
+bool can_map(std::size_t bytes)
+{
+    void* ptr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED)
+        return false;
+    munmap(ptr, bytes);
+    return true;
+}
+
+// Target sizes 2, 4, ... up to FAST_VECTOR_BENCH_GROWTH_MAX_GB
+void growth_targets(benchmark::internal::Benchmark* b)
+{
+    for (std::int64_t gb = 2; gb <= FAST_VECTOR_BENCH_GROWTH_MAX_GB; gb *= 2)
+        b->Arg(gb);
+}
+
+}
+
+/**
+ * Fills 1 GB, then doubles the capacity up to the target. Only the growth is timed.
+ */
+template <typename V>
+void bm_large_growth(benchmark::State& state)
+{
+    using T = typename V::value_type;
+
+    std::size_t target = std::size_t(state.range(0)) * gigabyte;
+    if (!can_map(target))
+    {
+        state.SkipWithError("Address space exhausted, lower FAST_VECTOR_BENCH_GROWTH_MAX_GB");
+        return;
+    }
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto v = std::make_unique<V>();
+        v->resize(gigabyte / sizeof(T));
+        std::memset(v->data(), 1, gigabyte);
+        state.ResumeTiming();
+
+        for (std::size_t bytes = 2 * gigabyte; bytes <= target; bytes *= 2)
+            v->reserve(bytes / sizeof(T));
+        benchmark::DoNotOptimize(v->data());
+
+        state.PauseTiming();
+        v.reset();
+        state.ResumeTiming();
+    }
+}
+
+using mapped_vector = fast_vector<std::uint64_t, false, 16, mmap_allocator<>>;
+
+// std::vector copies 1 GB per doubling, mremap only moves the page tables
+BENCHMARK_TEMPLATE(bm_large_growth, std::vector<std::uint64_t>)->Apply(growth_targets)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_TEMPLATE(bm_large_growth, fast_vector<std::uint64_t>)->Apply(growth_targets)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_TEMPLATE(bm_large_growth, mapped_vector)->Apply(growth_targets)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+/**
+ * push_back timing only the calls that grow the buffer: the relocating policies stall while
+ * the data is copied, the reserved address space only commits more pages.
+ */
+template <typename V>
+void bm_push_back_latency(benchmark::State& state)
+{
+    using clock = std::chrono::steady_clock;
+    std::size_t n = state.range(0);
+    double worst = 0;
+    double total = 0;
+
+    for (auto _ : state)
+    {
+        V v;
+        for (std::size_t i = 0; i < n; i++)
+        {
+            if (v.size() < v.capacity())
+            {
+                v.push_back(i);
+                continue;
+            }
+
+            auto start = clock::now();
+            v.push_back(i);
+            double elapsed = std::chrono::duration<double, std::micro>(clock::now() - start).count();
+
+            total += elapsed;
+            worst = elapsed > worst ? elapsed : worst;
+        }
+        benchmark::DoNotOptimize(v.data());
+    }
+    state.counters["worst_growth_us"] = worst;
+    state.counters["growth_us"] = benchmark::Counter(total, benchmark::Counter::kAvgIterations);
+    set_processed<typename V::value_type>(state, n);
+}
+
+using reserved_vector = fast_vector<std::uint64_t, false, 16, reserved_allocator<>>;
+
+BENCHMARK_TEMPLATE(bm_push_back_latency, std::vector<std::uint64_t>)->Apply(bench_sizes)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(bm_push_back_latency, fast_vector<std::uint64_t>)->Apply(bench_sizes)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(bm_push_back_latency, reserved_vector)->Apply(bench_sizes)->Unit(benchmark::kMillisecond);
+
+#endif // __linux__
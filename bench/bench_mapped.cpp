@@ -0,0 +1,108 @@
+//
+// Start-up of a persistent dataset: reading & pushing the records vs mapping the file
+//
+
+#include "bench_common.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include "fast_mapped_vector.h"
+
+#include <cstdio>
+
+namespace
+{
+
+struct record
+{
+    std::uint64_t id;
+    double value;
+    std::uint32_t flags;
+    std::uint32_t group;
+};
+
+std::string dataset_path(std::size_t n)
+{
+    return "fast_vector_bench_records_" + std::to_string(n) + ".bin";
+}
+
+// Writes the dataset once per size, both loaders read the same file
+void prepare_dataset(std::size_t n)
+{
+    fast_mapped_vector<record> file;
+    if (file.open(dataset_path(n).c_str(), fast_mapped_vector<record>::mode::read_only) && file.size() == n)
+        return;
+
+    file.create(dataset_path(n).c_str(), n);
+    for (std::size_t i = 0; i < n; i++)
+        file.push_back({i, double(i) * 0.5, std::uint32_t(i), std::uint32_t(i % 16)});
+    file.sync();
+}
+
+}
+
+// The former start-up: read the file record by record into a vector
+static void bm_load_push(benchmark::State& state)
+{
+    std::size_t n = state.range(0);
+    prepare_dataset(n);
+
+    for (auto _ : state)
+    {
+        fast_vector<record> records;
+        std::FILE* in = std::fopen(dataset_path(n).c_str(), "rb");
+
+        mapped_vector_header header;
+        if (std::fread(&header, sizeof(header), 1, in) == 1 &&
+            std::fseek(in, long(header.data_offset), SEEK_SET) == 0)
+        {
+            record item;
+            while (records.size() < header.size && std::fread(&item, sizeof(item), 1, in) == 1)
+                records.push_back(item);
+        }
+        std::fclose(in);
+
+        benchmark::DoNotOptimize(records.data());
+    }
+    set_processed<record>(state, n);
+}
+
+// Zero-copy start-up, the pages come in on first touch
+static void bm_load_mapped(benchmark::State& state)
+{
+    std::size_t n = state.range(0);
+    prepare_dataset(n);
+
+    for (auto _ : state)
+    {
+        fast_mapped_vector<record> records;
+        records.open(dataset_path(n).c_str(), fast_mapped_vector<record>::mode::read_only);
+        benchmark::DoNotOptimize(records.data());
+    }
+    set_processed<record>(state, n);
+}
+
+// Mapping plus one pass over every record, the fair comparison when all the data is needed
+static void bm_load_mapped_scan(benchmark::State& state)
+{
+    std::size_t n = state.range(0);
+    prepare_dataset(n);
+
+    for (auto _ : state)
+    {
+        fast_mapped_vector<record> records;
+        records.open(dataset_path(n).c_str(), fast_mapped_vector<record>::mode::read_only);
+
+        std::uint64_t sum = 0;
+        for (const record& item : records)
+            sum += item.id;
+        benchmark::DoNotOptimize(sum);
+    }
+    set_processed<record>(state, n);
+}
+
+BENCHMARK(bm_load_push)->Apply(bench_sizes_nontrivial);
+BENCHMARK(bm_load_mapped)->Apply(bench_sizes_nontrivial);
+BENCHMARK(bm_load_mapped_scan)->Apply(bench_sizes_nontrivial);
+
+#endif // __unix__ || __APPLE__
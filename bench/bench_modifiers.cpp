@@ -0,0 +1,310 @@
+//
+// Positional modifiers, compaction and lookup against std::vector
+//
+
+#include "bench_common.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+
+// insert() at the front, in the middle and of a whole range
+
+template <typename V>
+void bm_insert_middle(benchmark::State& state)
+{
+    using T = typename V::value_type;
+    std::size_t n = state.range(0);
+    value_source<T> values(n);
+
+    for (auto _ : state)
+    {
+        V v;
+        for (std::size_t i = 0; i < n; i++)
+            v.insert(v.begin() + v.size() / 2, values[i]);
+        benchmark::DoNotOptimize(v.data());
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename V>
+void bm_insert_front(benchmark::State& state)
+{
+    using T = typename V::value_type;
+    std::size_t n = state.range(0);
+    value_source<T> values(n);
+
+    for (auto _ : state)
+    {
+        V v;
+        for (std::size_t i = 0; i < n; i++)
+            v.insert(v.begin(), values[i]);
+        benchmark::DoNotOptimize(v.data());
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename V>
+void bm_insert_range(benchmark::State& state)
+{
+    using T = typename V::value_type;
+    std::size_t n = state.range(0);
+
+    std::vector<T> chunk;
+    for (std::size_t i = 0; i < 256; i++)
+        chunk.push_back(make_value<T>(i));
+
+    for (auto _ : state)
+    {
+        V v;
+        for (std::size_t i = 0; i < n; i += chunk.size())
+            v.insert(v.begin() + v.size() / 2, chunk.data(), chunk.data() + chunk.size());
+        benchmark::DoNotOptimize(v.data());
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename V>
+void bm_erase_range(benchmark::State& state)
+{
+    using T = typename V::value_type;
+    std::size_t n = state.range(0);
+    value_source<T> values(n);
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        V v;
+        for (std::size_t i = 0; i < n; i++)
+            v.push_back(values[i]);
+        state.ResumeTiming();
+
+        // Remove a tenth from the middle, ten times
+        std::size_t chunk = n / 10 ? n / 10 : 1;
+        while (v.size() >= chunk)
+            v.erase(v.begin() + (v.size() - chunk) / 2, v.begin() + (v.size() - chunk) / 2 + chunk);
+        benchmark::DoNotOptimize(v.data());
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+BENCHMARK_TEMPLATE(bm_insert_middle, std::vector<int>)->Arg(1000)->Arg(10000)->Arg(100000);
+BENCHMARK_TEMPLATE(bm_insert_middle, fast_vector<int>)->Arg(1000)->Arg(10000)->Arg(100000);
+BENCHMARK_TEMPLATE(bm_insert_middle, std::vector<std::string>)->Arg(1000)->Arg(10000);
+BENCHMARK_TEMPLATE(bm_insert_middle, fast_vector<std::string>)->Arg(1000)->Arg(10000);
+BENCHMARK_TEMPLATE(bm_insert_front, std::vector<int>)->Arg(1000)->Arg(10000)->Arg(100000);
+BENCHMARK_TEMPLATE(bm_insert_front, fast_vector<int>)->Arg(1000)->Arg(10000)->Arg(100000);
+BENCHMARK_TEMPLATE(bm_insert_range, std::vector<int>)->Apply(bench_sizes);
+BENCHMARK_TEMPLATE(bm_insert_range, fast_vector<int>)->Apply(bench_sizes);
+BENCHMARK_TEMPLATE(bm_insert_range, std::vector<std::string>)->Arg(10000)->Arg(100000);
+BENCHMARK_TEMPLATE(bm_insert_range, fast_vector<std::string>)->Arg(10000)->Arg(100000);
+BENCHMARK_TEMPLATE(bm_erase_range, std::vector<int>)->Apply(bench_sizes);
+BENCHMARK_TEMPLATE(bm_erase_range, fast_vector<int>)->Apply(bench_sizes);
+BENCHMARK_TEMPLATE(bm_erase_range, std::vector<std::string>)->Apply(bench_sizes_nontrivial);
+BENCHMARK_TEMPLATE(bm_erase_range, fast_vector<std::string>)->Apply(bench_sizes_nontrivial);
+
+// erase(value) removing one element at a time from the front half
+
+template <typename V>
+void bm_erase_value(benchmark::State& state)
+{
+    using T = typename V::value_type;
+    std::size_t n = state.range(0);
+    value_source<T> values(n);
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        V v;
+        for (std::size_t i = 0; i < n; i++)
+            v.push_back(values[i]);
+        state.ResumeTiming();
+
+        for (std::size_t i = 0; i < n / 2; i++)
+        {
+            if constexpr (is_std_vector<V>::value)
+                v.erase(std::find(v.begin(), v.end(), values[i]));
+            else
+                v.erase(values[i]);
+        }
+        benchmark::DoNotOptimize(v.data());
+    }
+    state.SetItemsProcessed(state.iterations() * (n / 2));
+}
+
+BENCHMARK_TEMPLATE(bm_erase_value, std::vector<int>)->Arg(1000)->Arg(10000);
+BENCHMARK_TEMPLATE(bm_erase_value, fast_vector<int>)->Arg(1000)->Arg(10000);
+BENCHMARK_TEMPLATE(bm_erase_value, std::vector<std::string>)->Arg(1000)->Arg(10000);
+BENCHMARK_TEMPLATE(bm_erase_value, fast_vector<std::string>)->Arg(1000)->Arg(10000);
+
+// erase_all() of 1%, 50% and 99% of a 10M element vector
+
+constexpr std::size_t compaction_size = 10000000;
+
+template <typename T>
+std::vector<T> compaction_input(std::size_t percent)
+{
+    std::mt19937 random(7);
+    std::vector<T> input(compaction_size);
+    for (auto& item : input)
+        item = random() % 100 < percent ? T(0) : T(1 + random() % 1000);
+    return input;
+}
+
+template <typename T>
+void bm_compact_std(benchmark::State& state)
+{
+    std::vector<T> input = compaction_input<T>(state.range(0));
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        std::vector<T> v(input);
+        state.ResumeTiming();
+
+        v.erase(std::remove(v.begin(), v.end(), T(0)), v.end());
+        benchmark::DoNotOptimize(v.data());
+    }
+    set_processed<T>(state, compaction_size);
+}
+
+template <typename T>
+void bm_compact_fast(benchmark::State& state)
+{
+    std::vector<T> input = compaction_input<T>(state.range(0));
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        fast_vector<T> v(input.data(), input.data() + input.size());
+        state.ResumeTiming();
+
+        v.erase_all(T(0));
+        benchmark::DoNotOptimize(v.data());
+    }
+    set_processed<T>(state, compaction_size);
+}
+
+template <typename T>
+void bm_compact_fast_if(benchmark::State& state)
+{
+    std::vector<T> input = compaction_input<T>(state.range(0));
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        fast_vector<T> v(input.data(), input.data() + input.size());
+        state.ResumeTiming();
+
+        v.erase_if([](T item) { return item == T(0); });
+        benchmark::DoNotOptimize(v.data());
+    }
+    set_processed<T>(state, compaction_size);
+}
+
+BENCHMARK_TEMPLATE(bm_compact_std, std::uint32_t)->Arg(1)->Arg(50)->Arg(99);
+BENCHMARK_TEMPLATE(bm_compact_fast, std::uint32_t)->Arg(1)->Arg(50)->Arg(99);
+BENCHMARK_TEMPLATE(bm_compact_fast_if, std::uint32_t)->Arg(1)->Arg(50)->Arg(99);
+BENCHMARK_TEMPLATE(bm_compact_std, float)->Arg(1)->Arg(50)->Arg(99);
+BENCHMARK_TEMPLATE(bm_compact_fast, float)->Arg(1)->Arg(50)->Arg(99);
+
+// find()/contains() with the hit early, hit late and miss cases
+
+enum search_case
+{
+    hit_early,
+    hit_late,
+    miss
+};
+
+template <typename T>
+T search_target(std::size_t n, search_case which)
+{
+    switch (which)
+    {
+    case hit_early:
+        return make_value<T>(n / 100);
+    case hit_late:
+        return make_value<T>(n - n / 100 - 1);
+    default:
+        return make_value<T>(n + 1);
+    }
+}
+
+template <typename T>
+void bm_find_std(benchmark::State& state)
+{
+    std::size_t n = state.range(0);
+    std::vector<T> v;
+    for (std::size_t i = 0; i < n; i++)
+        v.push_back(make_value<T>(i));
+
+    T target = search_target<T>(n, search_case(state.range(1)));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(std::find(v.begin(), v.end(), target));
+    }
+    set_processed<T>(state, n);
+}
+
+template <typename T>
+void bm_find_fast(benchmark::State& state)
+{
+    std::size_t n = state.range(0);
+    fast_vector<T> v;
+    for (std::size_t i = 0; i < n; i++)
+        v.push_back(make_value<T>(i));
+
+    T target = search_target<T>(n, search_case(state.range(1)));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(v.find(target));
+    }
+    set_processed<T>(state, n);
+}
+
+template <typename T>
+void bm_count_fast(benchmark::State& state)
+{
+    std::size_t n = state.range(0);
+    fast_vector<T> v;
+    for (std::size_t i = 0; i < n; i++)
+        v.push_back(make_value<T>(i % 64));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(v.count(make_value<T>(7)));
+    }
+    set_processed<T>(state, n);
+}
+
+template <typename T>
+void bm_count_std(benchmark::State& state)
+{
+    std::size_t n = state.range(0);
+    std::vector<T> v;
+    for (std::size_t i = 0; i < n; i++)
+        v.push_back(make_value<T>(i % 64));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(std::count(v.begin(), v.end(), make_value<T>(7)));
+    }
+    set_processed<T>(state, n);
+}
+
+static void search_args(benchmark::internal::Benchmark* b)
+{
+    for (std::int64_t n : {1000, 100000, 10000000})
+        for (std::int64_t which : {hit_early, hit_late, miss})
+            b->Args({n, which});
+}
+
+BENCHMARK_TEMPLATE(bm_find_std, std::uint32_t)->Apply(search_args);
+BENCHMARK_TEMPLATE(bm_find_fast, std::uint32_t)->Apply(search_args);
+BENCHMARK_TEMPLATE(bm_find_std, float)->Apply(search_args);
+BENCHMARK_TEMPLATE(bm_find_fast, float)->Apply(search_args);
+BENCHMARK_TEMPLATE(bm_count_std, std::uint32_t)->Arg(1000)->Arg(100000)->Arg(10000000);
+BENCHMARK_TEMPLATE(bm_count_fast, std::uint32_t)->Arg(1000)->Arg(100000)->Arg(10000000);
@@ -0,0 +1,157 @@
+//
+// Bit packed integers: packed_int_vector vs fast_vector<uint32_t>
+//
+
+#include "bench_common.h"
+
+#include "fast_packed_vector.h"
+
+#include <random>
+
+namespace
+{
+
+fast_vector<std::uint32_t> make_values(std::size_t n, unsigned bits)
+{
+    std::mt19937_64 rng(42);
+    fast_vector<std::uint32_t> values(n);
+    for (auto& value : values)
+        value = std::uint32_t(rng()) & std::uint32_t((std::uint64_t(1) << bits) - 1);
+    return values;
+}
+
+std::size_t footprint(const dynamic_packed_int_vector<>& packed)
+{
+    return packed.words().size() * sizeof(std::uint64_t);
+}
+
+// Element counts 1000 ... FAST_VECTOR_BENCH_MAX_SIZE times the 5, 12 and 20 bit widths
+void packed_args(benchmark::internal::Benchmark* b)
+{
+    for (std::int64_t n = 1000; n <= FAST_VECTOR_BENCH_MAX_SIZE; n *= 10)
+    {
+        for (std::int64_t bits : {5, 12, 20})
+            b->Args({n, bits});
+    }
+}
+
+void packed_sizes(benchmark::internal::Benchmark* b)
+{
+    for (std::int64_t n = 1000; n <= FAST_VECTOR_BENCH_MAX_SIZE; n *= 10)
+        b->Arg(n);
+}
+
+}
+
+// The unpacked baseline: copying the 32 bit values
+void bm_u32_copy(benchmark::State& state)
+{
+    const fast_vector<std::uint32_t> values = make_values(std::size_t(state.range(0)), 32);
+    fast_vector<std::uint32_t> out(values.size(), no_init);
+
+    for (auto _ : state)
+    {
+        std::memcpy(out.data(), values.data(), values.size() * sizeof(std::uint32_t));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["footprint"] = double(values.size() * sizeof(std::uint32_t));
+}
+
+// Decoding everything, through the BMI2 kernels where the CPU has them
+void bm_packed_unpack(benchmark::State& state)
+{
+    const unsigned bits = unsigned(state.range(1));
+    dynamic_packed_int_vector<> packed(bits);
+    packed.pack_from(make_values(std::size_t(state.range(0)), bits));
+    fast_vector<std::uint32_t> out(packed.size(), no_init);
+
+    for (auto _ : state)
+    {
+        packed.unpack_to(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["footprint"] = double(footprint(packed));
+}
+
+// The same decoding by shifts and masks
+void bm_packed_unpack_scalar(benchmark::State& state)
+{
+    const unsigned bits = unsigned(state.range(1));
+    dynamic_packed_int_vector<> packed(bits);
+    packed.pack_from(make_values(std::size_t(state.range(0)), bits));
+    fast_vector<std::uint32_t> out(packed.size(), no_init);
+
+    for (auto _ : state)
+    {
+        packed_unpack_scalar(packed.words().data(), out.data(), packed.size(), bits);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void bm_packed_pack(benchmark::State& state)
+{
+    const unsigned bits = unsigned(state.range(1));
+    const fast_vector<std::uint32_t> values = make_values(std::size_t(state.range(0)), bits);
+    dynamic_packed_int_vector<> packed(bits);
+
+    for (auto _ : state)
+    {
+        packed.pack_from(values);
+        benchmark::DoNotOptimize(packed);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Random get() with the width known at compile time, against plain indexing
+template <unsigned Bits>
+void bm_packed_get(benchmark::State& state)
+{
+    const fast_vector<std::uint32_t> values = make_values(std::size_t(state.range(0)), Bits);
+    packed_int_vector<Bits> packed;
+    packed.pack_from(values);
+
+    std::mt19937_64 rng(7);
+    fast_vector<std::uint32_t> positions(4096);
+    for (auto& position : positions)
+        position = std::uint32_t(rng() % values.size());
+
+    for (auto _ : state)
+    {
+        std::uint64_t sum = 0;
+        for (std::uint32_t position : positions)
+            sum += packed[position];
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * std::int64_t(positions.size()));
+}
+
+void bm_u32_get(benchmark::State& state)
+{
+    const fast_vector<std::uint32_t> values = make_values(std::size_t(state.range(0)), 32);
+
+    std::mt19937_64 rng(7);
+    fast_vector<std::uint32_t> positions(4096);
+    for (auto& position : positions)
+        position = std::uint32_t(rng() % values.size());
+
+    for (auto _ : state)
+    {
+        std::uint64_t sum = 0;
+        for (std::uint32_t position : positions)
+            sum += values[position];
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * std::int64_t(positions.size()));
+}
+
+BENCHMARK(bm_u32_copy)->Apply(packed_sizes);
+BENCHMARK(bm_packed_unpack)->Apply(packed_args);
+BENCHMARK(bm_packed_unpack_scalar)->Apply(packed_args);
+BENCHMARK(bm_packed_pack)->Apply(packed_args);
+BENCHMARK(bm_u32_get)->Apply(packed_sizes);
+BENCHMARK_TEMPLATE(bm_packed_get, 5)->Apply(packed_sizes);
+BENCHMARK_TEMPLATE(bm_packed_get, 12)->Apply(packed_sizes);
+BENCHMARK_TEMPLATE(bm_packed_get, 20)->Apply(packed_sizes);
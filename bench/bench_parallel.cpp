@@ -0,0 +1,82 @@
+//
+// Strong scaling of the parallel algorithms: a fixed FAST_VECTOR_BENCH_MAX_SIZE vector, 1 to all cores
+//
+
+#include "bench_common.h"
+
+#include "fast_parallel.h"
+
+#include <cmath>
+
+namespace
+{
+
+// Thread counts 1, 2, 4, ... and the hardware concurrency itself
+void thread_counts(benchmark::internal::Benchmark* b)
+{
+    std::int64_t cores = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+
+    for (std::int64_t threads = 1; threads < cores; threads *= 2)
+        b->Arg(threads);
+    b->Arg(cores);
+}
+
+}
+
+void bm_parallel_fill(benchmark::State& state)
+{
+    fast_thread_pool pool(state.range(0));
+    fast_vector<float> v(FAST_VECTOR_BENCH_MAX_SIZE);
+
+    for (auto _ : state)
+    {
+        parallel_fill(v, 1.0f, parallel_default_grain, pool);
+        benchmark::DoNotOptimize(v.data());
+    }
+    set_processed<float>(state, v.size());
+}
+
+void bm_parallel_transform(benchmark::State& state)
+{
+    fast_thread_pool pool(state.range(0));
+    fast_vector<float> in(FAST_VECTOR_BENCH_MAX_SIZE, 2.0f);
+    fast_vector<float> out(in.size());
+
+    for (auto _ : state)
+    {
+        parallel_transform(in, out, [](float x) { return std::sqrt(x) * 0.5f + 1.0f; }, parallel_default_grain, pool);
+        benchmark::DoNotOptimize(out.data());
+    }
+    set_processed<float>(state, in.size());
+}
+
+void bm_parallel_reduce(benchmark::State& state)
+{
+    fast_thread_pool pool(state.range(0));
+    fast_vector<std::uint64_t> v(FAST_VECTOR_BENCH_MAX_SIZE, std::uint64_t(3));
+
+    for (auto _ : state)
+    {
+        auto sum = parallel_reduce(v, std::uint64_t(0), [](std::uint64_t a, std::uint64_t b) { return a + b; }, parallel_default_grain, pool);
+        benchmark::DoNotOptimize(sum);
+    }
+    set_processed<std::uint64_t>(state, v.size());
+}
+
+void bm_parallel_count(benchmark::State& state)
+{
+    fast_thread_pool pool(state.range(0));
+    fast_vector<int> v(FAST_VECTOR_BENCH_MAX_SIZE, 1);
+
+    for (auto _ : state)
+    {
+        auto count = parallel_count(v, 2, parallel_default_grain, pool);
+        benchmark::DoNotOptimize(count);
+    }
+    set_processed<int>(state, v.size());
+}
+
+BENCHMARK(bm_parallel_fill)->Apply(thread_counts)->UseRealTime();
+BENCHMARK(bm_parallel_transform)->Apply(thread_counts)->UseRealTime();
+BENCHMARK(bm_parallel_reduce)->Apply(thread_counts)->UseRealTime();
+BENCHMARK(bm_parallel_count)->Apply(thread_counts)->UseRealTime();
@@ -0,0 +1,126 @@
+//
+// Producers writing batches into the tail of a vector: temporary + append vs resize vs
+// append_uninitialized, and read(2) into a byte vector
+//
+
+#include "bench_common.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include "fast_vector_io.h"
+
+#include <fcntl.h>
+#endif
+
+namespace
+{
+
+constexpr std::size_t batch = 4096;
+
+// Stands in for a decoder writing a batch of samples
+inline void decode(float* out, std::size_t count, std::size_t seed)
+{
+    for (std::size_t i = 0; i < count; i++)
+        out[i] = float(seed + i) * 0.5f;
+}
+
+}
+
+static void bm_produce_append(benchmark::State& state)
+{
+    std::size_t n = state.range(0);
+    float scratch[batch];
+
+    for (auto _ : state)
+    {
+        fast_vector<float> v;
+        for (std::size_t done = 0; done < n; done += batch)
+        {
+            decode(scratch, batch, done);
+            v.append(scratch, batch);
+        }
+        benchmark::DoNotOptimize(v.data());
+    }
+    set_processed<float>(state, n);
+}
+
+static void bm_produce_resize(benchmark::State& state)
+{
+    std::size_t n = state.range(0);
+
+    for (auto _ : state)
+    {
+        std::vector<float> v;
+        for (std::size_t done = 0; done < n; done += batch)
+        {
+            v.resize(done + batch);
+            decode(v.data() + done, batch, done);
+        }
+        benchmark::DoNotOptimize(v.data());
+    }
+    set_processed<float>(state, n);
+}
+
+static void bm_produce_uninitialized(benchmark::State& state)
+{
+    std::size_t n = state.range(0);
+
+    for (auto _ : state)
+    {
+        fast_vector<float> v;
+        for (std::size_t done = 0; done < n; done += batch)
+        {
+            auto tail = v.append_uninitialized(batch);
+            decode(tail.data(), batch, done);
+        }
+        benchmark::DoNotOptimize(v.data());
+    }
+    set_processed<float>(state, n);
+}
+
+BENCHMARK(bm_produce_append)->RangeMultiplier(16)->Range(batch, std::int64_t(batch) << 12);
+BENCHMARK(bm_produce_resize)->RangeMultiplier(16)->Range(batch, std::int64_t(batch) << 12);
+BENCHMARK(bm_produce_uninitialized)->RangeMultiplier(16)->Range(batch, std::int64_t(batch) << 12);
+
+#if defined(__unix__) || defined(__APPLE__)
+
+// Reading /dev/zero: the kernel fills the buffer, the copy through a stack buffer is the difference
+static void bm_read_append(benchmark::State& state)
+{
+    std::size_t n = state.range(0);
+    int fd = open("/dev/zero", O_RDONLY);
+    char scratch[64 * 1024];
+
+    for (auto _ : state)
+    {
+        fast_vector<char> v;
+        while (v.size() < n)
+        {
+            ssize_t received = read(fd, scratch, sizeof(scratch));
+            v.append(scratch, std::size_t(received));
+        }
+        benchmark::DoNotOptimize(v.data());
+    }
+    close(fd);
+    set_processed<char>(state, n);
+}
+
+static void bm_read_uninitialized(benchmark::State& state)
+{
+    std::size_t n = state.range(0);
+    int fd = open("/dev/zero", O_RDONLY);
+
+    for (auto _ : state)
+    {
+        fast_vector<char> v;
+        while (v.size() < n)
+            append_read(v, fd, 64 * 1024);
+        benchmark::DoNotOptimize(v.data());
+    }
+    close(fd);
+    set_processed<char>(state, n);
+}
+
+BENCHMARK(bm_read_append)->Arg(1 << 20)->Arg(64 << 20);
+BENCHMARK(bm_read_uninitialized)->Arg(1 << 20)->Arg(64 << 20);
+
+#endif
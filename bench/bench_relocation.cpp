@@ -0,0 +1,79 @@
+//
+// Growth of non-trivial element types: relocation and move based reallocation
+//
+
+#include "bench_common.h"
+
+#include <memory>
+
+// A string whose move constructor may throw, forcing the old copy based reallocation
+struct copied_string : std::string
+{
+    using std::string::string;
+
+    copied_string(const std::string& other) : std::string(other) {}
+    copied_string(const copied_string& other) = default;
+    copied_string(copied_string&& other) noexcept(false) : std::string(std::move(other)) {}
+    copied_string& operator=(const copied_string& other) = default;
+};
+
+template <typename V, typename Make>
+void grow(benchmark::State& state, Make make)
+{
+    std::size_t n = state.range(0);
+
+    for (auto _ : state)
+    {
+        V v;
+        for (std::size_t i = 0; i < n; i++)
+            v.push_back(make(i));
+        benchmark::DoNotOptimize(v.data());
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename V>
+void bm_grow_unique_ptr(benchmark::State& state)
+{
+    grow<V>(state, [](std::size_t i) { return std::make_unique<std::size_t>(i); });
+}
+
+template <typename V>
+void bm_grow_string(benchmark::State& state)
+{
+    using T = typename V::value_type;
+    grow<V>(state, [](std::size_t i) { return T(make_value<std::string>(i)); });
+}
+
+// Relocatable types take the realloc path
+BENCHMARK_TEMPLATE(bm_grow_unique_ptr, std::vector<std::unique_ptr<std::size_t>>)->Apply(bench_sizes_nontrivial);
+BENCHMARK_TEMPLATE(bm_grow_unique_ptr, fast_vector<std::unique_ptr<std::size_t>>)->Apply(bench_sizes_nontrivial);
+
+// std::string is moved element by element, copied_string shows the former copy based growth
+BENCHMARK_TEMPLATE(bm_grow_string, std::vector<std::string>)->Arg(10000)->Arg(1000000);
+BENCHMARK_TEMPLATE(bm_grow_string, fast_vector<std::string>)->Arg(10000)->Arg(1000000);
+BENCHMARK_TEMPLATE(bm_grow_string, fast_vector<copied_string>)->Arg(10000)->Arg(1000000);
+
+template <typename V>
+void bm_shrink_string(benchmark::State& state)
+{
+    using T = typename V::value_type;
+    std::size_t n = state.range(0);
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        V v;
+        v.reserve(2 * n);
+        for (std::size_t i = 0; i < n; i++)
+            v.push_back(T(make_value<std::string>(i)));
+        state.ResumeTiming();
+
+        v.shrink_to_fit();
+        benchmark::DoNotOptimize(v.data());
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+BENCHMARK_TEMPLATE(bm_shrink_string, fast_vector<std::string>)->Arg(10000)->Arg(1000000);
+BENCHMARK_TEMPLATE(bm_shrink_string, fast_vector<copied_string>)->Arg(10000)->Arg(1000000);
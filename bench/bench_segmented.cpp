@@ -0,0 +1,155 @@
+//
+// Chunked storage: appends that never relocate vs the single block of the fast_vector
+//
+
+#include "bench_common.h"
+
+#include "fast_segmented_vector.h"
+
+#include <chrono>
+
+using segmented_vector = fast_segmented_vector<std::uint64_t>;
+
+template <typename V>
+void bm_segmented_push_back(benchmark::State& state)
+{
+    using T = typename V::value_type;
+    std::size_t n = state.range(0);
+
+    for (auto _ : state)
+    {
+        V v;
+        for (std::size_t i = 0; i < n; i++)
+            v.push_back(T(i));
+        benchmark::DoNotOptimize(&v.back());
+    }
+    set_processed<T>(state, n);
+}
+
+BENCHMARK_TEMPLATE(bm_segmented_push_back, fast_vector<std::uint64_t>)->Apply(bench_sizes);
+BENCHMARK_TEMPLATE(bm_segmented_push_back, segmented_vector)->Apply(bench_sizes);
+
+// Bulk appends of 1024 elements, the segmented vector copies them chunk by chunk
+template <typename V>
+void bm_segmented_append(benchmark::State& state)
+{
+    using T = typename V::value_type;
+    constexpr std::size_t batch = 1024;
+    std::size_t n = state.range(0);
+
+    std::vector<T> source(batch);
+    for (std::size_t i = 0; i < batch; i++)
+        source[i] = T(i);
+
+    for (auto _ : state)
+    {
+        V v;
+        for (std::size_t i = 0; i < n; i += batch)
+            v.append(source.data(), batch);
+        benchmark::DoNotOptimize(&v.back());
+    }
+    set_processed<T>(state, (n + batch - 1) / batch * batch);
+}
+
+BENCHMARK_TEMPLATE(bm_segmented_append, fast_vector<std::uint64_t>)->Apply(bench_sizes);
+BENCHMARK_TEMPLATE(bm_segmented_append, segmented_vector)->Apply(bench_sizes);
+
+/**
+ * push_back timing only the calls that allocate: the fast_vector copies everything appended
+ * so far, the segmented vector allocates one more chunk.
+ */
+template <typename V>
+void bm_segmented_push_back_latency(benchmark::State& state)
+{
+    using clock = std::chrono::steady_clock;
+    using T = typename V::value_type;
+    std::size_t n = state.range(0);
+    double worst = 0;
+    double total = 0;
+
+    for (auto _ : state)
+    {
+        V v;
+        for (std::size_t i = 0; i < n; i++)
+        {
+            if (v.size() < v.capacity())
+            {
+                v.push_back(T(i));
+                continue;
+            }
+
+            auto start = clock::now();
+            v.push_back(T(i));
+            double elapsed = std::chrono::duration<double, std::micro>(clock::now() - start).count();
+
+            total += elapsed;
+            worst = elapsed > worst ? elapsed : worst;
+        }
+        benchmark::DoNotOptimize(&v.back());
+    }
+    state.counters["worst_growth_us"] = worst;
+    state.counters["growth_us"] = benchmark::Counter(total, benchmark::Counter::kAvgIterations);
+    set_processed<T>(state, n);
+}
+
+BENCHMARK_TEMPLATE(bm_segmented_push_back_latency, fast_vector<std::uint64_t>)->Apply(bench_sizes)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(bm_segmented_push_back_latency, segmented_vector)->Apply(bench_sizes)->Unit(benchmark::kMillisecond);
+
+/**
+ * Summing every element: one contiguous loop, indexing through the directory and the per-chunk loops.
+ */
+void bm_segmented_sum_contiguous(benchmark::State& state)
+{
+    std::size_t n = state.range(0);
+    fast_vector<std::uint64_t> v(n, std::uint64_t(0));
+
+    for (auto _ : state)
+    {
+        std::uint64_t sum = 0;
+        for (std::uint64_t item : v)
+            sum += item;
+        benchmark::DoNotOptimize(sum);
+    }
+    set_processed<std::uint64_t>(state, n);
+}
+
+void bm_segmented_sum_indexed(benchmark::State& state)
+{
+    std::size_t n = state.range(0);
+    segmented_vector v;
+    for (std::size_t i = 0; i < n; i++)
+        v.push_back(0);
+
+    for (auto _ : state)
+    {
+        std::uint64_t sum = 0;
+        for (std::size_t i = 0; i < n; i++)
+            sum += v[i];
+        benchmark::DoNotOptimize(sum);
+    }
+    set_processed<std::uint64_t>(state, n);
+}
+
+void bm_segmented_sum_chunks(benchmark::State& state)
+{
+    std::size_t n = state.range(0);
+    segmented_vector v;
+    for (std::size_t i = 0; i < n; i++)
+        v.push_back(0);
+
+    for (auto _ : state)
+    {
+        std::uint64_t sum = 0;
+        v.for_each_chunk([&sum](fast_span<std::uint64_t> items)
+        {
+            for (std::uint64_t item : items)
+                sum += item;
+        });
+        benchmark::DoNotOptimize(sum);
+    }
+    set_processed<std::uint64_t>(state, n);
+}
+
+BENCHMARK(bm_segmented_sum_contiguous)->Apply(bench_sizes);
+BENCHMARK(bm_segmented_sum_indexed)->Apply(bench_sizes);
+BENCHMARK(bm_segmented_sum_chunks)->Apply(bench_sizes);
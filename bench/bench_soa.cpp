@@ -0,0 +1,108 @@
+//
+// Field scans over records: array of structs fast_vector vs the soa_vector columns
+//
+
+#include "bench_common.h"
+
+#include "fast_soa_vector.h"
+
+namespace
+{
+
+struct particle
+{
+    float x, y, z;
+    float vx, vy, vz;
+    float mass;
+    std::uint32_t id;
+};
+
+using particle_columns = soa_vector<float, float, float, float, float, float, float, std::uint32_t>;
+
+fast_vector<particle> make_particles(std::size_t n)
+{
+    fast_vector<particle> particles;
+    particles.reserve(n);
+    for (std::size_t i = 0; i < n; i++)
+        particles.push_back({float(i), 1, 2, 0.5f, 0, 0, 1, std::uint32_t(i)});
+    return particles;
+}
+
+particle_columns make_particle_columns(std::size_t n)
+{
+    particle_columns particles;
+    particles.reserve(n);
+    for (std::size_t i = 0; i < n; i++)
+        particles.emplace_back(float(i), 1.0f, 2.0f, 0.5f, 0.0f, 0.0f, 1.0f, std::uint32_t(i));
+    return particles;
+}
+
+}
+
+// Reads one field, the structs drag the other seven through the cache
+void bm_soa_sum_aos(benchmark::State& state)
+{
+    std::size_t n = state.range(0);
+    auto particles = make_particles(n);
+
+    for (auto _ : state)
+    {
+        std::uint32_t sum = 0;
+        for (const particle& item : particles)
+            sum += item.id;
+        benchmark::DoNotOptimize(sum);
+    }
+    set_processed<std::uint32_t>(state, n);
+}
+
+void bm_soa_sum_columns(benchmark::State& state)
+{
+    std::size_t n = state.range(0);
+    auto particles = make_particle_columns(n);
+
+    for (auto _ : state)
+    {
+        std::uint32_t sum = 0;
+        for (std::uint32_t id : particles.column<7>())
+            sum += id;
+        benchmark::DoNotOptimize(sum);
+    }
+    set_processed<std::uint32_t>(state, n);
+}
+
+BENCHMARK(bm_soa_sum_aos)->Apply(bench_sizes);
+BENCHMARK(bm_soa_sum_columns)->Apply(bench_sizes);
+
+// Updates one field from another: x += vx
+void bm_soa_update_aos(benchmark::State& state)
+{
+    std::size_t n = state.range(0);
+    auto particles = make_particles(n);
+
+    for (auto _ : state)
+    {
+        for (particle& item : particles)
+            item.x += item.vx;
+        benchmark::DoNotOptimize(particles.data());
+    }
+    set_processed<float>(state, 2 * n);
+}
+
+void bm_soa_update_columns(benchmark::State& state)
+{
+    std::size_t n = state.range(0);
+    auto particles = make_particle_columns(n);
+
+    for (auto _ : state)
+    {
+        float* x = particles.data<0>();
+        const float* vx = particles.data<3>();
+        for (std::size_t i = 0; i < n; i++)
+            x[i] += vx[i];
+        benchmark::DoNotOptimize(x);
+    }
+    set_processed<float>(state, 2 * n);
+}
+
+BENCHMARK(bm_soa_update_aos)->Apply(bench_sizes);
+BENCHMARK(bm_soa_update_columns)->Apply(bench_sizes);
@@ -0,0 +1,165 @@
+//
+// std::sort over the raw storage vs the fast_vector sort members, on uniform, sorted and skewed keys
+//
+
+#include "bench_common.h"
+
+#include "fast_parallel.h"
+
+#include <algorithm>
+#include <random>
+#include <utility>
+
+namespace
+{
+
+using record = std::pair<std::uint32_t, std::uint32_t>;
+
+enum distribution
+{
+    uniform,
+    sorted,
+    skewed
+};
+
+const char* const distribution_names[] = {"uniform", "sorted", "skewed"};
+
+// Skewed: exponentially distributed magnitudes, most keys are small and many repeat
+std::uint64_t make_key(distribution dist, std::size_t i, std::mt19937_64& rng)
+{
+    switch (dist)
+    {
+    case uniform:
+        return rng();
+    case sorted:
+        return i;
+    default:
+        return rng() >> (rng() % 64);
+    }
+}
+
+template <typename T>
+T make_sort_value(std::uint64_t key);
+
+template <>
+std::uint64_t make_sort_value<std::uint64_t>(std::uint64_t key)
+{
+    return key;
+}
+
+template <>
+record make_sort_value<record>(std::uint64_t key)
+{
+    return record(std::uint32_t(key >> 32), std::uint32_t(key));
+}
+
+template <typename T>
+fast_vector<T> make_input(benchmark::State& state)
+{
+    const distribution dist = distribution(state.range(1));
+    std::mt19937_64 rng(42);
+    fast_vector<T> v(std::size_t(state.range(0)));
+
+    for (std::size_t i = 0; i < v.size(); i++)
+        v[i] = make_sort_value<T>(make_key(dist, i, rng));
+
+    state.SetLabel(distribution_names[dist]);
+    return v;
+}
+
+// Sizes 10 ... FAST_VECTOR_BENCH_MAX_SIZE times the three distributions
+void sort_args(benchmark::internal::Benchmark* b)
+{
+    for (int dist = uniform; dist <= skewed; dist++)
+    {
+        for (std::int64_t n = 10; n <= FAST_VECTOR_BENCH_MAX_SIZE; n *= 10)
+            b->Args({n, dist});
+    }
+}
+
+// The thread counts for the largest size and the three distributions
+void parallel_sort_args(benchmark::internal::Benchmark* b)
+{
+    std::int64_t cores = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+
+    for (int dist = uniform; dist <= skewed; dist++)
+    {
+        for (std::int64_t threads = 1; threads < cores; threads *= 2)
+            b->Args({FAST_VECTOR_BENCH_MAX_SIZE, dist, threads});
+        b->Args({FAST_VECTOR_BENCH_MAX_SIZE, dist, cores});
+    }
+}
+
+}
+
+// Every iteration sorts a fresh copy of the input, the copy is part of both measurements
+
+template <typename T>
+void bm_sort_std(benchmark::State& state)
+{
+    const fast_vector<T> input = make_input<T>(state);
+    fast_vector<T> v(input.size());
+
+    for (auto _ : state)
+    {
+        std::copy(input.begin(), input.end(), v.begin());
+        std::sort(v.begin(), v.end());
+        benchmark::DoNotOptimize(v.data());
+    }
+    set_processed<T>(state, v.size());
+}
+
+template <typename T>
+void bm_sort_fast(benchmark::State& state)
+{
+    const fast_vector<T> input = make_input<T>(state);
+    fast_vector<T> v(input.size());
+
+    for (auto _ : state)
+    {
+        std::copy(input.begin(), input.end(), v.begin());
+        v.sort();
+        benchmark::DoNotOptimize(v.data());
+    }
+    set_processed<T>(state, v.size());
+}
+
+// The comparison sort alone, the radix sort taken out by an explicit comparator
+template <typename T>
+void bm_sort_pdq(benchmark::State& state)
+{
+    const fast_vector<T> input = make_input<T>(state);
+    fast_vector<T> v(input.size());
+
+    for (auto _ : state)
+    {
+        std::copy(input.begin(), input.end(), v.begin());
+        v.sort(std::less<T>());
+        benchmark::DoNotOptimize(v.data());
+    }
+    set_processed<T>(state, v.size());
+}
+
+template <typename T>
+void bm_sort_parallel(benchmark::State& state)
+{
+    const fast_vector<T> input = make_input<T>(state);
+    fast_vector<T> v(input.size());
+    fast_thread_pool pool(state.range(2));
+
+    for (auto _ : state)
+    {
+        std::copy(input.begin(), input.end(), v.begin());
+        parallel_sort(v, pool);
+        benchmark::DoNotOptimize(v.data());
+    }
+    set_processed<T>(state, v.size());
+}
+
+BENCHMARK_TEMPLATE(bm_sort_std, std::uint64_t)->Apply(sort_args);
+BENCHMARK_TEMPLATE(bm_sort_pdq, std::uint64_t)->Apply(sort_args);
+BENCHMARK_TEMPLATE(bm_sort_fast, std::uint64_t)->Apply(sort_args);
+BENCHMARK_TEMPLATE(bm_sort_std, record)->Apply(sort_args);
+BENCHMARK_TEMPLATE(bm_sort_pdq, record)->Apply(sort_args);
+BENCHMARK_TEMPLATE(bm_sort_fast, record)->Apply(sort_args);
+BENCHMARK_TEMPLATE(bm_sort_parallel, std::uint64_t)->Apply(parallel_sort_args)->UseRealTime();
@@ -0,0 +1,548 @@
+//
+// Allocation policies for fast_vector
+//
+// Advanced & fixed version by Marian Krivos
+//
+
+#pragma once
+
+#include "fast_vector.h"
+
+#if defined(__linux__)
+#include <sys/mman.h> // mmap(), mremap()
+#include <unistd.h>   // sysconf()
+#endif
+
+/**
+ * Bump allocator releasing everything at once. Blocks are carved from large chunks,
+ * individual deallocations are ignored and the last block can grow in place.
+ */
+class monotonic_arena
+{
+public:
+    static constexpr std::size_t default_chunk_size = 64 * 1024;
+
+    explicit monotonic_arena(std::size_t chunk_size = default_chunk_size);
+    monotonic_arena(const monotonic_arena&) = delete;
+    monotonic_arena& operator=(const monotonic_arena&) = delete;
+    ~monotonic_arena();
+
+    void* allocate(std::size_t bytes, std::size_t alignment);
+    bool try_expand(void* ptr, std::size_t old_bytes, std::size_t new_bytes) noexcept;
+
+    // Releases all the chunks, every block handed out so far becomes invalid
+    void release() noexcept;
+
+    std::size_t bytes_allocated() const noexcept;
+
+    // The arena used by arena_allocator on the calling thread
+    static monotonic_arena*& current() noexcept;
+
+private:
+    struct chunk
+    {
+        chunk* next;
+        std::size_t size;
+    };
+
+    chunk* m_chunks = nullptr;
+    char* m_cursor = nullptr;
+    char* m_limit = nullptr;
+    char* m_last = nullptr;
+    std::size_t m_chunk_size;
+    std::size_t m_allocated = 0;
+};
+
+inline monotonic_arena::monotonic_arena(std::size_t chunk_size) :
+    m_chunk_size(chunk_size)
+{
+}
+
+inline monotonic_arena::~monotonic_arena()
+{
+    release();
+}
+
+inline void* monotonic_arena::allocate(std::size_t bytes, std::size_t alignment)
+{
+    auto aligned = reinterpret_cast<char*>((reinterpret_cast<std::uintptr_t>(m_cursor) + alignment - 1) & ~(alignment - 1));
+
+    if (!m_cursor || aligned + bytes > m_limit)
+    {
+        std::size_t size = sizeof(chunk) + alignment + bytes;
+        if (size < m_chunk_size)
+            size = m_chunk_size;
+
+        auto block = reinterpret_cast<chunk*>(std::malloc(size));
+        if (!block)
+            return nullptr;
+
+        block->next = m_chunks;
+        block->size = size;
+        m_chunks = block;
+
+        m_cursor = reinterpret_cast<char*>(block + 1);
+        m_limit = reinterpret_cast<char*>(block) + size;
+        aligned = reinterpret_cast<char*>((reinterpret_cast<std::uintptr_t>(m_cursor) + alignment - 1) & ~(alignment - 1));
+    }
+
+    m_last = aligned;
+    m_cursor = aligned + bytes;
+    m_allocated += bytes;
+
+    return aligned;
+}
+
+inline bool monotonic_arena::try_expand(void* ptr, std::size_t old_bytes, std::size_t new_bytes) noexcept
+{
+    // Only the most recent block may grow, it is the one touching the cursor
+    if (ptr != m_last || m_last + old_bytes != m_cursor || m_last + new_bytes > m_limit)
+        return false;
+
+    m_cursor = m_last + new_bytes;
+    m_allocated += new_bytes - old_bytes;
+
+    return true;
+}
+
+inline void monotonic_arena::release() noexcept
+{
+    while (m_chunks)
+    {
+        chunk* next = m_chunks->next;
+        std::free(m_chunks);
+        m_chunks = next;
+    }
+
+    m_cursor = m_limit = m_last = nullptr;
+    m_allocated = 0;
+}
+
+inline std::size_t monotonic_arena::bytes_allocated() const noexcept
+{
+    return m_allocated;
+}
+
+inline monotonic_arena*& monotonic_arena::current() noexcept
+{
+    static thread_local monotonic_arena* arena = nullptr;
+    return arena;
+}
+
+/**
+ * Installs an arena as the current one for the calling thread, restores the previous on exit.
+ */
+class arena_scope
+{
+public:
+    explicit arena_scope(monotonic_arena& arena) noexcept :
+        m_previous(monotonic_arena::current())
+    {
+        monotonic_arena::current() = &arena;
+    }
+
+    arena_scope(const arena_scope&) = delete;
+    arena_scope& operator=(const arena_scope&) = delete;
+
+    ~arena_scope()
+    {
+        monotonic_arena::current() = m_previous;
+    }
+
+private:
+    monotonic_arena* m_previous;
+};
+
+/**
+ * Policy allocating from the thread's current monotonic_arena (see arena_scope).
+ * The vectors must not outlive the arena, their memory goes away with it.
+ */
+struct arena_allocator
+{
+    static void* allocate(std::size_t bytes, std::size_t alignment)
+    {
+        assert(monotonic_arena::current() && "No arena installed on this thread");
+        return monotonic_arena::current()->allocate(bytes, alignment);
+    }
+
+    static void* allocate_zeroed(std::size_t bytes, std::size_t alignment)
+    {
+        void* ptr = allocate(bytes, alignment);
+        if (ptr)
+            std::memset(ptr, 0, bytes);
+        return ptr;
+    }
+
+    static bool try_expand(void* ptr, std::size_t old_bytes, std::size_t new_bytes, std::size_t) noexcept
+    {
+        monotonic_arena* arena = monotonic_arena::current();
+        return arena && arena->try_expand(ptr, old_bytes, new_bytes);
+    }
+
+    static void* reallocate(void* ptr, std::size_t old_bytes, std::size_t new_bytes, std::size_t alignment)
+    {
+        if (ptr && try_expand(ptr, old_bytes, new_bytes, alignment))
+            return ptr;
+        if (ptr && new_bytes <= old_bytes)
+            return ptr;
+
+        void* moved = allocate(new_bytes, alignment);
+        if (moved && ptr)
+            std::memcpy(moved, ptr, old_bytes);
+        return moved;
+    }
+
+    static void deallocate(void*, std::size_t, std::size_t) noexcept
+    {
+    }
+};
+
+/**
+ * Policy recycling blocks through thread-local free lists of power-of-two size classes.
+ * Blocks above max_pooled_size or with a larger alignment than pool_alignment go to malloc.
+ */
+struct pool_allocator
+{
+    static constexpr std::size_t min_class_shift = 4;  // 16 bytes
+    static constexpr std::size_t max_class_shift = 15; // 32 KB
+    static constexpr std::size_t max_pooled_size = std::size_t(1) << max_class_shift;
+    static constexpr std::size_t pool_alignment = 64;
+    static constexpr std::size_t max_cached_blocks = 256;
+
+    static void* allocate(std::size_t bytes, std::size_t alignment)
+    {
+        if (!pooled(bytes, alignment))
+            return aligned_allocate(bytes, alignment);
+
+        std::size_t index = size_class(bytes);
+        free_list& list = cache().lists[index];
+
+        if (list.head)
+        {
+            node* block = list.head;
+            list.head = block->next;
+            list.count--;
+            return block;
+        }
+
+        return aligned_allocate(class_size(index), pool_alignment);
+    }
+
+    static void* allocate_zeroed(std::size_t bytes, std::size_t alignment)
+    {
+        if (!pooled(bytes, alignment))
+            return aligned_allocate_zeroed(bytes, alignment);
+
+        // Recycled blocks hold old data
+        void* ptr = allocate(bytes, alignment);
+        if (ptr)
+            std::memset(ptr, 0, bytes);
+        return ptr;
+    }
+
+    static bool try_expand(void* ptr, std::size_t old_bytes, std::size_t new_bytes, std::size_t alignment) noexcept
+    {
+        // The block is rounded up to its size class, so there may be room left
+        return ptr && pooled(old_bytes, alignment) && new_bytes <= class_size(size_class(old_bytes));
+    }
+
+    static void* reallocate(void* ptr, std::size_t old_bytes, std::size_t new_bytes, std::size_t alignment)
+    {
+        if (!ptr)
+            return allocate(new_bytes, alignment);
+
+        bool old_pooled = pooled(old_bytes, alignment);
+        bool new_pooled = pooled(new_bytes, alignment);
+
+        if (!old_pooled && !new_pooled)
+            return aligned_reallocate(ptr, old_bytes, new_bytes, alignment);
+
+        if (old_pooled && new_pooled && size_class(old_bytes) == size_class(new_bytes))
+            return ptr;
+
+        void* moved = allocate(new_bytes, alignment);
+        if (!moved)
+            return nullptr;
+
+        std::memcpy(moved, ptr, old_bytes < new_bytes ? old_bytes : new_bytes);
+        deallocate(ptr, old_bytes, alignment);
+
+        return moved;
+    }
+
+    static void deallocate(void* ptr, std::size_t bytes, std::size_t alignment) noexcept
+    {
+        if (!ptr)
+            return;
+
+        if (!pooled(bytes, alignment))
+        {
+            aligned_deallocate(ptr, alignment);
+            return;
+        }
+
+        free_list& list = cache().lists[size_class(bytes)];
+
+        if (list.count >= max_cached_blocks)
+        {
+            aligned_deallocate(ptr, pool_alignment);
+            return;
+        }
+
+        auto block = reinterpret_cast<node*>(ptr);
+        block->next = list.head;
+        list.head = block;
+        list.count++;
+    }
+
+private:
+    struct node
+    {
+        node* next;
+    };
+
+    struct free_list
+    {
+        node* head = nullptr;
+        std::size_t count = 0;
+    };
+
+    struct thread_cache
+    {
+        free_list lists[max_class_shift + 1];
+
+        ~thread_cache()
+        {
+            for (auto& list : lists)
+            {
+                while (list.head)
+                {
+                    node* next = list.head->next;
+                    aligned_deallocate(list.head, pool_alignment);
+                    list.head = next;
+                }
+            }
+        }
+    };
+
+    static thread_cache& cache() noexcept
+    {
+        static thread_local thread_cache instance;
+        return instance;
+    }
+
+    static bool pooled(std::size_t bytes, std::size_t alignment) noexcept
+    {
+        return bytes <= max_pooled_size && alignment <= pool_alignment;
+    }
+
+    static std::size_t size_class(std::size_t bytes) noexcept
+    {
+        std::size_t shift = min_class_shift;
+        while ((std::size_t(1) << shift) < bytes)
+            shift++;
+        return shift;
+    }
+
+    static std::size_t class_size(std::size_t index) noexcept
+    {
+        return std::size_t(1) << index;
+    }
+};
+
+#if defined(__linux__)
+
+// Page granularity helpers of the mapping based policies
+
+inline std::size_t system_page_size() noexcept
+{
+    static const std::size_t size = std::size_t(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+inline std::size_t round_to_pages(std::size_t bytes) noexcept
+{
+    std::size_t page = system_page_size();
+    return (bytes + page - 1) & ~(page - 1);
+}
+
+/**
+ * Policy giving every block of at least Threshold bytes its own anonymous mapping, grown
+ * by mremap(MREMAP_MAYMOVE): the kernel moves the page tables and the data is never copied.
+ * Smaller blocks come from malloc, a block crossing the threshold is copied once. Linux only.
+ */
+template <std::size_t Threshold = 32 * 1024 * 1024>
+struct mmap_allocator
+{
+    static_assert(Threshold > 0, "Empty blocks cannot be mapped");
+
+    static constexpr std::size_t threshold = Threshold;
+
+    static void* allocate(std::size_t bytes, std::size_t alignment)
+    {
+        if (!mapped(bytes))
+            return aligned_allocate(bytes, alignment);
+
+        assert(alignment <= system_page_size() && "Mappings are only page aligned");
+
+        std::size_t size = round_to_pages(bytes);
+        void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ptr == MAP_FAILED)
+            return nullptr;
+
+        // Huge pages leave mremap far fewer page table entries to move, the hint survives remapping
+        madvise(ptr, size, MADV_HUGEPAGE);
+        return ptr;
+    }
+
+    static void* allocate_zeroed(std::size_t bytes, std::size_t alignment)
+    {
+        // Fresh anonymous pages are zero already
+        return mapped(bytes) ? allocate(bytes, alignment) : aligned_allocate_zeroed(bytes, alignment);
+    }
+
+    static bool try_expand(void* ptr, std::size_t old_bytes, std::size_t new_bytes, std::size_t alignment) noexcept
+    {
+        if (!ptr || new_bytes < old_bytes)
+            return false;
+
+        // A malloc block must not grow past the threshold, it would be unmapped later
+        if (!mapped(old_bytes))
+            return !mapped(new_bytes) && malloc_allocator::try_expand(ptr, old_bytes, new_bytes, alignment);
+
+        // The address range following the mapping may still be free
+        std::size_t old_size = round_to_pages(old_bytes);
+        std::size_t new_size = round_to_pages(new_bytes);
+
+        return new_size == old_size || mremap(ptr, old_size, new_size, 0) != MAP_FAILED;
+    }
+
+    static void* reallocate(void* ptr, std::size_t old_bytes, std::size_t new_bytes, std::size_t alignment)
+    {
+        if (!ptr)
+            return allocate(new_bytes, alignment);
+
+        bool old_mapped = mapped(old_bytes);
+        bool new_mapped = mapped(new_bytes);
+
+        if (!old_mapped && !new_mapped)
+            return aligned_reallocate(ptr, old_bytes, new_bytes, alignment);
+
+        if (old_mapped && new_mapped)
+        {
+            void* moved = mremap(ptr, round_to_pages(old_bytes), round_to_pages(new_bytes), MREMAP_MAYMOVE);
+            return moved == MAP_FAILED ? nullptr : moved;
+        }
+
+        // Crossing the threshold, the only case copying the data
+        void* moved = allocate(new_bytes, alignment);
+        if (!moved)
+            return nullptr;
+
+        std::memcpy(moved, ptr, old_bytes < new_bytes ? old_bytes : new_bytes);
+        deallocate(ptr, old_bytes, alignment);
+
+        return moved;
+    }
+
+    static void deallocate(void* ptr, std::size_t bytes, std::size_t alignment) noexcept
+    {
+        if (ptr && mapped(bytes))
+            munmap(ptr, round_to_pages(bytes));
+        else
+            aligned_deallocate(ptr, alignment);
+    }
+
+private:
+    // The block size alone tells where the block came from
+    static bool mapped(std::size_t bytes) noexcept
+    {
+        return bytes >= Threshold;
+    }
+};
+
+/**
+ * Policy reserving ReserveBytes of address space per block up front (PROT_NONE, MAP_NORESERVE)
+ * and committing pages only as the capacity advances, so a block never moves: data() stays
+ * valid for the whole life of the vector and growth costs an mprotect instead of a copy.
+ * Growing past the reservation fails, size it for the largest capacity the growth policy
+ * can ask for. Meant for a few long-lived big buffers, every block takes the whole range.
+ * Linux only.
+ */
+template <std::size_t ReserveBytes = std::size_t(1) << (sizeof(void*) == 8 ? 36 : 28)>
+struct reserved_allocator
+{
+    static constexpr std::size_t reserve_bytes = ReserveBytes;
+
+    static void* allocate(std::size_t bytes, std::size_t alignment)
+    {
+        assert(alignment <= system_page_size() && "Mappings are only page aligned");
+        (void)alignment;
+
+        if (bytes > ReserveBytes)
+            return nullptr;
+
+        void* ptr = mmap(nullptr, ReserveBytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (ptr == MAP_FAILED)
+            return nullptr;
+
+        if (!commit(ptr, 0, bytes))
+        {
+            munmap(ptr, ReserveBytes);
+            return nullptr;
+        }
+        return ptr;
+    }
+
+    // Fresh anonymous pages are zero already
+    static void* allocate_zeroed(std::size_t bytes, std::size_t alignment)
+    {
+        return allocate(bytes, alignment);
+    }
+
+    static bool try_expand(void* ptr, std::size_t old_bytes, std::size_t new_bytes, std::size_t) noexcept
+    {
+        return ptr && new_bytes <= ReserveBytes && commit(ptr, old_bytes, new_bytes);
+    }
+
+    static void* reallocate(void* ptr, std::size_t old_bytes, std::size_t new_bytes, std::size_t alignment)
+    {
+        if (!ptr)
+            return allocate(new_bytes, alignment);
+
+        if (new_bytes >= old_bytes)
+            return try_expand(ptr, old_bytes, new_bytes, alignment) ? ptr : nullptr;
+
+        // Shrinking hands the tail pages back to the system, the block stays where it is
+        std::size_t used = round_to_pages(new_bytes);
+        std::size_t committed = round_to_pages(old_bytes);
+        if (used < committed)
+        {
+            char* tail = static_cast<char*>(ptr) + used;
+            madvise(tail, committed - used, MADV_DONTNEED);
+            mprotect(tail, committed - used, PROT_NONE);
+        }
+        return ptr;
+    }
+
+    static void deallocate(void* ptr, std::size_t, std::size_t) noexcept
+    {
+        if (ptr)
+            munmap(ptr, ReserveBytes);
+    }
+
+private:
+    // Makes the pages behind [old_bytes, new_bytes) accessible, the physical memory comes on first touch
+    static bool commit(void* ptr, std::size_t old_bytes, std::size_t new_bytes) noexcept
+    {
+        std::size_t committed = round_to_pages(old_bytes);
+        std::size_t needed = round_to_pages(new_bytes);
+
+        if (needed <= committed)
+            return true;
+
+        return mprotect(static_cast<char*>(ptr) + committed, needed - committed, PROT_READ | PROT_WRITE) == 0;
+    }
+};
+
+#endif // __linux__
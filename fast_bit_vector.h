@@ -0,0 +1,674 @@
+//
+// One bit per flag on fast_vector words, with vectorized bulk operations
+//
+// Advanced & fixed version by Marian Krivos
+//
+
+#pragma once
+
+#include <algorithm> // std::fill()
+
+#include "fast_vector.h"
+
+// Word helpers
+
+inline std::size_t bit_popcount(std::uint64_t word) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return std::size_t(__builtin_popcountll(word));
+#else
+    std::size_t count = 0;
+    for (; word; word &= word - 1)
+        count++;
+    return count;
+#endif
+}
+
+// Index of the lowest set bit of a non-zero word, a single tzcnt/bsf
+inline std::size_t bit_first(std::uint64_t word) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return std::size_t(__builtin_ctzll(word));
+#else
+    std::size_t index = 0;
+    while (!(word & 1))
+    {
+        word >>= 1;
+        index++;
+    }
+    return index;
+#endif
+}
+
+// Bulk word kernels: dst[i] = dst[i] op src[i]
+
+enum class bit_op
+{
+    and_op,
+    or_op,
+    xor_op,
+    andnot_op // dst & ~src
+};
+
+template <bit_op Op>
+inline std::uint64_t bit_apply(std::uint64_t a, std::uint64_t b) noexcept
+{
+    if constexpr (Op == bit_op::and_op)
+        return a & b;
+    else if constexpr (Op == bit_op::or_op)
+        return a | b;
+    else if constexpr (Op == bit_op::xor_op)
+        return a ^ b;
+    else
+        return a & ~b;
+}
+
+template <bit_op Op>
+inline void bit_words_scalar(std::uint64_t* dst, const std::uint64_t* src, std::size_t count) noexcept
+{
+    for (std::size_t i = 0; i < count; i++)
+        dst[i] = bit_apply<Op>(dst[i], src[i]);
+}
+
+inline std::size_t bit_popcount_scalar(const std::uint64_t* words, std::size_t count) noexcept
+{
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < count; i++)
+        total += bit_popcount(words[i]);
+    return total;
+}
+
+#if defined(FAST_VECTOR_X86_DISPATCH)
+
+template <bit_op Op>
+__attribute__((target("avx2"))) inline void bit_words_avx2(std::uint64_t* dst, const std::uint64_t* src, std::size_t count) noexcept
+{
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+
+        if constexpr (Op == bit_op::and_op)
+            a = _mm256_and_si256(a, b);
+        else if constexpr (Op == bit_op::or_op)
+            a = _mm256_or_si256(a, b);
+        else if constexpr (Op == bit_op::xor_op)
+            a = _mm256_xor_si256(a, b);
+        else
+            a = _mm256_andnot_si256(b, a);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), a);
+    }
+    bit_words_scalar<Op>(dst + i, src + i, count - i);
+}
+
+template <bit_op Op>
+__attribute__((target("avx512f"))) inline void bit_words_avx512(std::uint64_t* dst, const std::uint64_t* src, std::size_t count) noexcept
+{
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m512i a = _mm512_loadu_si512(dst + i);
+        __m512i b = _mm512_loadu_si512(src + i);
+
+        if constexpr (Op == bit_op::and_op)
+            a = _mm512_and_si512(a, b);
+        else if constexpr (Op == bit_op::or_op)
+            a = _mm512_or_si512(a, b);
+        else if constexpr (Op == bit_op::xor_op)
+            a = _mm512_xor_si512(a, b);
+        else
+            a = _mm512_and_si512(a, _mm512_xor_si512(b, _mm512_set1_epi64(-1)));
+
+        _mm512_storeu_si512(dst + i, a);
+    }
+    bit_words_scalar<Op>(dst + i, src + i, count - i);
+}
+
+// Every AVX2 CPU has popcnt, four sums keep four of them in flight
+__attribute__((target("avx2,popcnt"))) inline std::size_t bit_popcount_avx2(const std::uint64_t* words, std::size_t count) noexcept
+{
+    std::uint64_t sums[4] = {};
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        sums[0] += std::uint64_t(__builtin_popcountll(words[i]));
+        sums[1] += std::uint64_t(__builtin_popcountll(words[i + 1]));
+        sums[2] += std::uint64_t(__builtin_popcountll(words[i + 2]));
+        sums[3] += std::uint64_t(__builtin_popcountll(words[i + 3]));
+    }
+    for (; i < count; i++)
+        sums[0] += std::uint64_t(__builtin_popcountll(words[i]));
+    return std::size_t(sums[0] + sums[1] + sums[2] + sums[3]);
+}
+
+#endif // FAST_VECTOR_X86_DISPATCH
+
+template <bit_op Op>
+inline void bit_words(std::uint64_t* dst, const std::uint64_t* src, std::size_t count) noexcept
+{
+#if defined(FAST_VECTOR_X86_DISPATCH)
+    switch (detect_simd_level())
+    {
+    case simd_level::avx512:
+        return bit_words_avx512<Op>(dst, src, count);
+    case simd_level::avx2:
+        return bit_words_avx2<Op>(dst, src, count);
+    default:
+        break;
+    }
+#endif
+    bit_words_scalar<Op>(dst, src, count);
+}
+
+inline std::size_t bit_popcount_words(const std::uint64_t* words, std::size_t count) noexcept
+{
+#if defined(FAST_VECTOR_X86_DISPATCH)
+    if (detect_simd_level() >= simd_level::avx2)
+        return bit_popcount_avx2(words, count);
+#endif
+    return bit_popcount_scalar(words, count);
+}
+
+/**
+ * Vector of flags packed 64 to a word, 8x less memory than fast_vector<bool> and scans
+ * a word at a time: the bulk operations and popcount() go through the SIMD kernels, the
+ * set bits are found by tzcnt. The words are a fast_vector with its alignment, allocator
+ * and growth policy. The bits past size() in the last word are kept zero.
+ */
+template <int A = 16, typename M = malloc_allocator, typename G = factor_growth<>>
+class fast_bit_vector
+{
+public:
+    using size_type = std::size_t;
+    using word_type = std::uint64_t;
+    using storage_type = fast_vector<word_type, false, A, M, G>;
+
+    static constexpr size_type word_bits = 64;
+    // Returned by the searches when there is no set bit
+    static constexpr size_type npos = size_type(-1);
+
+    fast_bit_vector() = default;
+    explicit fast_bit_vector(size_type count, bool value = false);
+
+    // Element access
+
+    bool operator[](size_type pos) const noexcept;
+    bool test(size_type pos) const noexcept;
+
+#if !defined(FAST_VECTOR_NO_EXCEPTIONS)
+    bool at(size_type pos) const;
+#endif
+
+    // The words holding the bits, bit i is bit i % 64 of word i / 64
+    const storage_type& words() const noexcept;
+
+    // Capacity
+
+    bool empty() const noexcept;
+    size_type size() const noexcept;
+    // In bits
+    size_type capacity() const noexcept;
+    void reserve(size_type new_cap);
+    void shrink_to_fit();
+
+    // Modifiers
+
+    void set(size_type pos) noexcept;
+    void set(size_type pos, bool value) noexcept;
+    void reset(size_type pos) noexcept;
+    void flip(size_type pos) noexcept;
+
+    // All the bits at once
+    void set() noexcept;
+    void reset() noexcept;
+
+    void clear() noexcept;
+    void push_back(bool value);
+    void pop_back() noexcept;
+    void resize(size_type count, bool value = false);
+
+    // Appends count copies of value, whole words are filled at once
+    void append(size_type count, bool value);
+    // Appends the low count bits of bits, count up to 64
+    void append_word(word_type bits, size_type count);
+    // One memcpy when size() is a multiple of 64, a shifting word loop otherwise
+    void append(const fast_bit_vector& other);
+
+    // Bulk operations, other must have the same size
+
+    fast_bit_vector& operator&=(const fast_bit_vector& other) noexcept;
+    fast_bit_vector& operator|=(const fast_bit_vector& other) noexcept;
+    fast_bit_vector& operator^=(const fast_bit_vector& other) noexcept;
+    // Clears the bits set in other
+    fast_bit_vector& and_not(const fast_bit_vector& other) noexcept;
+    // Flips all the bits
+    void flip() noexcept;
+
+    // Queries
+
+    size_type popcount() const noexcept;
+    bool any() const noexcept;
+    bool none() const noexcept;
+
+    size_type find_first() const noexcept;
+    // First set bit after pos
+    size_type find_next(size_type pos) const noexcept;
+
+    // Calls f(index) for every set bit in increasing order
+    template< class F >
+    void for_each_set(F f) const;
+
+    static void swap(fast_bit_vector& a, fast_bit_vector& b) noexcept;
+
+    bool operator==(const fast_bit_vector& other) const noexcept;
+    bool operator!=(const fast_bit_vector& other) const noexcept;
+
+    using allocator_type = M;
+    using growth_policy = G;
+
+private:
+    static size_type words_for(size_type bits) noexcept;
+    // Zeroes the bits past size() in the last word
+    void clear_tail() noexcept;
+
+    storage_type m_words;
+    size_type m_size = 0;
+};
+
+template <int A, typename M, typename G>
+fast_bit_vector<A,M,G>::fast_bit_vector(size_type count, bool value) :
+    m_words(words_for(count), value ? ~word_type(0) : word_type(0)),
+    m_size(count)
+{
+    clear_tail();
+}
+
+template <int A, typename M, typename G>
+void fast_bit_vector<A,M,G>::swap(fast_bit_vector& a, fast_bit_vector& b) noexcept
+{
+    storage_type::swap(a.m_words, b.m_words);
+    std::swap(a.m_size, b.m_size);
+}
+
+template <int A, typename M, typename G>
+typename fast_bit_vector<A,M,G>::size_type fast_bit_vector<A,M,G>::words_for(size_type bits) noexcept
+{
+    return (bits + word_bits - 1) / word_bits;
+}
+
+template <int A, typename M, typename G>
+void fast_bit_vector<A,M,G>::clear_tail() noexcept
+{
+    if (size_type used = m_size % word_bits)
+        m_words.back() &= (word_type(1) << used) - 1;
+}
+
+// Element access
+
+template <int A, typename M, typename G>
+bool fast_bit_vector<A,M,G>::test(size_type pos) const noexcept
+{
+    assert(pos < m_size && "Position is out of range");
+    return (m_words[pos / word_bits] >> (pos % word_bits)) & 1;
+}
+
+template <int A, typename M, typename G>
+bool fast_bit_vector<A,M,G>::operator[](size_type pos) const noexcept
+{
+    return test(pos);
+}
+
+#if !defined(FAST_VECTOR_NO_EXCEPTIONS)
+template <int A, typename M, typename G>
+bool fast_bit_vector<A,M,G>::at(size_type pos) const
+{
+    if (pos >= m_size)
+        throw std::out_of_range("fast_bit_vector::at");
+    return test(pos);
+}
+#endif
+
+template <int A, typename M, typename G>
+const typename fast_bit_vector<A,M,G>::storage_type& fast_bit_vector<A,M,G>::words() const noexcept
+{
+    return m_words;
+}
+
+// Capacity
+
+template <int A, typename M, typename G>
+bool fast_bit_vector<A,M,G>::empty() const noexcept
+{
+    return m_size == 0;
+}
+
+template <int A, typename M, typename G>
+typename fast_bit_vector<A,M,G>::size_type fast_bit_vector<A,M,G>::size() const noexcept
+{
+    return m_size;
+}
+
+template <int A, typename M, typename G>
+typename fast_bit_vector<A,M,G>::size_type fast_bit_vector<A,M,G>::capacity() const noexcept
+{
+    return m_words.capacity() * word_bits;
+}
+
+template <int A, typename M, typename G>
+void fast_bit_vector<A,M,G>::reserve(size_type new_cap)
+{
+    m_words.reserve(words_for(new_cap));
+}
+
+template <int A, typename M, typename G>
+void fast_bit_vector<A,M,G>::shrink_to_fit()
+{
+    m_words.shrink_to_fit();
+}
+
+// Modifiers
+
+template <int A, typename M, typename G>
+void fast_bit_vector<A,M,G>::set(size_type pos) noexcept
+{
+    assert(pos < m_size && "Position is out of range");
+    m_words[pos / word_bits] |= word_type(1) << (pos % word_bits);
+}
+
+template <int A, typename M, typename G>
+void fast_bit_vector<A,M,G>::set(size_type pos, bool value) noexcept
+{
+    assert(pos < m_size && "Position is out of range");
+    word_type& word = m_words[pos / word_bits];
+    const word_type bit = word_type(1) << (pos % word_bits);
+    word = (word & ~bit) | ((word_type(0) - word_type(value)) & bit);
+}
+
+template <int A, typename M, typename G>
+void fast_bit_vector<A,M,G>::reset(size_type pos) noexcept
+{
+    assert(pos < m_size && "Position is out of range");
+    m_words[pos / word_bits] &= ~(word_type(1) << (pos % word_bits));
+}
+
+template <int A, typename M, typename G>
+void fast_bit_vector<A,M,G>::flip(size_type pos) noexcept
+{
+    assert(pos < m_size && "Position is out of range");
+    m_words[pos / word_bits] ^= word_type(1) << (pos % word_bits);
+}
+
+template <int A, typename M, typename G>
+void fast_bit_vector<A,M,G>::set() noexcept
+{
+    std::fill(m_words.begin(), m_words.end(), ~word_type(0));
+    clear_tail();
+}
+
+template <int A, typename M, typename G>
+void fast_bit_vector<A,M,G>::reset() noexcept
+{
+    std::fill(m_words.begin(), m_words.end(), word_type(0));
+}
+
+template <int A, typename M, typename G>
+void fast_bit_vector<A,M,G>::clear() noexcept
+{
+    m_words.clear();
+    m_size = 0;
+}
+
+template <int A, typename M, typename G>
+void fast_bit_vector<A,M,G>::push_back(bool value)
+{
+    const size_type used = m_size % word_bits;
+
+    // A new word once every 64 bits, otherwise an or into the last one
+    if (used == 0)
+        m_words.push_back(word_type(value));
+    else
+        m_words.data()[m_size / word_bits] |= word_type(value) << used;
+    m_size++;
+}
+
+template <int A, typename M, typename G>
+void fast_bit_vector<A,M,G>::pop_back() noexcept
+{
+    assert(m_size > 0 && "The vector is empty");
+    m_size--;
+
+    if (m_size % word_bits == 0)
+        m_words.pop_back();
+    else
+        clear_tail();
+}
+
+template <int A, typename M, typename G>
+void fast_bit_vector<A,M,G>::resize(size_type count, bool value)
+{
+    if (count > m_size)
+    {
+        append(count - m_size, value);
+    }
+    else
+    {
+        m_words.resize(words_for(count));
+        m_size = count;
+        clear_tail();
+    }
+}
+
+template <int A, typename M, typename G>
+void fast_bit_vector<A,M,G>::append(size_type count, bool value)
+{
+    const word_type fill = value ? ~word_type(0) : word_type(0);
+
+    // The free bits of the last word, then whole words
+    if (size_type used = m_size % word_bits)
+    {
+        const size_type head = std::min(count, word_bits - used);
+        if (value)
+            m_words.back() |= (head == word_bits ? ~word_type(0) : (word_type(1) << head) - 1) << used;
+        m_size += head;
+        count -= head;
+    }
+
+    if (count)
+    {
+        m_words.resize(words_for(m_size + count), fill);
+        m_size += count;
+        clear_tail();
+    }
+}
+
+template <int A, typename M, typename G>
+void fast_bit_vector<A,M,G>::append_word(word_type bits, size_type count)
+{
+    assert(count <= word_bits && "Count is out of range");
+
+    if (count == 0)
+        return;
+    if (count < word_bits)
+        bits &= (word_type(1) << count) - 1;
+
+    const size_type used = m_size % word_bits;
+
+    if (used == 0)
+    {
+        m_words.push_back(bits);
+    }
+    else
+    {
+        m_words.back() |= bits << used;
+        if (used + count > word_bits)
+            m_words.push_back(bits >> (word_bits - used));
+    }
+    m_size += count;
+}
+
+template <int A, typename M, typename G>
+void fast_bit_vector<A,M,G>::append(const fast_bit_vector& other)
+{
+    const size_type used = m_size % word_bits;
+    const size_type other_words = other.m_words.size();
+
+    if (other.m_size == 0)
+        return;
+
+    if (used == 0)
+    {
+        m_words.append(other.m_words.data(), other_words);
+        m_size += other.m_size;
+        return;
+    }
+
+    // Appending to itself, the source words must not move under the loop
+    if (this == &other)
+    {
+        fast_bit_vector copy(other);
+        append(copy);
+        return;
+    }
+
+    // Every source word goes half to the last word and half to a new one
+    const size_type first = m_words.size() - 1;
+    m_words.resize(words_for(m_size + other.m_size), zero_init);
+
+    word_type* dst = m_words.data() + first;
+    for (size_type i = 0; i < other_words; i++)
+    {
+        const word_type word = other.m_words[i];
+        dst[i] |= word << used;
+        if (first + i + 1 < m_words.size())
+            dst[i + 1] = word >> (word_bits - used);
+    }
+    m_size += other.m_size;
+}
+
+// Bulk operations
+
+template <int A, typename M, typename G>
+fast_bit_vector<A,M,G>& fast_bit_vector<A,M,G>::operator&=(const fast_bit_vector& other) noexcept
+{
+    assert(m_size == other.m_size && "The sizes differ");
+    bit_words<bit_op::and_op>(m_words.data(), other.m_words.data(), m_words.size());
+    return *this;
+}
+
+template <int A, typename M, typename G>
+fast_bit_vector<A,M,G>& fast_bit_vector<A,M,G>::operator|=(const fast_bit_vector& other) noexcept
+{
+    assert(m_size == other.m_size && "The sizes differ");
+    bit_words<bit_op::or_op>(m_words.data(), other.m_words.data(), m_words.size());
+    return *this;
+}
+
+template <int A, typename M, typename G>
+fast_bit_vector<A,M,G>& fast_bit_vector<A,M,G>::operator^=(const fast_bit_vector& other) noexcept
+{
+    assert(m_size == other.m_size && "The sizes differ");
+    bit_words<bit_op::xor_op>(m_words.data(), other.m_words.data(), m_words.size());
+    return *this;
+}
+
+template <int A, typename M, typename G>
+fast_bit_vector<A,M,G>& fast_bit_vector<A,M,G>::and_not(const fast_bit_vector& other) noexcept
+{
+    assert(m_size == other.m_size && "The sizes differ");
+    bit_words<bit_op::andnot_op>(m_words.data(), other.m_words.data(), m_words.size());
+    return *this;
+}
+
+template <int A, typename M, typename G>
+void fast_bit_vector<A,M,G>::flip() noexcept
+{
+    for (word_type& word : m_words)
+        word = ~word;
+    clear_tail();
+}
+
+// Queries
+
+template <int A, typename M, typename G>
+typename fast_bit_vector<A,M,G>::size_type fast_bit_vector<A,M,G>::popcount() const noexcept
+{
+    return bit_popcount_words(m_words.data(), m_words.size());
+}
+
+template <int A, typename M, typename G>
+bool fast_bit_vector<A,M,G>::any() const noexcept
+{
+    return find_first() != npos;
+}
+
+template <int A, typename M, typename G>
+bool fast_bit_vector<A,M,G>::none() const noexcept
+{
+    return !any();
+}
+
+template <int A, typename M, typename G>
+typename fast_bit_vector<A,M,G>::size_type fast_bit_vector<A,M,G>::find_first() const noexcept
+{
+    const word_type* words = m_words.data();
+    const size_type count = m_words.size();
+
+    for (size_type i = 0; i < count; i++)
+    {
+        if (words[i])
+            return i * word_bits + bit_first(words[i]);
+    }
+    return npos;
+}
+
+template <int A, typename M, typename G>
+typename fast_bit_vector<A,M,G>::size_type fast_bit_vector<A,M,G>::find_next(size_type pos) const noexcept
+{
+    if (pos + 1 >= m_size)
+        return npos;
+
+    pos++;
+    size_type index = pos / word_bits;
+
+    // The rest of the word holding pos, then whole words
+    word_type word = m_words[index] & (~word_type(0) << (pos % word_bits));
+    const size_type count = m_words.size();
+
+    for (;;)
+    {
+        if (word)
+            return index * word_bits + bit_first(word);
+        if (++index == count)
+            return npos;
+        word = m_words[index];
+    }
+}
+
+template <int A, typename M, typename G>
+template< class F >
+void fast_bit_vector<A,M,G>::for_each_set(F f) const
+{
+    const word_type* words = m_words.data();
+    const size_type count = m_words.size();
+
+    for (size_type i = 0; i < count; i++)
+    {
+        for (word_type word = words[i]; word; word &= word - 1)
+            f(i * word_bits + bit_first(word));
+    }
+}
+
+template <int A, typename M, typename G>
+bool fast_bit_vector<A,M,G>::operator==(const fast_bit_vector& other) const noexcept
+{
+    return m_size == other.m_size &&
+           (m_size == 0 || std::memcmp(m_words.data(), other.m_words.data(), m_words.size() * sizeof(word_type)) == 0);
+}
+
+template <int A, typename M, typename G>
+bool fast_bit_vector<A,M,G>::operator!=(const fast_bit_vector& other) const noexcept
+{
+    return !(*this == other);
+}
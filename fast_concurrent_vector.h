@@ -0,0 +1,424 @@
+//
+// Append-only fast_vector sibling for many concurrent producers
+//
+// Advanced & fixed version by Marian Krivos
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstdlib> // std::abort()
+
+#include "fast_vector.h"
+
+/**
+ * Lock-free append-only vector. Producers claim slots with a single fetch_add and construct
+ * the element in place, the storage is a list of geometrically growing segments which are
+ * never relocated, so readers may keep references while others append. A missing segment
+ * is allocated by whoever needs it first and installed by compare & swap, losing racers
+ * free their copy, nobody waits for a lock.
+ *
+ * Every slot has a ready flag, size() is the published watermark: the longest prefix of
+ * fully constructed elements. Readers see only [0, size()), elements behind a slower
+ * producer become visible as soon as it finishes. The element constructor must not throw,
+ * an abandoned slot would stop the watermark. For the same reason a segment allocation failing
+ * in push_back(), emplace_back() or append() aborts, the slots are claimed already. reserve()
+ * up front reports the failure like fast_vector does and leaves the producers nothing to
+ * allocate. clear() and the destructor need exclusive access.
+ */
+template <typename T, std::size_t FirstBits = 10, int A = 16, typename M = malloc_allocator>
+class fast_concurrent_vector
+{
+public:
+    using size_type = std::size_t;
+    using value_type = T;
+
+    fast_concurrent_vector() = default;
+    fast_concurrent_vector(const fast_concurrent_vector&) = delete;
+    fast_concurrent_vector& operator=(const fast_concurrent_vector&) = delete;
+
+    ~fast_concurrent_vector();
+
+    // Element access, positions below size() only
+
+    T& operator[](size_type pos);
+    const T& operator[](size_type pos) const;
+
+    // Capacity
+
+    bool empty() const noexcept;
+    // The published size, acquire ordered, so the elements below are visible to the caller
+    size_type size() const noexcept;
+    // Allocates the segments for new_cap elements up front, throws std::bad_alloc on failure
+    void reserve(size_type new_cap);
+
+    // Modifiers, safe to call from any number of threads
+
+    size_type push_back(const T& value);
+    size_type push_back(T&& value);
+
+    // Returns the position of the new element
+    template< class... Args >
+    size_type emplace_back(Args&&... args);
+
+    // Claims count slots at once and copies the values into them, returns the first position
+    size_type append(const T values[], size_type count);
+
+    // Not thread safe
+    void clear() noexcept;
+
+    static constexpr size_type first_segment_size = size_type(1) << FirstBits;
+    static constexpr size_type alignment = A > int(alignof(T)) ? size_type(A) : alignof(T);
+
+    static_assert(FirstBits > 0 && FirstBits < sizeof(size_type) * 8, "Segment size out of range");
+    static_assert(A > 0 && (A & (A - 1)) == 0, "Alignment must be a power of two");
+    static_assert(std::atomic<unsigned char>::is_always_lock_free, "Lock-free byte flags are required");
+
+    using allocator_type = M;
+
+private:
+    using flag = std::atomic<unsigned char>;
+
+    // Segment 0 holds first_segment_size elements, segment k > 0 the next first_segment_size << (k - 1)
+    static constexpr size_type max_segments = sizeof(size_type) * 8 - FirstBits + 1;
+
+    static size_type segment_of(size_type pos) noexcept;
+    static size_type segment_start(size_type segment) noexcept;
+    static size_type segment_length(size_type segment) noexcept;
+    static size_type segment_bytes(size_type segment) noexcept;
+    static flag* ready_flags(T* items, size_type segment) noexcept;
+
+    // Returns nullptr when the segment cannot be allocated
+    T* segment(size_type index);
+    T* claim(size_type& pos);
+    size_type claim_range(size_type count);
+    void publish(size_type first, size_type count) noexcept;
+
+    std::atomic<T*> m_segments[max_segments] = {};
+    alignas(64) std::atomic<size_type> m_claimed{0};
+    alignas(64) std::atomic<size_type> m_published{0};
+};
+
+template <typename T, std::size_t FirstBits, int A, typename M>
+fast_concurrent_vector<T,FirstBits,A,M>::~fast_concurrent_vector()
+{
+    clear();
+
+    for (size_type index = 0; index < max_segments; index++)
+    {
+        if (T* items = m_segments[index].load(std::memory_order_relaxed))
+        {
+            M::deallocate(items, segment_bytes(index), alignment);
+        }
+    }
+}
+
+template <typename T, std::size_t FirstBits, int A, typename M>
+typename fast_concurrent_vector<T,FirstBits,A,M>::size_type fast_concurrent_vector<T,FirstBits,A,M>::segment_of(size_type pos) noexcept
+{
+    // The bit width of pos >> FirstBits
+    size_type high = pos >> FirstBits;
+#if defined(__GNUC__) || defined(__clang__)
+    return high ? size_type(sizeof(unsigned long long) * 8 - __builtin_clzll(high)) : 0;
+#else
+    size_type width = 0;
+    while (high)
+    {
+        high >>= 1;
+        width++;
+    }
+    return width;
+#endif
+}
+
+template <typename T, std::size_t FirstBits, int A, typename M>
+typename fast_concurrent_vector<T,FirstBits,A,M>::size_type fast_concurrent_vector<T,FirstBits,A,M>::segment_start(size_type segment) noexcept
+{
+    return segment ? first_segment_size << (segment - 1) : 0;
+}
+
+template <typename T, std::size_t FirstBits, int A, typename M>
+typename fast_concurrent_vector<T,FirstBits,A,M>::size_type fast_concurrent_vector<T,FirstBits,A,M>::segment_length(size_type segment) noexcept
+{
+    return segment ? first_segment_size << (segment - 1) : first_segment_size;
+}
+
+template <typename T, std::size_t FirstBits, int A, typename M>
+typename fast_concurrent_vector<T,FirstBits,A,M>::size_type fast_concurrent_vector<T,FirstBits,A,M>::segment_bytes(size_type segment) noexcept
+{
+    // The elements followed by their ready flags
+    return segment_length(segment) * (sizeof(T) + sizeof(flag));
+}
+
+template <typename T, std::size_t FirstBits, int A, typename M>
+typename fast_concurrent_vector<T,FirstBits,A,M>::flag* fast_concurrent_vector<T,FirstBits,A,M>::ready_flags(T* items, size_type segment) noexcept
+{
+    return reinterpret_cast<flag*>(items + segment_length(segment));
+}
+
+template <typename T, std::size_t FirstBits, int A, typename M>
+T* fast_concurrent_vector<T,FirstBits,A,M>::segment(size_type index)
+{
+    T* items = m_segments[index].load(std::memory_order_acquire);
+    if (items)
+    {
+        return items;
+    }
+
+    items = reinterpret_cast<T*>(M::allocate(segment_bytes(index), alignment));
+    if (!items)
+    {
+        return nullptr;
+    }
+
+    flag* flags = ready_flags(items, index);
+    for (size_type i = 0, count = segment_length(index); i < count; i++)
+    {
+        new (flags + i) flag(0);
+    }
+
+    // Another producer may have installed the segment meanwhile, then its copy is used
+    T* expected = nullptr;
+    if (!m_segments[index].compare_exchange_strong(expected, items, std::memory_order_acq_rel, std::memory_order_acquire))
+    {
+        M::deallocate(items, segment_bytes(index), alignment);
+        return expected;
+    }
+
+    return items;
+}
+
+template <typename T, std::size_t FirstBits, int A, typename M>
+T* fast_concurrent_vector<T,FirstBits,A,M>::claim(size_type& pos)
+{
+    pos = m_claimed.fetch_add(1, std::memory_order_relaxed);
+
+    // The slot is taken, unwinding would leave it unpublished and stop the watermark
+    size_type index = segment_of(pos);
+    T* items = segment(index);
+    if (!items)
+    {
+        std::abort();
+    }
+
+    return items + (pos - segment_start(index));
+}
+
+template <typename T, std::size_t FirstBits, int A, typename M>
+typename fast_concurrent_vector<T,FirstBits,A,M>::size_type fast_concurrent_vector<T,FirstBits,A,M>::claim_range(size_type count)
+{
+    size_type first = m_claimed.fetch_add(count, std::memory_order_relaxed);
+
+    for (size_type index = segment_of(first), last = segment_of(first + count - 1); index <= last; index++)
+    {
+        if (!segment(index))
+        {
+            std::abort();
+        }
+    }
+
+    return first;
+}
+
+template <typename T, std::size_t FirstBits, int A, typename M>
+void fast_concurrent_vector<T,FirstBits,A,M>::publish(size_type first, size_type count) noexcept
+{
+    size_type last = first + count;
+    size_type published = m_published.load(std::memory_order_seq_cst);
+
+    if (published == first)
+    {
+        // Every other producer stops at the unfinished range, nobody moves the watermark meanwhile
+        m_published.store(last, std::memory_order_seq_cst);
+        published = last;
+    }
+    else
+    {
+        for (size_type pos = first; pos < last; pos++)
+        {
+            size_type index = segment_of(pos);
+            T* items = m_segments[index].load(std::memory_order_relaxed);
+            ready_flags(items, index)[pos - segment_start(index)].store(1, std::memory_order_release);
+        }
+
+        // Orders the flags before the watermark check, pairs with the producer moving the watermark
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        published = m_published.load(std::memory_order_seq_cst);
+        if (published >= last)
+            return;
+    }
+
+    // Moves the watermark over every ready slot. A producer blocked by an unfinished slot
+    // leaves, the owner of that slot sees the flags once it is done and carries on.
+    for (;;)
+    {
+        size_type end = published;
+
+        for (;;)
+        {
+            size_type index = segment_of(end);
+            T* items = m_segments[index].load(std::memory_order_acquire);
+            if (!items)
+                break;
+
+            flag* flags = ready_flags(items, index);
+            size_type offset = end - segment_start(index);
+            size_type length = segment_length(index);
+
+            while (offset < length && flags[offset].load(std::memory_order_seq_cst))
+                offset++;
+
+            end = segment_start(index) + offset;
+            if (offset < length)
+                break;
+        }
+
+        if (end == published)
+            return;
+
+        if (m_published.compare_exchange_weak(published, end, std::memory_order_seq_cst) || published >= last)
+            return;
+    }
+}
+
+// Element access
+
+template <typename T, std::size_t FirstBits, int A, typename M>
+T& fast_concurrent_vector<T,FirstBits,A,M>::operator[](size_type pos)
+{
+    assert(pos < m_published.load(std::memory_order_relaxed) && "Position is out of range");
+
+    size_type index = segment_of(pos);
+    return m_segments[index].load(std::memory_order_relaxed)[pos - segment_start(index)];
+}
+
+template <typename T, std::size_t FirstBits, int A, typename M>
+const T& fast_concurrent_vector<T,FirstBits,A,M>::operator[](size_type pos) const
+{
+    assert(pos < m_published.load(std::memory_order_relaxed) && "Position is out of range");
+
+    size_type index = segment_of(pos);
+    return m_segments[index].load(std::memory_order_relaxed)[pos - segment_start(index)];
+}
+
+// Capacity
+
+template <typename T, std::size_t FirstBits, int A, typename M>
+bool fast_concurrent_vector<T,FirstBits,A,M>::empty() const noexcept
+{
+    return size() == 0;
+}
+
+template <typename T, std::size_t FirstBits, int A, typename M>
+typename fast_concurrent_vector<T,FirstBits,A,M>::size_type fast_concurrent_vector<T,FirstBits,A,M>::size() const noexcept
+{
+    return m_published.load(std::memory_order_acquire);
+}
+
+template <typename T, std::size_t FirstBits, int A, typename M>
+void fast_concurrent_vector<T,FirstBits,A,M>::reserve(size_type new_cap)
+{
+    if (new_cap == 0)
+        return;
+
+    for (size_type index = 0, last = segment_of(new_cap - 1); index <= last; index++)
+    {
+        if (!segment(index))
+        {
+            fast_vector_out_of_memory();
+        }
+    }
+}
+
+// Modifiers
+
+template <typename T, std::size_t FirstBits, int A, typename M>
+typename fast_concurrent_vector<T,FirstBits,A,M>::size_type fast_concurrent_vector<T,FirstBits,A,M>::push_back(const T& value)
+{
+    size_type pos;
+    new (claim(pos)) T(value);
+    publish(pos, 1);
+    return pos;
+}
+
+template <typename T, std::size_t FirstBits, int A, typename M>
+typename fast_concurrent_vector<T,FirstBits,A,M>::size_type fast_concurrent_vector<T,FirstBits,A,M>::push_back(T&& value)
+{
+    size_type pos;
+    new (claim(pos)) T(std::move(value));
+    publish(pos, 1);
+    return pos;
+}
+
+template <typename T, std::size_t FirstBits, int A, typename M>
+template< class... Args >
+typename fast_concurrent_vector<T,FirstBits,A,M>::size_type fast_concurrent_vector<T,FirstBits,A,M>::emplace_back(Args&&... args)
+{
+    size_type pos;
+    new (claim(pos)) T(std::forward<Args>(args)...);
+    publish(pos, 1);
+    return pos;
+}
+
+template <typename T, std::size_t FirstBits, int A, typename M>
+typename fast_concurrent_vector<T,FirstBits,A,M>::size_type fast_concurrent_vector<T,FirstBits,A,M>::append(const T values[], size_type count)
+{
+    if (count == 0)
+        return m_claimed.load(std::memory_order_relaxed);
+
+    size_type first = claim_range(count);
+
+    for (size_type pos = first, last = first + count; pos < last;)
+    {
+        size_type index = segment_of(pos);
+        size_type offset = pos - segment_start(index);
+        size_type part = segment_length(index) - offset < last - pos ? segment_length(index) - offset : last - pos;
+        T* items = m_segments[index].load(std::memory_order_relaxed) + offset;
+
+        if constexpr (std::is_trivial_v<T>)
+        {
+            std::memcpy(static_cast<void*>(items), values, sizeof(T) * part);
+        }
+        else
+        {
+            copy_range(values, values + part, items);
+        }
+
+        values += part;
+        pos += part;
+    }
+
+    publish(first, count);
+    return first;
+}
+
+template <typename T, std::size_t FirstBits, int A, typename M>
+void fast_concurrent_vector<T,FirstBits,A,M>::clear() noexcept
+{
+    size_type count = m_published.load(std::memory_order_relaxed);
+
+    for (size_type index = 0; index < max_segments; index++)
+    {
+        T* items = m_segments[index].load(std::memory_order_relaxed);
+        if (!items)
+            continue;
+
+        size_type first = segment_start(index);
+        size_type length = segment_length(index);
+        size_type used = count > first ? (count - first < length ? count - first : length) : 0;
+
+        if constexpr (!std::is_trivial_v<T>)
+        {
+            destruct_range(items, items + used);
+        }
+
+        flag* flags = ready_flags(items, index);
+        for (size_type i = 0; i < used; i++)
+        {
+            flags[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    m_claimed.store(0, std::memory_order_relaxed);
+    m_published.store(0, std::memory_order_release);
+}
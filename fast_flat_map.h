@@ -0,0 +1,562 @@
+//
+// Sorted associative map on two fast_vectors, the node free std::map replacement
+//
+// Advanced & fixed version by Marian Krivos
+//
+
+#pragma once
+
+#include "fast_flat_set.h"
+
+/**
+ * Map of unique keys kept sorted, the keys and the mapped values in two parallel fast_vectors.
+ * Lookups binary search the keys alone, so a cache line holds as many keys as fit regardless
+ * of the value size, and the values are touched only once the key is found. insert() and
+ * erase() shift both tails (memmove for the trivially relocatable types), insert_range()
+ * adds a whole batch in one sort and merge pass. Iterators yield a std::pair of references
+ * to the key and the value, any insertion or erasure invalidates them.
+ */
+template <typename Key, typename T, typename Compare = std::less<Key>, int A = 16, typename M = malloc_allocator, typename G = factor_growth<>>
+class fast_flat_map
+{
+    template <typename U>
+    class basic_iterator;
+
+public:
+    using size_type = std::size_t;
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<Key, T>;
+    using key_compare = Compare;
+    using key_storage = fast_vector<Key, false, A, M, G>;
+    using value_storage = fast_vector<T, false, A, M, G>;
+    using iterator = basic_iterator<T>;
+    using const_iterator = basic_iterator<const T>;
+
+    fast_flat_map() = default;
+    explicit fast_flat_map(const Compare& comp);
+    fast_flat_map(std::initializer_list<value_type> items, const Compare& comp = Compare());
+
+    template< class InputIt, typename = std::enable_if_t<!std::is_integral_v<InputIt>> >
+    fast_flat_map(InputIt first, InputIt last, const Compare& comp = Compare());
+
+    // Element access
+
+    // Inserts a value initialized T when the key is missing
+    T& operator[](const Key& key);
+
+#if !defined(FAST_VECTOR_NO_EXCEPTIONS)
+    T& at(const Key& key);
+    const T& at(const Key& key) const;
+#endif
+
+    // Iterators
+
+    iterator begin() noexcept;
+    const_iterator begin() const noexcept;
+
+    iterator end() noexcept;
+    const_iterator end() const noexcept;
+
+    // The columns, keys sorted and values in the same order
+
+    fast_span<const Key> keys() const noexcept;
+    fast_span<T> values() noexcept;
+    fast_span<const T> values() const noexcept;
+
+    // Capacity
+
+    bool empty() const noexcept;
+    size_type size() const noexcept;
+    void reserve(size_type new_cap);
+    size_type capacity() const noexcept;
+    void shrink_to_fit();
+
+    // Lookup, end() when there is no such key
+
+    iterator find(const Key& key);
+    const_iterator find(const Key& key) const;
+    bool contains(const Key& key) const;
+    size_type count(const Key& key) const;
+
+    iterator lower_bound(const Key& key);
+    const_iterator lower_bound(const Key& key) const;
+    iterator upper_bound(const Key& key);
+    const_iterator upper_bound(const Key& key) const;
+
+    // Modifiers
+
+    void clear() noexcept;
+
+    // The item is added unless its key is there already, second tells which happened
+    std::pair<iterator, bool> insert(const value_type& item);
+    std::pair<iterator, bool> insert(value_type&& item);
+
+    // The value is constructed from args only when the key is missing
+    template< class... Args >
+    std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args);
+
+    template< class V >
+    std::pair<iterator, bool> insert_or_assign(const Key& key, V&& value);
+
+    // Sorts the batch by key, drops the keys present already (and the later duplicates within
+    // the batch) and merges the rest in one pass, O(n + m log m) instead of m shifting inserts
+    template< class InputIt >
+    void insert_range(InputIt first, InputIt last);
+    void insert_range(std::initializer_list<value_type> items);
+
+    // Returns the number of removed items (0 or 1)
+    size_type erase(const Key& key);
+    // Returns the position following the removed item
+    iterator erase(const_iterator pos);
+
+    static void swap(fast_flat_map& a, fast_flat_map& b) noexcept;
+
+    using allocator_type = M;
+    using growth_policy = G;
+
+private:
+    size_type lower_index(const Key& key) const;
+    // Index of the key, size() when missing
+    size_type find_index(const Key& key) const;
+    // Makes room for one more item in both columns up front, so the two inserts that follow
+    // cannot run out of memory halfway and leave the keys and the values out of step
+    void grow_for_insert();
+
+    key_storage m_keys;
+    value_storage m_values;
+    Compare m_comp;
+};
+
+/**
+ * Walks the keys and the values in step. Dereferencing gives std::pair<const Key&, U&>,
+ * which structured bindings take apart: for (auto [key, value] : map).
+ */
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+template <typename U>
+class fast_flat_map<Key,T,Compare,A,M,G>::basic_iterator
+{
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::pair<Key, std::remove_const_t<U>>;
+    using difference_type = std::ptrdiff_t;
+    using reference = std::pair<const Key&, U&>;
+
+    // operator-> needs an address, the pair of references lives in the proxy
+    struct pointer
+    {
+        reference item;
+        const reference* operator->() const noexcept { return &item; }
+    };
+
+    basic_iterator() = default;
+
+    basic_iterator(const Key* key, U* value) noexcept :
+        m_key(key),
+        m_value(value)
+    {
+    }
+
+    // iterator converts to const_iterator
+    template <typename V, typename = std::enable_if_t<std::is_same_v<const V, U>>>
+    basic_iterator(const basic_iterator<V>& other) noexcept :
+        m_key(other.m_key),
+        m_value(other.m_value)
+    {
+    }
+
+    reference operator*() const noexcept { return {*m_key, *m_value}; }
+    pointer operator->() const noexcept { return {**this}; }
+
+    const Key& key() const noexcept { return *m_key; }
+    U& value() const noexcept { return *m_value; }
+
+    basic_iterator& operator++() noexcept
+    {
+        ++m_key;
+        ++m_value;
+        return *this;
+    }
+
+    basic_iterator operator++(int) noexcept
+    {
+        basic_iterator previous = *this;
+        ++*this;
+        return previous;
+    }
+
+    basic_iterator& operator--() noexcept
+    {
+        --m_key;
+        --m_value;
+        return *this;
+    }
+
+    bool operator==(const basic_iterator& other) const noexcept { return m_key == other.m_key; }
+    bool operator!=(const basic_iterator& other) const noexcept { return m_key != other.m_key; }
+
+private:
+    friend class fast_flat_map;
+    template <typename V>
+    friend class basic_iterator;
+
+    const Key* m_key = nullptr;
+    U* m_value = nullptr;
+};
+
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+fast_flat_map<Key,T,Compare,A,M,G>::fast_flat_map(const Compare& comp) :
+    m_comp(comp)
+{
+}
+
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+fast_flat_map<Key,T,Compare,A,M,G>::fast_flat_map(std::initializer_list<value_type> items, const Compare& comp) :
+    m_comp(comp)
+{
+    insert_range(items.begin(), items.end());
+}
+
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+template< class InputIt, typename >
+fast_flat_map<Key,T,Compare,A,M,G>::fast_flat_map(InputIt first, InputIt last, const Compare& comp) :
+    m_comp(comp)
+{
+    insert_range(first, last);
+}
+
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+void fast_flat_map<Key,T,Compare,A,M,G>::swap(fast_flat_map& a, fast_flat_map& b) noexcept
+{
+    key_storage::swap(a.m_keys, b.m_keys);
+    value_storage::swap(a.m_values, b.m_values);
+    std::swap(a.m_comp, b.m_comp);
+}
+
+// Element access
+
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+T& fast_flat_map<Key,T,Compare,A,M,G>::operator[](const Key& key)
+{
+    return try_emplace(key).first.value();
+}
+
+#if !defined(FAST_VECTOR_NO_EXCEPTIONS)
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+T& fast_flat_map<Key,T,Compare,A,M,G>::at(const Key& key)
+{
+    size_type index = find_index(key);
+    if (index == size())
+        throw std::out_of_range("fast_flat_map::at");
+    return m_values[index];
+}
+
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+const T& fast_flat_map<Key,T,Compare,A,M,G>::at(const Key& key) const
+{
+    size_type index = find_index(key);
+    if (index == size())
+        throw std::out_of_range("fast_flat_map::at");
+    return m_values[index];
+}
+#endif
+
+// Iterators
+
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+typename fast_flat_map<Key,T,Compare,A,M,G>::iterator fast_flat_map<Key,T,Compare,A,M,G>::begin() noexcept
+{
+    return {m_keys.data(), m_values.data()};
+}
+
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+typename fast_flat_map<Key,T,Compare,A,M,G>::const_iterator fast_flat_map<Key,T,Compare,A,M,G>::begin() const noexcept
+{
+    return {m_keys.data(), m_values.data()};
+}
+
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+typename fast_flat_map<Key,T,Compare,A,M,G>::iterator fast_flat_map<Key,T,Compare,A,M,G>::end() noexcept
+{
+    return {m_keys.end(), m_values.end()};
+}
+
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+typename fast_flat_map<Key,T,Compare,A,M,G>::const_iterator fast_flat_map<Key,T,Compare,A,M,G>::end() const noexcept
+{
+    return {m_keys.end(), m_values.end()};
+}
+
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+fast_span<const Key> fast_flat_map<Key,T,Compare,A,M,G>::keys() const noexcept
+{
+    return {m_keys.data(), m_keys.size()};
+}
+
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+fast_span<T> fast_flat_map<Key,T,Compare,A,M,G>::values() noexcept
+{
+    return {m_values.data(), m_values.size()};
+}
+
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+fast_span<const T> fast_flat_map<Key,T,Compare,A,M,G>::values() const noexcept
+{
+    return {m_values.data(), m_values.size()};
+}
+
+// Capacity
+
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+bool fast_flat_map<Key,T,Compare,A,M,G>::empty() const noexcept
+{
+    return m_keys.empty();
+}
+
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+typename fast_flat_map<Key,T,Compare,A,M,G>::size_type fast_flat_map<Key,T,Compare,A,M,G>::size() const noexcept
+{
+    return m_keys.size();
+}
+
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+void fast_flat_map<Key,T,Compare,A,M,G>::reserve(size_type new_cap)
+{
+    m_keys.reserve(new_cap);
+    m_values.reserve(new_cap);
+}
+
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+typename fast_flat_map<Key,T,Compare,A,M,G>::size_type fast_flat_map<Key,T,Compare,A,M,G>::capacity() const noexcept
+{
+    return m_keys.capacity() < m_values.capacity() ? m_keys.capacity() : m_values.capacity();
+}
+
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+void fast_flat_map<Key,T,Compare,A,M,G>::shrink_to_fit()
+{
+    m_keys.shrink_to_fit();
+    m_values.shrink_to_fit();
+}
+
+// Lookup
+
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+typename fast_flat_map<Key,T,Compare,A,M,G>::size_type fast_flat_map<Key,T,Compare,A,M,G>::lower_index(const Key& key) const
+{
+    return size_type(flat_lower_bound(m_keys.data(), m_keys.size(), key, m_comp) - m_keys.data());
+}
+
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+typename fast_flat_map<Key,T,Compare,A,M,G>::size_type fast_flat_map<Key,T,Compare,A,M,G>::find_index(const Key& key) const
+{
+    size_type index = lower_index(key);
+    return index != size() && !m_comp(key, m_keys[index]) ? index : size();
+}
+
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+typename fast_flat_map<Key,T,Compare,A,M,G>::iterator fast_flat_map<Key,T,Compare,A,M,G>::find(const Key& key)
+{
+    size_type index = find_index(key);
+    return {m_keys.data() + index, m_values.data() + index};
+}
+
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+typename fast_flat_map<Key,T,Compare,A,M,G>::const_iterator fast_flat_map<Key,T,Compare,A,M,G>::find(const Key& key) const
+{
+    size_type index = find_index(key);
+    return {m_keys.data() + index, m_values.data() + index};
+}
+
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+bool fast_flat_map<Key,T,Compare,A,M,G>::contains(const Key& key) const
+{
+    return find_index(key) != size();
+}
+
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+typename fast_flat_map<Key,T,Compare,A,M,G>::size_type fast_flat_map<Key,T,Compare,A,M,G>::count(const Key& key) const
+{
+    return contains(key);
+}
+
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+typename fast_flat_map<Key,T,Compare,A,M,G>::iterator fast_flat_map<Key,T,Compare,A,M,G>::lower_bound(const Key& key)
+{
+    size_type index = lower_index(key);
+    return {m_keys.data() + index, m_values.data() + index};
+}
+
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+typename fast_flat_map<Key,T,Compare,A,M,G>::const_iterator fast_flat_map<Key,T,Compare,A,M,G>::lower_bound(const Key& key) const
+{
+    size_type index = lower_index(key);
+    return {m_keys.data() + index, m_values.data() + index};
+}
+
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+typename fast_flat_map<Key,T,Compare,A,M,G>::iterator fast_flat_map<Key,T,Compare,A,M,G>::upper_bound(const Key& key)
+{
+    size_type index = lower_index(key);
+    index += index != size() && !m_comp(key, m_keys[index]);
+    return {m_keys.data() + index, m_values.data() + index};
+}
+
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+typename fast_flat_map<Key,T,Compare,A,M,G>::const_iterator fast_flat_map<Key,T,Compare,A,M,G>::upper_bound(const Key& key) const
+{
+    size_type index = lower_index(key);
+    index += index != size() && !m_comp(key, m_keys[index]);
+    return {m_keys.data() + index, m_values.data() + index};
+}
+
+// Modifiers
+
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+void fast_flat_map<Key,T,Compare,A,M,G>::clear() noexcept
+{
+    m_keys.clear();
+    m_values.clear();
+}
+
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+void fast_flat_map<Key,T,Compare,A,M,G>::grow_for_insert()
+{
+    if (m_keys.size() == m_keys.capacity())
+        m_keys.reserve(G::next_capacity(m_keys.capacity(), m_keys.size() + 1, sizeof(Key)));
+
+    if (m_values.size() == m_values.capacity())
+        m_values.reserve(G::next_capacity(m_values.capacity(), m_values.size() + 1, sizeof(T)));
+}
+
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+template< class... Args >
+std::pair<typename fast_flat_map<Key,T,Compare,A,M,G>::iterator, bool> fast_flat_map<Key,T,Compare,A,M,G>::try_emplace(const Key& key, Args&&... args)
+{
+    size_type index = lower_index(key);
+
+    if (index != size() && !m_comp(key, m_keys[index]))
+        return {iterator(m_keys.data() + index, m_values.data() + index), false};
+
+    // The key and the value are built before the columns grow, the arguments may refer into
+    // them, and nothing can fail once the two columns are out of step
+    Key copy(key);
+    T value(std::forward<Args>(args)...);
+    grow_for_insert();
+    m_values.emplace(m_values.begin() + index, std::move(value));
+    m_keys.insert(m_keys.begin() + index, std::move(copy));
+
+    return {iterator(m_keys.data() + index, m_values.data() + index), true};
+}
+
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+std::pair<typename fast_flat_map<Key,T,Compare,A,M,G>::iterator, bool> fast_flat_map<Key,T,Compare,A,M,G>::insert(const value_type& item)
+{
+    return try_emplace(item.first, item.second);
+}
+
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+std::pair<typename fast_flat_map<Key,T,Compare,A,M,G>::iterator, bool> fast_flat_map<Key,T,Compare,A,M,G>::insert(value_type&& item)
+{
+    return try_emplace(item.first, std::move(item.second));
+}
+
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+template< class V >
+std::pair<typename fast_flat_map<Key,T,Compare,A,M,G>::iterator, bool> fast_flat_map<Key,T,Compare,A,M,G>::insert_or_assign(const Key& key, V&& value)
+{
+    std::pair<iterator, bool> result = try_emplace(key, std::forward<V>(value));
+
+    if (!result.second)
+        result.first.value() = std::forward<V>(value);
+
+    return result;
+}
+
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+template< class InputIt >
+void fast_flat_map<Key,T,Compare,A,M,G>::insert_range(InputIt first, InputIt last)
+{
+    fast_vector<value_type, false, A, M, G> batch;
+
+    if constexpr (std::is_base_of_v<std::random_access_iterator_tag, typename std::iterator_traits<InputIt>::iterator_category>)
+    {
+        batch.reserve(size_type(last - first));
+    }
+
+    for (; first != last; ++first)
+        batch.push_back(*first);
+
+    if (batch.empty())
+        return;
+
+    // Stable, so the first of the equal keys in the batch is the one kept
+    if constexpr (is_flat_default_compare_v<Compare, Key>)
+        batch.stable_sort_by_key(&value_type::first);
+    else
+        batch.stable_sort([this](const value_type& a, const value_type& b) { return m_comp(a.first, b.first); });
+
+    key_storage merged_keys;
+    value_storage merged_values;
+    merged_keys.reserve(m_keys.size() + batch.size());
+    merged_values.reserve(m_keys.size() + batch.size());
+
+    Key* existing = m_keys.begin();
+    Key* existing_end = m_keys.end();
+    T* existing_value = m_values.begin();
+
+    for (value_type& item : batch)
+    {
+        if (!merged_keys.empty() && !m_comp(merged_keys.back(), item.first))
+            continue;
+
+        // The existing items ordered before this one go over in a single run
+        Key* run_end = const_cast<Key*>(flat_gallop_lower_bound<Key>(existing, existing_end, item.first, m_comp));
+        flat_append_run(merged_keys, existing, run_end);
+        flat_append_run(merged_values, existing_value, existing_value + (run_end - existing));
+        existing_value += run_end - existing;
+        existing = run_end;
+
+        // Present already, the existing item stays
+        if (existing != existing_end && !m_comp(item.first, *existing))
+            continue;
+
+        merged_keys.push_back(std::move(item.first));
+        merged_values.push_back(std::move(item.second));
+    }
+
+    flat_append_run(merged_keys, existing, existing_end);
+    flat_append_run(merged_values, existing_value, m_values.end());
+
+    key_storage::swap(m_keys, merged_keys);
+    value_storage::swap(m_values, merged_values);
+}
+
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+void fast_flat_map<Key,T,Compare,A,M,G>::insert_range(std::initializer_list<value_type> items)
+{
+    insert_range(items.begin(), items.end());
+}
+
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+typename fast_flat_map<Key,T,Compare,A,M,G>::size_type fast_flat_map<Key,T,Compare,A,M,G>::erase(const Key& key)
+{
+    size_type index = find_index(key);
+
+    if (index == size())
+        return 0;
+
+    m_keys.erase(m_keys.begin() + index);
+    m_values.erase(m_values.begin() + index);
+    return 1;
+}
+
+template <typename Key, typename T, typename Compare, int A, typename M, typename G>
+typename fast_flat_map<Key,T,Compare,A,M,G>::iterator fast_flat_map<Key,T,Compare,A,M,G>::erase(const_iterator pos)
+{
+    size_type index = size_type(pos.m_key - m_keys.data());
+
+    m_keys.erase(m_keys.begin() + index);
+    m_values.erase(m_values.begin() + index);
+    return {m_keys.data() + index, m_values.data() + index};
+}
@@ -0,0 +1,378 @@
+//
+// Sorted associative set on a fast_vector, the node free std::set replacement
+//
+// Advanced & fixed version by Marian Krivos
+//
+
+#pragma once
+
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <utility>
+
+#include "fast_vector.h"
+
+// Search and merge helpers of the flat containers
+
+/**
+ * First of the count sorted keys not ordered before key. The halving step is a conditional
+ * move instead of a branch, so the search does not suffer mispredictions on random lookups.
+ */
+template <typename Key, typename K, typename Compare>
+inline const Key* flat_lower_bound(const Key* first, std::size_t count, const K& key, const Compare& comp)
+{
+    if (count == 0)
+        return first;
+
+    while (count > 1)
+    {
+        const std::size_t half = count / 2;
+        first = comp(first[half], key) ? first + half : first;
+        count -= half;
+    }
+
+    return first + comp(*first, key);
+}
+
+/**
+ * flat_lower_bound() probing 1, 2, 4, ... elements ahead first, a key close to first is found
+ * in a few steps. Merging m sorted keys into n costs O(m log(n/m)) comparisons this way.
+ */
+template <typename Key, typename K, typename Compare>
+inline const Key* flat_gallop_lower_bound(const Key* first, const Key* last, const K& key, const Compare& comp)
+{
+    const std::size_t count = std::size_t(last - first);
+    std::size_t low = 0;
+    std::size_t step = 1;
+
+    while (step <= count && comp(first[step - 1], key))
+    {
+        low = step;
+        step *= 2;
+    }
+
+    const std::size_t high = step <= count ? step - 1 : count;
+    return flat_lower_bound(first + low, high - low, key, comp);
+}
+
+// Moves [first, last) to the back of out, by one memcpy for the trivially copyable types
+template <typename V, typename T>
+inline void flat_append_run(V& out, T* first, T* last)
+{
+    if constexpr (std::is_trivially_copyable_v<T>)
+    {
+        out.append(first, std::size_t(last - first));
+    }
+    else
+    {
+        for (; first != last; ++first)
+            out.push_back(std::move(*first));
+    }
+}
+
+// The comparators a radix sort of the keys agrees with
+template <typename Compare, typename Key>
+inline constexpr bool is_flat_default_compare_v = std::is_same_v<Compare, std::less<Key>> || std::is_same_v<Compare, std::less<>>;
+
+/**
+ * Set of unique keys kept sorted in one fast_vector. Lookups are binary searches over
+ * contiguous memory, insert() and erase() shift the tail (memmove for the trivially
+ * relocatable keys) and insert_range() adds a whole batch in one sort and merge pass,
+ * the way to build or rebuild a large set. Iterators are pointers to const keys, any
+ * insertion or erasure invalidates them.
+ */
+template <typename Key, typename Compare = std::less<Key>, int A = 16, typename M = malloc_allocator, typename G = factor_growth<>>
+class fast_flat_set
+{
+public:
+    using size_type = std::size_t;
+    using key_type = Key;
+    using value_type = Key;
+    using key_compare = Compare;
+    using storage_type = fast_vector<Key, false, A, M, G>;
+    using iterator = const Key*;
+    using const_iterator = const Key*;
+
+    fast_flat_set() = default;
+    explicit fast_flat_set(const Compare& comp);
+    fast_flat_set(std::initializer_list<Key> keys, const Compare& comp = Compare());
+
+    template< class InputIt, typename = std::enable_if_t<!std::is_integral_v<InputIt>> >
+    fast_flat_set(InputIt first, InputIt last, const Compare& comp = Compare());
+
+    // Iterators
+
+    const Key* begin() const noexcept;
+    const Key* end() const noexcept;
+
+    // The sorted keys
+    const storage_type& keys() const noexcept;
+
+    // Capacity
+
+    bool empty() const noexcept;
+    size_type size() const noexcept;
+    void reserve(size_type new_cap);
+    size_type capacity() const noexcept;
+    void shrink_to_fit();
+
+    // Lookup, end() when there is no such key
+
+    const Key* find(const Key& key) const;
+    bool contains(const Key& key) const;
+    size_type count(const Key& key) const;
+    const Key* lower_bound(const Key& key) const;
+    const Key* upper_bound(const Key& key) const;
+
+    // Modifiers
+
+    void clear() noexcept;
+
+    // The key is added unless an equal one is there already, second tells which happened
+    std::pair<const Key*, bool> insert(const Key& key);
+    std::pair<const Key*, bool> insert(Key&& key);
+
+    // Sorts the batch, drops its duplicates and the keys present already and merges the rest
+    // in one pass, O(n + m log m) instead of m shifting inserts
+    template< class InputIt >
+    void insert_range(InputIt first, InputIt last);
+    void insert_range(std::initializer_list<Key> keys);
+
+    // Returns the number of removed keys (0 or 1)
+    size_type erase(const Key& key);
+    // Returns the position following the removed key
+    const Key* erase(const Key* pos);
+
+    static void swap(fast_flat_set& a, fast_flat_set& b) noexcept;
+
+    using allocator_type = M;
+    using growth_policy = G;
+
+private:
+    template <typename K>
+    std::pair<const Key*, bool> insert_key(K&& key);
+
+    storage_type m_keys;
+    Compare m_comp;
+};
+
+template <typename Key, typename Compare, int A, typename M, typename G>
+fast_flat_set<Key,Compare,A,M,G>::fast_flat_set(const Compare& comp) :
+    m_comp(comp)
+{
+}
+
+template <typename Key, typename Compare, int A, typename M, typename G>
+fast_flat_set<Key,Compare,A,M,G>::fast_flat_set(std::initializer_list<Key> keys, const Compare& comp) :
+    m_comp(comp)
+{
+    insert_range(keys.begin(), keys.end());
+}
+
+template <typename Key, typename Compare, int A, typename M, typename G>
+template< class InputIt, typename >
+fast_flat_set<Key,Compare,A,M,G>::fast_flat_set(InputIt first, InputIt last, const Compare& comp) :
+    m_comp(comp)
+{
+    insert_range(first, last);
+}
+
+template <typename Key, typename Compare, int A, typename M, typename G>
+void fast_flat_set<Key,Compare,A,M,G>::swap(fast_flat_set& a, fast_flat_set& b) noexcept
+{
+    storage_type::swap(a.m_keys, b.m_keys);
+    std::swap(a.m_comp, b.m_comp);
+}
+
+// Iterators
+
+template <typename Key, typename Compare, int A, typename M, typename G>
+const Key* fast_flat_set<Key,Compare,A,M,G>::begin() const noexcept
+{
+    return m_keys.begin();
+}
+
+template <typename Key, typename Compare, int A, typename M, typename G>
+const Key* fast_flat_set<Key,Compare,A,M,G>::end() const noexcept
+{
+    return m_keys.end();
+}
+
+template <typename Key, typename Compare, int A, typename M, typename G>
+const typename fast_flat_set<Key,Compare,A,M,G>::storage_type& fast_flat_set<Key,Compare,A,M,G>::keys() const noexcept
+{
+    return m_keys;
+}
+
+// Capacity
+
+template <typename Key, typename Compare, int A, typename M, typename G>
+bool fast_flat_set<Key,Compare,A,M,G>::empty() const noexcept
+{
+    return m_keys.empty();
+}
+
+template <typename Key, typename Compare, int A, typename M, typename G>
+typename fast_flat_set<Key,Compare,A,M,G>::size_type fast_flat_set<Key,Compare,A,M,G>::size() const noexcept
+{
+    return m_keys.size();
+}
+
+template <typename Key, typename Compare, int A, typename M, typename G>
+void fast_flat_set<Key,Compare,A,M,G>::reserve(size_type new_cap)
+{
+    m_keys.reserve(new_cap);
+}
+
+template <typename Key, typename Compare, int A, typename M, typename G>
+typename fast_flat_set<Key,Compare,A,M,G>::size_type fast_flat_set<Key,Compare,A,M,G>::capacity() const noexcept
+{
+    return m_keys.capacity();
+}
+
+template <typename Key, typename Compare, int A, typename M, typename G>
+void fast_flat_set<Key,Compare,A,M,G>::shrink_to_fit()
+{
+    m_keys.shrink_to_fit();
+}
+
+// Lookup
+
+template <typename Key, typename Compare, int A, typename M, typename G>
+const Key* fast_flat_set<Key,Compare,A,M,G>::lower_bound(const Key& key) const
+{
+    return flat_lower_bound(m_keys.data(), m_keys.size(), key, m_comp);
+}
+
+template <typename Key, typename Compare, int A, typename M, typename G>
+const Key* fast_flat_set<Key,Compare,A,M,G>::upper_bound(const Key& key) const
+{
+    const Key* position = lower_bound(key);
+    return position != end() && !m_comp(key, *position) ? position + 1 : position;
+}
+
+template <typename Key, typename Compare, int A, typename M, typename G>
+const Key* fast_flat_set<Key,Compare,A,M,G>::find(const Key& key) const
+{
+    const Key* position = lower_bound(key);
+    return position != end() && !m_comp(key, *position) ? position : end();
+}
+
+template <typename Key, typename Compare, int A, typename M, typename G>
+bool fast_flat_set<Key,Compare,A,M,G>::contains(const Key& key) const
+{
+    return find(key) != end();
+}
+
+template <typename Key, typename Compare, int A, typename M, typename G>
+typename fast_flat_set<Key,Compare,A,M,G>::size_type fast_flat_set<Key,Compare,A,M,G>::count(const Key& key) const
+{
+    return contains(key);
+}
+
+// Modifiers
+
+template <typename Key, typename Compare, int A, typename M, typename G>
+void fast_flat_set<Key,Compare,A,M,G>::clear() noexcept
+{
+    m_keys.clear();
+}
+
+template <typename Key, typename Compare, int A, typename M, typename G>
+template <typename K>
+std::pair<const Key*, bool> fast_flat_set<Key,Compare,A,M,G>::insert_key(K&& key)
+{
+    const Key* position = lower_bound(key);
+
+    if (position != end() && !m_comp(key, *position))
+        return {position, false};
+
+    return {m_keys.insert(position, std::forward<K>(key)), true};
+}
+
+template <typename Key, typename Compare, int A, typename M, typename G>
+std::pair<const Key*, bool> fast_flat_set<Key,Compare,A,M,G>::insert(const Key& key)
+{
+    return insert_key(key);
+}
+
+template <typename Key, typename Compare, int A, typename M, typename G>
+std::pair<const Key*, bool> fast_flat_set<Key,Compare,A,M,G>::insert(Key&& key)
+{
+    return insert_key(std::move(key));
+}
+
+template <typename Key, typename Compare, int A, typename M, typename G>
+template< class InputIt >
+void fast_flat_set<Key,Compare,A,M,G>::insert_range(InputIt first, InputIt last)
+{
+    storage_type batch;
+
+    if constexpr (std::is_base_of_v<std::random_access_iterator_tag, typename std::iterator_traits<InputIt>::iterator_category>)
+    {
+        batch.reserve(size_type(last - first));
+    }
+
+    for (; first != last; ++first)
+        batch.push_back(*first);
+
+    if (batch.empty())
+        return;
+
+    if constexpr (is_flat_default_compare_v<Compare, Key>)
+        batch.sort();
+    else
+        batch.sort(m_comp);
+
+    storage_type merged;
+    merged.reserve(m_keys.size() + batch.size());
+
+    Key* existing = m_keys.begin();
+    Key* existing_end = m_keys.end();
+
+    for (Key& key : batch)
+    {
+        // A duplicate within the batch, the sort put it right after its twin
+        if (!merged.empty() && !m_comp(merged.back(), key))
+            continue;
+
+        // The existing keys ordered before this one go over in a single run
+        Key* run_end = const_cast<Key*>(flat_gallop_lower_bound<Key>(existing, existing_end, key, m_comp));
+        flat_append_run(merged, existing, run_end);
+        existing = run_end;
+
+        // Present already, the existing key stays
+        if (existing != existing_end && !m_comp(key, *existing))
+            continue;
+
+        merged.push_back(std::move(key));
+    }
+
+    flat_append_run(merged, existing, existing_end);
+    storage_type::swap(m_keys, merged);
+}
+
+template <typename Key, typename Compare, int A, typename M, typename G>
+void fast_flat_set<Key,Compare,A,M,G>::insert_range(std::initializer_list<Key> keys)
+{
+    insert_range(keys.begin(), keys.end());
+}
+
+template <typename Key, typename Compare, int A, typename M, typename G>
+typename fast_flat_set<Key,Compare,A,M,G>::size_type fast_flat_set<Key,Compare,A,M,G>::erase(const Key& key)
+{
+    const Key* position = find(key);
+
+    if (position == end())
+        return 0;
+
+    m_keys.erase(position);
+    return 1;
+}
+
+template <typename Key, typename Compare, int A, typename M, typename G>
+const Key* fast_flat_set<Key,Compare,A,M,G>::erase(const Key* pos)
+{
+    return m_keys.erase(pos);
+}
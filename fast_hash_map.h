@@ -0,0 +1,791 @@
+//
+// Open addressing hash map on fast_vector storage, Swiss table style group probing
+//
+// Advanced & fixed version by Marian Krivos
+//
+
+#pragma once
+
+#include <algorithm> // std::fill()
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <utility>
+
+#include "fast_vector.h"
+
+#if defined(__SSE2__) && !defined(FAST_VECTOR_NO_SIMD)
+#include <emmintrin.h>
+#endif
+
+// Control bytes: an empty slot has the high bit set, a full one holds 7 bits of its hash
+inline constexpr std::uint8_t hash_ctrl_empty = 0x80;
+// Control bytes matched at once, the first hash_group_width - 1 are cloned past the end so
+// a group starting at any slot is one unaligned load
+inline constexpr std::size_t hash_group_width = 16;
+
+// Bit i set when the i-th control byte of the group equals h2
+inline std::uint32_t hash_group_match(const std::uint8_t* ctrl, std::uint8_t h2) noexcept
+{
+#if defined(__SSE2__) && !defined(FAST_VECTOR_NO_SIMD)
+    __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+    return std::uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(char(h2)))));
+#else
+    std::uint32_t mask = 0;
+    for (std::size_t i = 0; i < hash_group_width; i++)
+        mask |= std::uint32_t(ctrl[i] == h2) << i;
+    return mask;
+#endif
+}
+
+// Bit i set when the i-th slot of the group is empty
+inline std::uint32_t hash_group_empty(const std::uint8_t* ctrl) noexcept
+{
+#if defined(__SSE2__) && !defined(FAST_VECTOR_NO_SIMD)
+    return std::uint32_t(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl))));
+#else
+    std::uint32_t mask = 0;
+    for (std::size_t i = 0; i < hash_group_width; i++)
+        mask |= std::uint32_t(ctrl[i] >> 7) << i;
+    return mask;
+#endif
+}
+
+// Index of the lowest set bit of a non-zero group mask
+inline std::uint32_t hash_group_first(std::uint32_t mask) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return std::uint32_t(__builtin_ctz(mask));
+#else
+    std::uint32_t index = 0;
+    while (!(mask & 1))
+    {
+        mask >>= 1;
+        index++;
+    }
+    return index;
+#endif
+}
+
+/**
+ * Spreads the bits of a std::hash result, the identity hash of the integers would put
+ * consecutive keys into one group and leave the 7 control bits all alike.
+ */
+inline std::uint64_t hash_mix(std::uint64_t h) noexcept
+{
+#if defined(__SIZEOF_INT128__)
+    __uint128_t product = __uint128_t(h) * 0x9e3779b97f4a7c15ull;
+    return std::uint64_t(product) ^ std::uint64_t(product >> 64);
+#else
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    return h;
+#endif
+}
+
+/**
+ * Hash map with open addressing in two fast_vector arrays: one control byte per slot and the
+ * slots holding the std::pair<Key, T> items in place. A lookup loads the 16 control bytes
+ * starting at the home slot of the key and compares them with 7 bits of its hash at once,
+ * only the matching slots have their keys compared. The probing is linear, slot by slot, so
+ * erase() shifts the following items of the run back instead of leaving tombstones and the
+ * lookups never slow down with the churn. The table holds up to 3/4 of its slots (the runs of
+ * linear probing get long above that) and doubles, trivially relocatable items are moved by
+ * memcpy then. Any insertion or erasure invalidates
+ * the iterators, keys must not be changed through them.
+ */
+template <typename Key, typename T, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>, int A = 16, typename M = malloc_allocator>
+class fast_hash_map
+{
+    template <typename U>
+    class basic_iterator;
+
+public:
+    using size_type = std::size_t;
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<Key, T>;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using iterator = basic_iterator<value_type>;
+    using const_iterator = basic_iterator<const value_type>;
+
+    fast_hash_map() = default;
+    fast_hash_map(std::initializer_list<value_type> items);
+    fast_hash_map(const fast_hash_map& other);
+    fast_hash_map(fast_hash_map&& other) noexcept;
+    fast_hash_map& operator=(const fast_hash_map& other);
+    fast_hash_map& operator=(fast_hash_map&& other) noexcept;
+
+    ~fast_hash_map();
+
+    // Element access
+
+    // Inserts a value initialized T when the key is missing
+    T& operator[](const Key& key);
+
+#if !defined(FAST_VECTOR_NO_EXCEPTIONS)
+    T& at(const Key& key);
+    const T& at(const Key& key) const;
+#endif
+
+    // Iterators, in slot order
+
+    iterator begin() noexcept;
+    const_iterator begin() const noexcept;
+
+    iterator end() noexcept;
+    const_iterator end() const noexcept;
+
+    // Capacity
+
+    bool empty() const noexcept;
+    size_type size() const noexcept;
+    // Items the table takes before it grows
+    size_type capacity() const noexcept;
+    size_type bucket_count() const noexcept;
+    // Sizes the table for new_cap items at once, no rehash happens until there are more
+    void reserve(size_type new_cap);
+    fast_vector_status try_reserve(size_type new_cap);
+
+    // Lookup, end() when there is no such key
+
+    iterator find(const Key& key);
+    const_iterator find(const Key& key) const;
+    bool contains(const Key& key) const;
+    size_type count(const Key& key) const;
+
+    // Modifiers
+
+    // Destroys the items, the table keeps its size
+    void clear() noexcept;
+
+    // The item is added unless its key is there already, second tells which happened
+    std::pair<iterator, bool> insert(const value_type& item);
+    std::pair<iterator, bool> insert(value_type&& item);
+
+    // The value is constructed from args only when the key is missing
+    template< class... Args >
+    std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args);
+
+    template< class V >
+    std::pair<iterator, bool> insert_or_assign(const Key& key, V&& value);
+
+    // Returns the number of removed items (0 or 1)
+    size_type erase(const Key& key);
+    // The items after pos may shift into its slot, use erase_if() to erase while iterating
+    void erase(const_iterator pos);
+
+    // Removes the items satisfying pred, returns their number
+    template< class Pred >
+    size_type erase_if(Pred pred);
+
+    static void swap(fast_hash_map& a, fast_hash_map& b) noexcept;
+
+    using allocator_type = M;
+
+private:
+    struct slot_storage
+    {
+        alignas(value_type) unsigned char bytes[sizeof(value_type)];
+    };
+
+    // Items may be moved by memcpy instead of constructors
+    static constexpr bool relocatable = is_trivially_relocatable_v<value_type>;
+    static constexpr size_type npos = size_type(-1);
+
+    value_type* slot(size_type index) noexcept;
+    const value_type* slot(size_type index) const noexcept;
+
+    std::uint64_t hash(const Key& key) const;
+    // Slot of the key, or the empty slot it would go to with found = false
+    size_type probe(const Key& key, std::uint64_t h, bool& found) const;
+    size_type find_index(const Key& key) const;
+    void set_ctrl(size_type index, std::uint8_t value) noexcept;
+    // Moves the item from slot from into the raw slot to
+    void relocate(size_type from, size_type to) noexcept;
+
+    fast_vector_status rehash(size_type buckets);
+    void erase_at(size_type index);
+    void destroy_items() noexcept;
+
+    fast_vector<std::uint8_t, false, 16, M> m_ctrl;
+    fast_vector<slot_storage, false, A, M> m_slots;
+    size_type m_size = 0;
+    size_type m_mask = 0;
+    Hash m_hash;
+    KeyEqual m_equal;
+};
+
+/**
+ * Walks the full slots in order, skipping the empty ones by their control bytes.
+ */
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+template <typename U>
+class fast_hash_map<Key,T,Hash,KeyEqual,A,M>::basic_iterator
+{
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::remove_const_t<U>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = U*;
+    using reference = U&;
+
+    basic_iterator() = default;
+
+    // Starts at the first full slot from ctrl on
+    basic_iterator(const std::uint8_t* ctrl, const std::uint8_t* ctrl_end, U* item) noexcept :
+        m_ctrl(ctrl),
+        m_ctrl_end(ctrl_end),
+        m_item(item)
+    {
+        skip_empty();
+    }
+
+    // iterator converts to const_iterator
+    template <typename V, typename = std::enable_if_t<std::is_same_v<const V, U>>>
+    basic_iterator(const basic_iterator<V>& other) noexcept :
+        m_ctrl(other.m_ctrl),
+        m_ctrl_end(other.m_ctrl_end),
+        m_item(other.m_item)
+    {
+    }
+
+    U& operator*() const noexcept { return *m_item; }
+    U* operator->() const noexcept { return m_item; }
+
+    basic_iterator& operator++() noexcept
+    {
+        ++m_ctrl;
+        ++m_item;
+        skip_empty();
+        return *this;
+    }
+
+    basic_iterator operator++(int) noexcept
+    {
+        basic_iterator previous = *this;
+        ++*this;
+        return previous;
+    }
+
+    bool operator==(const basic_iterator& other) const noexcept { return m_ctrl == other.m_ctrl; }
+    bool operator!=(const basic_iterator& other) const noexcept { return m_ctrl != other.m_ctrl; }
+
+private:
+    friend class fast_hash_map;
+    template <typename V>
+    friend class basic_iterator;
+
+    void skip_empty() noexcept
+    {
+        while (m_ctrl != m_ctrl_end && (*m_ctrl & hash_ctrl_empty))
+        {
+            ++m_ctrl;
+            ++m_item;
+        }
+    }
+
+    const std::uint8_t* m_ctrl = nullptr;
+    const std::uint8_t* m_ctrl_end = nullptr;
+    U* m_item = nullptr;
+};
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+fast_hash_map<Key,T,Hash,KeyEqual,A,M>::fast_hash_map(std::initializer_list<value_type> items)
+{
+    reserve(items.size());
+    for (const value_type& item : items)
+        insert(item);
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+fast_hash_map<Key,T,Hash,KeyEqual,A,M>::fast_hash_map(const fast_hash_map& other) :
+    m_ctrl(other.m_ctrl),
+    m_size(other.m_size),
+    m_mask(other.m_mask),
+    m_hash(other.m_hash),
+    m_equal(other.m_equal)
+{
+    if constexpr (std::is_trivially_copyable_v<value_type>)
+    {
+        // The same layout, one memcpy of all the slots
+        m_slots = other.m_slots;
+    }
+    else
+    {
+        m_slots.resize(other.m_slots.size(), no_init);
+        for (size_type i = 0; i < bucket_count(); i++)
+        {
+            if (!(m_ctrl[i] & hash_ctrl_empty))
+                new (slot(i)) value_type(*other.slot(i));
+        }
+    }
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+fast_hash_map<Key,T,Hash,KeyEqual,A,M>::fast_hash_map(fast_hash_map&& other) noexcept :
+    m_ctrl(std::move(other.m_ctrl)),
+    m_slots(std::move(other.m_slots)),
+    m_size(other.m_size),
+    m_mask(other.m_mask),
+    m_hash(std::move(other.m_hash)),
+    m_equal(std::move(other.m_equal))
+{
+    other.m_size = 0;
+    other.m_mask = 0;
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+fast_hash_map<Key,T,Hash,KeyEqual,A,M>& fast_hash_map<Key,T,Hash,KeyEqual,A,M>::operator=(const fast_hash_map& other)
+{
+    if (this != &other)
+    {
+        fast_hash_map copy(other);
+        swap(*this, copy);
+    }
+    return *this;
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+fast_hash_map<Key,T,Hash,KeyEqual,A,M>& fast_hash_map<Key,T,Hash,KeyEqual,A,M>::operator=(fast_hash_map&& other) noexcept
+{
+    swap(*this, other);
+    return *this;
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+fast_hash_map<Key,T,Hash,KeyEqual,A,M>::~fast_hash_map()
+{
+    destroy_items();
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+void fast_hash_map<Key,T,Hash,KeyEqual,A,M>::swap(fast_hash_map& a, fast_hash_map& b) noexcept
+{
+    decltype(m_ctrl)::swap(a.m_ctrl, b.m_ctrl);
+    decltype(m_slots)::swap(a.m_slots, b.m_slots);
+    std::swap(a.m_size, b.m_size);
+    std::swap(a.m_mask, b.m_mask);
+    std::swap(a.m_hash, b.m_hash);
+    std::swap(a.m_equal, b.m_equal);
+}
+
+// Slots
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+typename fast_hash_map<Key,T,Hash,KeyEqual,A,M>::value_type* fast_hash_map<Key,T,Hash,KeyEqual,A,M>::slot(size_type index) noexcept
+{
+    return reinterpret_cast<value_type*>(m_slots.data() + index);
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+const typename fast_hash_map<Key,T,Hash,KeyEqual,A,M>::value_type* fast_hash_map<Key,T,Hash,KeyEqual,A,M>::slot(size_type index) const noexcept
+{
+    return reinterpret_cast<const value_type*>(m_slots.data() + index);
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+std::uint64_t fast_hash_map<Key,T,Hash,KeyEqual,A,M>::hash(const Key& key) const
+{
+    return hash_mix(std::uint64_t(m_hash(key)));
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+typename fast_hash_map<Key,T,Hash,KeyEqual,A,M>::size_type
+fast_hash_map<Key,T,Hash,KeyEqual,A,M>::probe(const Key& key, std::uint64_t h, bool& found) const
+{
+    const std::uint8_t h2 = std::uint8_t(h & 0x7f);
+    size_type pos = size_type(h >> 7) & m_mask;
+
+    for (;;)
+    {
+        const std::uint8_t* group = m_ctrl.data() + pos;
+
+        for (std::uint32_t match = hash_group_match(group, h2); match; match &= match - 1)
+        {
+            size_type index = (pos + size_type(hash_group_first(match))) & m_mask;
+            if (m_equal(slot(index)->first, key))
+            {
+                found = true;
+                return index;
+            }
+        }
+
+        // The run of full slots from the home slot ends here, the key would be before it
+        if (std::uint32_t empty = hash_group_empty(group))
+        {
+            found = false;
+            return (pos + size_type(hash_group_first(empty))) & m_mask;
+        }
+
+        pos = (pos + hash_group_width) & m_mask;
+    }
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+typename fast_hash_map<Key,T,Hash,KeyEqual,A,M>::size_type fast_hash_map<Key,T,Hash,KeyEqual,A,M>::find_index(const Key& key) const
+{
+    if (m_size == 0)
+        return npos;
+
+    bool found;
+    size_type index = probe(key, hash(key), found);
+    return found ? index : npos;
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+void fast_hash_map<Key,T,Hash,KeyEqual,A,M>::set_ctrl(size_type index, std::uint8_t value) noexcept
+{
+    // The first hash_group_width - 1 bytes have their clone at the end, the others write twice
+    m_ctrl[index] = value;
+    m_ctrl[((index - (hash_group_width - 1)) & m_mask) + (hash_group_width - 1)] = value;
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+void fast_hash_map<Key,T,Hash,KeyEqual,A,M>::relocate(size_type from, size_type to) noexcept
+{
+    if constexpr (relocatable)
+    {
+        std::memcpy(static_cast<void*>(slot(to)), static_cast<const void*>(slot(from)), sizeof(value_type));
+    }
+    else
+    {
+        new (slot(to)) value_type(std::move(*slot(from)));
+        slot(from)->~value_type();
+    }
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+void fast_hash_map<Key,T,Hash,KeyEqual,A,M>::destroy_items() noexcept
+{
+    if constexpr (!std::is_trivially_destructible_v<value_type>)
+    {
+        if (m_size == 0)
+            return;
+
+        for (size_type i = 0; i < bucket_count(); i++)
+        {
+            if (!(m_ctrl[i] & hash_ctrl_empty))
+                slot(i)->~value_type();
+        }
+    }
+}
+
+// Element access
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+T& fast_hash_map<Key,T,Hash,KeyEqual,A,M>::operator[](const Key& key)
+{
+    return try_emplace(key).first->second;
+}
+
+#if !defined(FAST_VECTOR_NO_EXCEPTIONS)
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+T& fast_hash_map<Key,T,Hash,KeyEqual,A,M>::at(const Key& key)
+{
+    size_type index = find_index(key);
+    if (index == npos)
+        throw std::out_of_range("fast_hash_map::at");
+    return slot(index)->second;
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+const T& fast_hash_map<Key,T,Hash,KeyEqual,A,M>::at(const Key& key) const
+{
+    size_type index = find_index(key);
+    if (index == npos)
+        throw std::out_of_range("fast_hash_map::at");
+    return slot(index)->second;
+}
+#endif
+
+// Iterators
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+typename fast_hash_map<Key,T,Hash,KeyEqual,A,M>::iterator fast_hash_map<Key,T,Hash,KeyEqual,A,M>::begin() noexcept
+{
+    return {m_ctrl.data(), m_ctrl.data() + bucket_count(), slot(0)};
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+typename fast_hash_map<Key,T,Hash,KeyEqual,A,M>::const_iterator fast_hash_map<Key,T,Hash,KeyEqual,A,M>::begin() const noexcept
+{
+    return {m_ctrl.data(), m_ctrl.data() + bucket_count(), slot(0)};
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+typename fast_hash_map<Key,T,Hash,KeyEqual,A,M>::iterator fast_hash_map<Key,T,Hash,KeyEqual,A,M>::end() noexcept
+{
+    return {m_ctrl.data() + bucket_count(), m_ctrl.data() + bucket_count(), slot(bucket_count())};
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+typename fast_hash_map<Key,T,Hash,KeyEqual,A,M>::const_iterator fast_hash_map<Key,T,Hash,KeyEqual,A,M>::end() const noexcept
+{
+    return {m_ctrl.data() + bucket_count(), m_ctrl.data() + bucket_count(), slot(bucket_count())};
+}
+
+// Capacity
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+bool fast_hash_map<Key,T,Hash,KeyEqual,A,M>::empty() const noexcept
+{
+    return m_size == 0;
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+typename fast_hash_map<Key,T,Hash,KeyEqual,A,M>::size_type fast_hash_map<Key,T,Hash,KeyEqual,A,M>::size() const noexcept
+{
+    return m_size;
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+typename fast_hash_map<Key,T,Hash,KeyEqual,A,M>::size_type fast_hash_map<Key,T,Hash,KeyEqual,A,M>::bucket_count() const noexcept
+{
+    return m_slots.size();
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+typename fast_hash_map<Key,T,Hash,KeyEqual,A,M>::size_type fast_hash_map<Key,T,Hash,KeyEqual,A,M>::capacity() const noexcept
+{
+    return bucket_count() - bucket_count() / 4;
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+void fast_hash_map<Key,T,Hash,KeyEqual,A,M>::reserve(size_type new_cap)
+{
+    if (try_reserve(new_cap) != fast_vector_status::ok)
+        fast_vector_out_of_memory();
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+fast_vector_status fast_hash_map<Key,T,Hash,KeyEqual,A,M>::try_reserve(size_type new_cap)
+{
+    if (new_cap <= capacity())
+        return fast_vector_status::ok;
+
+    if (new_cap > size_type(-1) / 16 / sizeof(value_type))
+        return fast_vector_status::length_error;
+
+    size_type buckets = bucket_count() ? bucket_count() : hash_group_width;
+    while (buckets - buckets / 4 < new_cap)
+        buckets *= 2;
+
+    return rehash(buckets);
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+fast_vector_status fast_hash_map<Key,T,Hash,KeyEqual,A,M>::rehash(size_type buckets)
+{
+    fast_vector<std::uint8_t, false, 16, M> ctrl;
+    fast_vector<slot_storage, false, A, M> slots;
+
+    fast_vector_status status = ctrl.try_reserve(buckets + hash_group_width - 1);
+    if (status == fast_vector_status::ok)
+        status = slots.try_reserve(buckets);
+    if (status != fast_vector_status::ok)
+        return status;
+
+    ctrl.resize(buckets + hash_group_width - 1, hash_ctrl_empty);
+    slots.resize(buckets, no_init);
+
+    const size_type old_buckets = bucket_count();
+    decltype(m_ctrl)::swap(m_ctrl, ctrl);
+    decltype(m_slots)::swap(m_slots, slots);
+    m_mask = buckets - 1;
+
+    // No key is equal to another here, each item goes to the first empty slot of its run
+    for (size_type i = 0; i < old_buckets; i++)
+    {
+        if (ctrl[i] & hash_ctrl_empty)
+            continue;
+
+        value_type* item = reinterpret_cast<value_type*>(slots.data() + i);
+        const std::uint64_t h = hash(item->first);
+        size_type pos = size_type(h >> 7) & m_mask;
+
+        std::uint32_t empty;
+        while (!(empty = hash_group_empty(m_ctrl.data() + pos)))
+            pos = (pos + hash_group_width) & m_mask;
+
+        const size_type index = (pos + size_type(hash_group_first(empty))) & m_mask;
+        set_ctrl(index, std::uint8_t(h & 0x7f));
+
+        if constexpr (relocatable)
+        {
+            std::memcpy(static_cast<void*>(slot(index)), static_cast<const void*>(item), sizeof(value_type));
+        }
+        else
+        {
+            new (slot(index)) value_type(std::move(*item));
+            item->~value_type();
+        }
+    }
+
+    return fast_vector_status::ok;
+}
+
+// Lookup
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+typename fast_hash_map<Key,T,Hash,KeyEqual,A,M>::iterator fast_hash_map<Key,T,Hash,KeyEqual,A,M>::find(const Key& key)
+{
+    size_type index = find_index(key);
+    return index == npos ? end() : iterator(m_ctrl.data() + index, m_ctrl.data() + bucket_count(), slot(index));
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+typename fast_hash_map<Key,T,Hash,KeyEqual,A,M>::const_iterator fast_hash_map<Key,T,Hash,KeyEqual,A,M>::find(const Key& key) const
+{
+    size_type index = find_index(key);
+    return index == npos ? end() : const_iterator(m_ctrl.data() + index, m_ctrl.data() + bucket_count(), slot(index));
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+bool fast_hash_map<Key,T,Hash,KeyEqual,A,M>::contains(const Key& key) const
+{
+    return find_index(key) != npos;
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+typename fast_hash_map<Key,T,Hash,KeyEqual,A,M>::size_type fast_hash_map<Key,T,Hash,KeyEqual,A,M>::count(const Key& key) const
+{
+    return contains(key);
+}
+
+// Modifiers
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+void fast_hash_map<Key,T,Hash,KeyEqual,A,M>::clear() noexcept
+{
+    destroy_items();
+    std::fill(m_ctrl.begin(), m_ctrl.end(), hash_ctrl_empty);
+    m_size = 0;
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+template< class... Args >
+std::pair<typename fast_hash_map<Key,T,Hash,KeyEqual,A,M>::iterator, bool>
+fast_hash_map<Key,T,Hash,KeyEqual,A,M>::try_emplace(const Key& key, Args&&... args)
+{
+    const std::uint64_t h = hash(key);
+    bool found = false;
+    size_type index = 0;
+
+    if (bucket_count())
+    {
+        index = probe(key, h, found);
+        if (found)
+            return {iterator(m_ctrl.data() + index, m_ctrl.data() + bucket_count(), slot(index)), false};
+    }
+
+    // Twice the slots, the empty one found above moves with the rehash. The arguments may
+    // refer into the slots the rehash frees, so the item is built before.
+    if (m_size + 1 > capacity())
+    {
+        value_type item(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+        reserve(capacity() ? capacity() * 2 : 1);
+        index = probe(item.first, h, found);
+
+        new (slot(index)) value_type(std::move(item));
+        set_ctrl(index, std::uint8_t(h & 0x7f));
+        m_size++;
+
+        return {iterator(m_ctrl.data() + index, m_ctrl.data() + bucket_count(), slot(index)), true};
+    }
+
+    new (slot(index)) value_type(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+    set_ctrl(index, std::uint8_t(h & 0x7f));
+    m_size++;
+
+    return {iterator(m_ctrl.data() + index, m_ctrl.data() + bucket_count(), slot(index)), true};
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+std::pair<typename fast_hash_map<Key,T,Hash,KeyEqual,A,M>::iterator, bool>
+fast_hash_map<Key,T,Hash,KeyEqual,A,M>::insert(const value_type& item)
+{
+    return try_emplace(item.first, item.second);
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+std::pair<typename fast_hash_map<Key,T,Hash,KeyEqual,A,M>::iterator, bool>
+fast_hash_map<Key,T,Hash,KeyEqual,A,M>::insert(value_type&& item)
+{
+    return try_emplace(item.first, std::move(item.second));
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+template< class V >
+std::pair<typename fast_hash_map<Key,T,Hash,KeyEqual,A,M>::iterator, bool>
+fast_hash_map<Key,T,Hash,KeyEqual,A,M>::insert_or_assign(const Key& key, V&& value)
+{
+    std::pair<iterator, bool> result = try_emplace(key, std::forward<V>(value));
+
+    if (!result.second)
+        result.first->second = std::forward<V>(value);
+
+    return result;
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+void fast_hash_map<Key,T,Hash,KeyEqual,A,M>::erase_at(size_type index)
+{
+    slot(index)->~value_type();
+
+    // Backward shift: every following item of the run whose home slot is not between the hole
+    // and itself moves into the hole, which then continues from its old slot
+    for (size_type next = (index + 1) & m_mask; !(m_ctrl[next] & hash_ctrl_empty); next = (next + 1) & m_mask)
+    {
+        const size_type home = size_type(hash(slot(next)->first) >> 7) & m_mask;
+
+        if (((next - home) & m_mask) >= ((next - index) & m_mask))
+        {
+            relocate(next, index);
+            set_ctrl(index, m_ctrl[next]);
+            index = next;
+        }
+    }
+
+    set_ctrl(index, hash_ctrl_empty);
+    m_size--;
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+typename fast_hash_map<Key,T,Hash,KeyEqual,A,M>::size_type fast_hash_map<Key,T,Hash,KeyEqual,A,M>::erase(const Key& key)
+{
+    size_type index = find_index(key);
+
+    if (index == npos)
+        return 0;
+
+    erase_at(index);
+    return 1;
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+void fast_hash_map<Key,T,Hash,KeyEqual,A,M>::erase(const_iterator pos)
+{
+    erase_at(size_type(pos.m_ctrl - m_ctrl.data()));
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, int A, typename M>
+template< class Pred >
+typename fast_hash_map<Key,T,Hash,KeyEqual,A,M>::size_type fast_hash_map<Key,T,Hash,KeyEqual,A,M>::erase_if(Pred pred)
+{
+    const size_type old_size = m_size;
+
+    // A slot emptied by erase_at() may be refilled by the shift, it is checked again. Items
+    // wrapping around from the front were kept already and are kept again.
+    for (size_type i = 0; i < bucket_count();)
+    {
+        if (!(m_ctrl[i] & hash_ctrl_empty) && pred(*slot(i)))
+            erase_at(i);
+        else
+            i++;
+    }
+
+    return old_size - m_size;
+}
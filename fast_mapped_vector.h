@@ -0,0 +1,604 @@
+//
+// File-backed sibling of the fast_vector
+//
+// Advanced & fixed version by Marian Krivos
+//
+
+#pragma once
+
+#include "fast_vector.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <fcntl.h>    // open()
+#include <sys/mman.h> // mmap(), msync()
+#include <sys/stat.h> // fstat()
+#include <unistd.h>   // ftruncate(), close()
+
+/**
+ * Header at the start of every fast_mapped_vector file. The fields are stored in the host
+ * byte order, the elements follow at data_offset.
+ */
+struct mapped_vector_header
+{
+    static constexpr char file_magic[8] = {'F', 'A', 'S', 'T', 'V', 'E', 'C', '\0'};
+    static constexpr std::uint32_t file_version = 1;
+
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t element_size;
+    std::uint32_t alignment;
+    std::uint32_t data_offset;
+    std::uint64_t size;
+    std::uint64_t capacity;
+};
+
+/**
+ * The fast_vector whose storage is a memory mapped file, for trivially copyable T.
+ * Opening an existing file maps it without reading or parsing anything, appending grows
+ * the file (ftruncate) and the mapping. The element count lives in the file header,
+ * sync() flushes the dirty pages to the disk.
+ */
+template <typename T, int A = 16, typename G = factor_growth<>>
+class fast_mapped_vector
+{
+public:
+    using size_type = std::size_t;
+    using value_type = T;
+
+    enum class mode
+    {
+        read_only,
+        read_write
+    };
+
+    fast_mapped_vector() = default;
+    fast_mapped_vector(const fast_mapped_vector& other) = delete;
+    fast_mapped_vector(fast_mapped_vector&& other) noexcept;
+    fast_mapped_vector& operator=(const fast_mapped_vector& other) = delete;
+    fast_mapped_vector& operator=(fast_mapped_vector&& other) noexcept;
+
+    ~fast_mapped_vector();
+
+    // Files
+
+    // Maps an existing file, fails when the header does not match T
+    bool open(const char* path, mode access = mode::read_write);
+    // Creates (or truncates) the file with room for capacity elements
+    bool create(const char* path, size_type capacity = 0);
+    void close() noexcept;
+    // Flushes the mapping to the file, blocks until written unless async
+    bool sync(bool async = false);
+
+    bool is_open() const noexcept;
+    bool writable() const noexcept;
+
+    // Element access
+
+    T& operator[](size_type pos);
+    const T& operator[](size_type pos) const;
+
+    T& front();
+    const T& front() const;
+
+    T& back();
+    const T& back() const;
+
+    T* data() noexcept;
+    const T* data() const noexcept;
+
+    // Iterators
+
+    T* begin() noexcept;
+    const T* begin() const noexcept;
+
+    T* end() noexcept;
+    const T* end() const noexcept;
+
+    // Capacity
+
+    bool empty() const noexcept;
+    size_type size() const noexcept;
+    // A failed growth of the file or the mapping is reported like a failed allocation
+    void reserve(size_type new_cap);
+    size_type capacity() const noexcept;
+    void shrink_to_fit();
+
+    // Non-throwing counterparts, on failure the vector is left unchanged
+    fast_vector_status try_reserve(size_type new_cap);
+    fast_vector_status try_shrink_to_fit();
+    fast_vector_status try_push_back(const T& value);
+    fast_vector_status try_append(const T value[], size_type count);
+
+    // Modifiers
+
+    void clear() noexcept;
+    void push_back(const T& value);
+    void append(const T value[], size_type count);
+    void pop_back();
+    void resize(size_type count);
+
+    static void swap(fast_mapped_vector& a, fast_mapped_vector& b);
+
+    static constexpr size_type alignment = A > int(alignof(T)) ? size_type(A) : alignof(T);
+
+    static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can live in a file");
+    static_assert(A > 0 && (A & (A - 1)) == 0, "Alignment must be a power of two");
+
+    using growth_policy = G;
+
+private:
+    // The elements start on the first multiple of the alignment past the header
+    static constexpr size_type data_offset =
+        (sizeof(mapped_vector_header) + alignment - 1) / alignment * alignment;
+
+    static size_type file_bytes(size_type capacity) noexcept;
+
+    bool map(size_type bytes, bool writable);
+    bool remap(size_type new_cap);
+    void attach() noexcept;
+
+    int m_fd = -1;
+    void* m_map = nullptr;
+    size_type m_map_bytes = 0;
+    mapped_vector_header* m_header = nullptr;
+    T* m_data = nullptr;
+    bool m_writable = false;
+};
+
+template <typename T, int A, typename G>
+fast_mapped_vector<T,A,G>::fast_mapped_vector(fast_mapped_vector&& other) noexcept
+{
+    swap(*this, other);
+}
+
+template <typename T, int A, typename G>
+fast_mapped_vector<T,A,G>& fast_mapped_vector<T,A,G>::operator=(fast_mapped_vector&& other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+        swap(*this, other);
+    }
+    return *this;
+}
+
+template <typename T, int A, typename G>
+fast_mapped_vector<T,A,G>::~fast_mapped_vector()
+{
+    close();
+}
+
+template <typename T, int A, typename G>
+void fast_mapped_vector<T,A,G>::swap(fast_mapped_vector& a, fast_mapped_vector& b)
+{
+    std::swap(a.m_fd, b.m_fd);
+    std::swap(a.m_map, b.m_map);
+    std::swap(a.m_map_bytes, b.m_map_bytes);
+    std::swap(a.m_header, b.m_header);
+    std::swap(a.m_data, b.m_data);
+    std::swap(a.m_writable, b.m_writable);
+}
+
+// Files
+
+template <typename T, int A, typename G>
+bool fast_mapped_vector<T,A,G>::open(const char* path, mode access)
+{
+    close();
+
+    bool writable = access == mode::read_write;
+
+    m_fd = ::open(path, writable ? O_RDWR : O_RDONLY);
+    if (m_fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(m_fd, &info) != 0 || size_type(info.st_size) < sizeof(mapped_vector_header) ||
+        !map(size_type(info.st_size), writable))
+    {
+        close();
+        return false;
+    }
+
+    const mapped_vector_header& header = *reinterpret_cast<const mapped_vector_header*>(m_map);
+
+    // A file written for another element type (or by another layout) is refused
+    bool valid = std::memcmp(header.magic, mapped_vector_header::file_magic, sizeof(header.magic)) == 0 &&
+                 header.version == mapped_vector_header::file_version &&
+                 header.element_size == sizeof(T) &&
+                 header.data_offset >= sizeof(mapped_vector_header) &&
+                 header.data_offset % alignment == 0 &&
+                 header.size <= header.capacity &&
+                 header.data_offset <= m_map_bytes &&
+                 header.capacity <= (m_map_bytes - header.data_offset) / sizeof(T);
+
+    if (!valid)
+    {
+        close();
+        return false;
+    }
+
+    attach();
+    return true;
+}
+
+template <typename T, int A, typename G>
+bool fast_mapped_vector<T,A,G>::create(const char* path, size_type capacity)
+{
+    close();
+
+    m_fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (m_fd < 0)
+        return false;
+
+    if (ftruncate(m_fd, off_t(file_bytes(capacity))) != 0 || !map(file_bytes(capacity), true))
+    {
+        close();
+        return false;
+    }
+
+    auto& header = *reinterpret_cast<mapped_vector_header*>(m_map);
+    std::memcpy(header.magic, mapped_vector_header::file_magic, sizeof(header.magic));
+    header.version = mapped_vector_header::file_version;
+    header.element_size = sizeof(T);
+    header.alignment = std::uint32_t(alignment);
+    header.data_offset = std::uint32_t(data_offset);
+    header.size = 0;
+    header.capacity = capacity;
+
+    attach();
+    return true;
+}
+
+template <typename T, int A, typename G>
+void fast_mapped_vector<T,A,G>::close() noexcept
+{
+    if (m_map)
+        munmap(m_map, m_map_bytes);
+    if (m_fd >= 0)
+        ::close(m_fd);
+
+    m_fd = -1;
+    m_map = nullptr;
+    m_map_bytes = 0;
+    m_header = nullptr;
+    m_data = nullptr;
+    m_writable = false;
+}
+
+template <typename T, int A, typename G>
+bool fast_mapped_vector<T,A,G>::sync(bool async)
+{
+    if (!m_map)
+        return false;
+    if (!m_writable)
+        return true;
+
+    return msync(m_map, m_map_bytes, async ? MS_ASYNC : MS_SYNC) == 0;
+}
+
+template <typename T, int A, typename G>
+bool fast_mapped_vector<T,A,G>::is_open() const noexcept
+{
+    return m_map != nullptr;
+}
+
+template <typename T, int A, typename G>
+bool fast_mapped_vector<T,A,G>::writable() const noexcept
+{
+    return m_writable;
+}
+
+template <typename T, int A, typename G>
+typename fast_mapped_vector<T,A,G>::size_type fast_mapped_vector<T,A,G>::file_bytes(size_type capacity) noexcept
+{
+    return data_offset + capacity * sizeof(T);
+}
+
+template <typename T, int A, typename G>
+bool fast_mapped_vector<T,A,G>::map(size_type bytes, bool writable)
+{
+    int protection = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+
+    void* ptr = mmap(nullptr, bytes, protection, MAP_SHARED, m_fd, 0);
+    if (ptr == MAP_FAILED)
+        return false;
+
+    m_map = ptr;
+    m_map_bytes = bytes;
+    m_writable = writable;
+    return true;
+}
+
+template <typename T, int A, typename G>
+bool fast_mapped_vector<T,A,G>::remap(size_type new_cap)
+{
+    size_type bytes = file_bytes(new_cap);
+    bool growing = bytes > m_map_bytes;
+
+    // A grown file is extended before it is mapped and a shrunk one truncated after,
+    // so a failure never leaves mapped pages past the end of the file
+    if (growing && ftruncate(m_fd, off_t(bytes)) != 0)
+        return false;
+
+#if defined(__linux__)
+    void* ptr = mremap(m_map, m_map_bytes, bytes, MREMAP_MAYMOVE);
+    if (ptr == MAP_FAILED)
+        return false;
+
+    m_map = ptr;
+    m_map_bytes = bytes;
+#else
+    void* old_map = m_map;
+    size_type old_bytes = m_map_bytes;
+
+    if (!map(bytes, true))
+        return false;
+
+    munmap(old_map, old_bytes);
+#endif
+
+    attach();
+    m_header->capacity = new_cap;
+
+    // A file left longer than its capacity is still valid, so the result is not checked
+    if (!growing)
+    {
+        int truncated = ftruncate(m_fd, off_t(bytes));
+        (void)truncated;
+    }
+
+    return true;
+}
+
+template <typename T, int A, typename G>
+void fast_mapped_vector<T,A,G>::attach() noexcept
+{
+    m_header = reinterpret_cast<mapped_vector_header*>(m_map);
+    m_data = reinterpret_cast<T*>(reinterpret_cast<char*>(m_map) + m_header->data_offset);
+}
+
+// Element access
+
+template <typename T, int A, typename G>
+T& fast_mapped_vector<T,A,G>::operator[](size_type pos)
+{
+    assert(pos < size() && "Position is out of range");
+    return m_data[pos];
+}
+
+template <typename T, int A, typename G>
+const T& fast_mapped_vector<T,A,G>::operator[](size_type pos) const
+{
+    assert(pos < size() && "Position is out of range");
+    return m_data[pos];
+}
+
+template <typename T, int A, typename G>
+T& fast_mapped_vector<T,A,G>::front()
+{
+    assert(!empty() && "Container is empty");
+    return m_data[0];
+}
+
+template <typename T, int A, typename G>
+const T& fast_mapped_vector<T,A,G>::front() const
+{
+    assert(!empty() && "Container is empty");
+    return m_data[0];
+}
+
+template <typename T, int A, typename G>
+T& fast_mapped_vector<T,A,G>::back()
+{
+    assert(!empty() && "Container is empty");
+    return m_data[size() - 1];
+}
+
+template <typename T, int A, typename G>
+const T& fast_mapped_vector<T,A,G>::back() const
+{
+    assert(!empty() && "Container is empty");
+    return m_data[size() - 1];
+}
+
+template <typename T, int A, typename G>
+T* fast_mapped_vector<T,A,G>::data() noexcept
+{
+    return m_data;
+}
+
+template <typename T, int A, typename G>
+const T* fast_mapped_vector<T,A,G>::data() const noexcept
+{
+    return m_data;
+}
+
+// Iterators
+
+template <typename T, int A, typename G>
+T* fast_mapped_vector<T,A,G>::begin() noexcept
+{
+    return m_data;
+}
+
+template <typename T, int A, typename G>
+const T* fast_mapped_vector<T,A,G>::begin() const noexcept
+{
+    return m_data;
+}
+
+template <typename T, int A, typename G>
+T* fast_mapped_vector<T,A,G>::end() noexcept
+{
+    return m_data + size();
+}
+
+template <typename T, int A, typename G>
+const T* fast_mapped_vector<T,A,G>::end() const noexcept
+{
+    return m_data + size();
+}
+
+// Capacity
+
+template <typename T, int A, typename G>
+bool fast_mapped_vector<T,A,G>::empty() const noexcept
+{
+    return size() == 0;
+}
+
+template <typename T, int A, typename G>
+typename fast_mapped_vector<T,A,G>::size_type fast_mapped_vector<T,A,G>::size() const noexcept
+{
+    return m_header ? size_type(m_header->size) : 0;
+}
+
+template <typename T, int A, typename G>
+typename fast_mapped_vector<T,A,G>::size_type fast_mapped_vector<T,A,G>::capacity() const noexcept
+{
+    return m_header ? size_type(m_header->capacity) : 0;
+}
+
+template <typename T, int A, typename G>
+void fast_mapped_vector<T,A,G>::reserve(size_type new_cap)
+{
+    if (try_reserve(new_cap) != fast_vector_status::ok)
+        fast_vector_out_of_memory();
+}
+
+template <typename T, int A, typename G>
+fast_vector_status fast_mapped_vector<T,A,G>::try_reserve(size_type new_cap)
+{
+    assert(m_writable && "The file is not open for writing");
+
+    if (new_cap <= capacity())
+        return fast_vector_status::ok;
+
+    if (new_cap > (size_type(-1) - data_offset) / sizeof(T))
+        return fast_vector_status::length_error;
+
+    return remap(new_cap) ? fast_vector_status::ok : fast_vector_status::out_of_memory;
+}
+
+template <typename T, int A, typename G>
+void fast_mapped_vector<T,A,G>::shrink_to_fit()
+{
+    if (try_shrink_to_fit() != fast_vector_status::ok)
+        fast_vector_out_of_memory();
+}
+
+template <typename T, int A, typename G>
+fast_vector_status fast_mapped_vector<T,A,G>::try_shrink_to_fit()
+{
+    assert(m_writable && "The file is not open for writing");
+
+    if (size() < capacity() && !remap(size()))
+        return fast_vector_status::out_of_memory;
+
+    return fast_vector_status::ok;
+}
+
+// Modifiers
+
+template <typename T, int A, typename G>
+void fast_mapped_vector<T,A,G>::clear() noexcept
+{
+    assert(m_writable && "The file is not open for writing");
+    m_header->size = 0;
+}
+
+template <typename T, int A, typename G>
+void fast_mapped_vector<T,A,G>::push_back(const T& value)
+{
+    if (try_push_back(value) != fast_vector_status::ok)
+        fast_vector_out_of_memory();
+}
+
+template <typename T, int A, typename G>
+fast_vector_status fast_mapped_vector<T,A,G>::try_push_back(const T& value)
+{
+    size_type count = size();
+    // value may live in the mapping which is about to move
+    T copy = value;
+
+    if (count == capacity())
+    {
+        fast_vector_status status = try_reserve(G::next_capacity(capacity(), count + 1, sizeof(T)));
+        if (status != fast_vector_status::ok)
+            return status;
+    }
+    else
+    {
+        assert(m_writable && "The file is not open for writing");
+    }
+
+    m_data[count] = copy;
+    m_header->size = count + 1;
+    return fast_vector_status::ok;
+}
+
+template <typename T, int A, typename G>
+fast_vector_status fast_mapped_vector<T,A,G>::try_append(const T value[], size_type count)
+{
+    size_type old_size = size();
+
+    if (count > size_type(-1) / sizeof(T) - old_size)
+        return fast_vector_status::length_error;
+
+    if (old_size + count > capacity())
+    {
+        // Growing may move the mapping, a source inside the vector moves with it
+        bool inside = value >= m_data && value < m_data + old_size;
+        size_type offset = inside ? size_type(value - m_data) : 0;
+
+        fast_vector_status status = try_reserve(G::next_capacity(capacity(), old_size + count, sizeof(T)));
+        if (status != fast_vector_status::ok)
+            return status;
+
+        if (inside)
+            value = m_data + offset;
+    }
+    else
+    {
+        assert(m_writable && "The file is not open for writing");
+    }
+
+    if (count)
+        std::memcpy(m_data + old_size, value, sizeof(T) * count);
+    m_header->size = old_size + count;
+    return fast_vector_status::ok;
+}
+
+template <typename T, int A, typename G>
+void fast_mapped_vector<T,A,G>::append(const T value[], size_type count)
+{
+    if (try_append(value, count) != fast_vector_status::ok)
+        fast_vector_out_of_memory();
+}
+
+template <typename T, int A, typename G>
+void fast_mapped_vector<T,A,G>::pop_back()
+{
+    assert(m_writable && "The file is not open for writing");
+    assert(!empty() && "Container is empty");
+    m_header->size--;
+}
+
+template <typename T, int A, typename G>
+void fast_mapped_vector<T,A,G>::resize(size_type count)
+{
+    // New elements are zeroed, the same as the fresh pages of a grown file
+    if (count > capacity())
+        reserve(count);
+
+    assert(m_writable && "The file is not open for writing");
+
+    if (count > size())
+        std::memset(static_cast<void*>(m_data + size()), 0, sizeof(T) * (count - size()));
+
+    m_header->size = count;
+}
+
+#endif // __unix__ || __APPLE__
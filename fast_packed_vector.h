@@ -0,0 +1,467 @@
+//
+// Unsigned integers of 1 to 32 bits packed back to back in fast_vector words
+//
+// Advanced & fixed version by Marian Krivos
+//
+
+#pragma once
+
+#include "fast_vector.h"
+
+// Width of packed_int_vector chosen at runtime
+inline constexpr unsigned dynamic_bits = 0;
+
+// Smallest width holding max_value
+inline unsigned packed_bits_for(std::uint32_t max_value) noexcept
+{
+    unsigned bits = 1;
+    while (bits < 32 && (max_value >> bits))
+        bits++;
+    return bits;
+}
+
+// Bit stream helpers. Element i takes bits [i * bits, (i + 1) * bits) of the stream, low bits
+// first, and the word after the one where the last element starts is always there, so every
+// read and write is two words without a branch. The double shifts stay below 64 when pos is
+// word aligned.
+
+// The 64 stream bits starting at bit pos
+inline std::uint64_t packed_read64(const std::uint64_t* words, std::size_t pos) noexcept
+{
+    const std::size_t word = pos / 64;
+    const unsigned offset = unsigned(pos % 64);
+    return (words[word] >> offset) | ((words[word + 1] << 1) << (63 - offset));
+}
+
+// Ors value into the stream at bit pos, the target bits must be zero
+inline void packed_or64(std::uint64_t* words, std::size_t pos, std::uint64_t value) noexcept
+{
+    const std::size_t word = pos / 64;
+    const unsigned offset = unsigned(pos % 64);
+    words[word] |= value << offset;
+    words[word + 1] |= (value >> 1) >> (63 - offset);
+}
+
+// Scalar kernels
+
+inline void packed_unpack_scalar(const std::uint64_t* words, std::uint32_t* out, std::size_t count, unsigned bits) noexcept
+{
+    const std::uint64_t mask = (std::uint64_t(1) << bits) - 1;
+    std::size_t pos = 0;
+    for (std::size_t i = 0; i < count; i++, pos += bits)
+        out[i] = std::uint32_t(packed_read64(words, pos) & mask);
+}
+
+// Writes into zeroed words, the bits above the width are dropped
+inline void packed_pack_scalar(std::uint64_t* words, const std::uint32_t* in, std::size_t count, unsigned bits) noexcept
+{
+    const std::uint64_t mask = (std::uint64_t(1) << bits) - 1;
+    std::size_t pos = 0;
+    for (std::size_t i = 0; i < count; i++, pos += bits)
+        packed_or64(words, pos, in[i] & mask);
+}
+
+#if defined(FAST_VECTOR_X86_DISPATCH)
+
+/**
+ * BMI2 kernels, 8 elements per step. Each element gets a lane of Lane >= bits bits, so one
+ * pdep spreads 64 / Lane packed elements into their lanes (and one pext gathers them back),
+ * AVX2 widens or narrows the lanes from and to the 32 bit values.
+ */
+
+// The low bits of every Lane bits wide lane set
+inline std::uint64_t packed_lane_mask(unsigned lane, unsigned bits) noexcept
+{
+    const std::uint64_t field = (std::uint64_t(1) << bits) - 1;
+    std::uint64_t mask = 0;
+    for (unsigned shift = 0; shift < 64; shift += lane)
+        mask |= field << shift;
+    return mask;
+}
+
+template <unsigned Lane>
+__attribute__((target("avx2,bmi2"))) inline void packed_unpack_bmi2(const std::uint64_t* words, std::uint32_t* out, std::size_t count, unsigned bits) noexcept
+{
+    constexpr unsigned per_chunk = 64 / Lane;
+    const std::uint64_t lanes = packed_lane_mask(Lane, bits);
+    const std::size_t chunk_bits = per_chunk * bits;
+
+    std::size_t pos = 0;
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        if constexpr (Lane == 8)
+        {
+            const std::uint64_t bytes = _pdep_u64(packed_read64(words, pos), lanes);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_cvtepu8_epi32(_mm_cvtsi64_si128((long long)bytes)));
+        }
+        else if constexpr (Lane == 16)
+        {
+            const std::uint64_t low = _pdep_u64(packed_read64(words, pos), lanes);
+            const std::uint64_t high = _pdep_u64(packed_read64(words, pos + chunk_bits), lanes);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_cvtepu16_epi32(_mm_set_epi64x((long long)high, (long long)low)));
+        }
+        else
+        {
+            for (unsigned chunk = 0; chunk < 4; chunk++)
+            {
+                const std::uint64_t pair = _pdep_u64(packed_read64(words, pos + chunk * chunk_bits), lanes);
+                std::memcpy(out + i + 2 * chunk, &pair, sizeof(pair));
+            }
+        }
+        pos += 8 * std::size_t(bits);
+    }
+
+    const std::uint64_t mask = (std::uint64_t(1) << bits) - 1;
+    for (; i < count; i++, pos += bits)
+        out[i] = std::uint32_t(packed_read64(words, pos) & mask);
+}
+
+template <unsigned Lane>
+__attribute__((target("avx2,bmi2"))) inline void packed_pack_bmi2(std::uint64_t* words, const std::uint32_t* in, std::size_t count, unsigned bits) noexcept
+{
+    constexpr unsigned per_chunk = 64 / Lane;
+    const std::uint64_t lanes = packed_lane_mask(Lane, bits);
+    const std::size_t chunk_bits = per_chunk * bits;
+
+    // Low byte / low half of every 32 bit value to the front of each 128 bit half
+    const __m256i narrow = Lane == 8 ?
+        _mm256_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                         0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1) :
+        _mm256_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1,
+                         0, 1, 4, 5, 8, 9, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1);
+    // The filled dwords of both halves next to each other
+    const __m256i gather = Lane == 8 ?
+        _mm256_setr_epi32(0, 4, 1, 2, 3, 5, 6, 7) :
+        _mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7);
+
+    std::size_t pos = 0;
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        if constexpr (Lane == 32)
+        {
+            for (unsigned chunk = 0; chunk < 4; chunk++)
+            {
+                std::uint64_t pair;
+                std::memcpy(&pair, in + i + 2 * chunk, sizeof(pair));
+                packed_or64(words, pos + chunk * chunk_bits, _pext_u64(pair, lanes));
+            }
+        }
+        else
+        {
+            __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+            __m256i packed = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(values, narrow), gather);
+            __m128i low = _mm256_castsi256_si128(packed);
+
+            packed_or64(words, pos, _pext_u64(std::uint64_t(_mm_cvtsi128_si64(low)), lanes));
+            if constexpr (Lane == 16)
+                packed_or64(words, pos + chunk_bits, _pext_u64(std::uint64_t(_mm_extract_epi64(low, 1)), lanes));
+        }
+        pos += 8 * std::size_t(bits);
+    }
+
+    const std::uint64_t mask = (std::uint64_t(1) << bits) - 1;
+    for (; i < count; i++, pos += bits)
+        packed_or64(words, pos, in[i] & mask);
+}
+
+// pdep and pext are microcoded on AMD before Zen 3, hundreds of cycles each
+inline bool packed_use_bmi2() noexcept
+{
+    static const bool use = []
+    {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("bmi2") && __builtin_cpu_supports("avx2") &&
+               !__builtin_cpu_is("znver1") && !__builtin_cpu_is("znver2");
+    }();
+    return use;
+}
+
+#endif // FAST_VECTOR_X86_DISPATCH
+
+/**
+ * Decodes count elements of the given width from the stream into out.
+ */
+inline void packed_unpack(const std::uint64_t* words, std::uint32_t* out, std::size_t count, unsigned bits) noexcept
+{
+#if defined(FAST_VECTOR_X86_DISPATCH)
+    if (packed_use_bmi2())
+    {
+        if (bits <= 8)
+            return packed_unpack_bmi2<8>(words, out, count, bits);
+        if (bits <= 16)
+            return packed_unpack_bmi2<16>(words, out, count, bits);
+        return packed_unpack_bmi2<32>(words, out, count, bits);
+    }
+#endif
+    packed_unpack_scalar(words, out, count, bits);
+}
+
+/**
+ * Encodes count values into zeroed stream words, the bits above the width are dropped.
+ */
+inline void packed_pack(std::uint64_t* words, const std::uint32_t* in, std::size_t count, unsigned bits) noexcept
+{
+#if defined(FAST_VECTOR_X86_DISPATCH)
+    if (packed_use_bmi2())
+    {
+        if (bits <= 8)
+            return packed_pack_bmi2<8>(words, in, count, bits);
+        if (bits <= 16)
+            return packed_pack_bmi2<16>(words, in, count, bits);
+        return packed_pack_bmi2<32>(words, in, count, bits);
+    }
+#endif
+    packed_pack_scalar(words, in, count, bits);
+}
+
+/**
+ * Vector of unsigned integers of Bits bits each, stored back to back in fast_vector words,
+ * so a 5 bit enum takes 5 bits instead of 32. get() and set() are two word reads without
+ * branches, unpack_to() and pack_from() convert whole ranges with BMI2 pdep/pext when the
+ * CPU has fast ones. Bits = dynamic_bits takes the width in the constructor instead.
+ */
+template <unsigned Bits, int A = 16, typename M = malloc_allocator, typename G = factor_growth<>>
+class packed_int_vector
+{
+    static_assert(Bits <= 32, "At most 32 bits per element");
+
+public:
+    using size_type = std::size_t;
+    using value_type = std::uint32_t;
+    using word_type = std::uint64_t;
+    using storage_type = fast_vector<word_type, false, A, M, G>;
+
+    // 32 bits wide for dynamic_bits
+    packed_int_vector() = default;
+    // The width of dynamic_bits vectors, must be Bits otherwise
+    explicit packed_int_vector(unsigned bits);
+
+    // Element access
+
+    value_type get(size_type pos) const noexcept;
+    value_type operator[](size_type pos) const noexcept;
+
+    // Decodes all the elements into out, resized to size()
+    template <bool F, int B, typename N, typename H>
+    void unpack_to(fast_vector<value_type, F, B, N, H>& out) const;
+    // Decodes all the elements to out, which has room for size() values
+    void unpack_to(value_type* out) const noexcept;
+
+    // The packed stream
+    const storage_type& words() const noexcept;
+
+    // Capacity
+
+    bool empty() const noexcept;
+    size_type size() const noexcept;
+    unsigned bits() const noexcept;
+    value_type max_value() const noexcept;
+    // Elements that fit before the words grow
+    size_type capacity() const noexcept;
+    void reserve(size_type new_cap);
+    void shrink_to_fit();
+
+    // Modifiers
+
+    void clear() noexcept;
+    // value must fit into bits()
+    void push_back(value_type value);
+    void set(size_type pos, value_type value) noexcept;
+
+    // Replaces the contents by the given values, the bits above the width are dropped
+    template <bool F, int B, typename N, typename H>
+    void pack_from(const fast_vector<value_type, F, B, N, H>& in);
+    void pack_from(const value_type* in, size_type count);
+
+    static void swap(packed_int_vector& a, packed_int_vector& b) noexcept;
+
+    using allocator_type = M;
+    using growth_policy = G;
+
+private:
+    word_type mask() const noexcept;
+    // Words up to the one after the start of the last of count elements
+    size_type words_for(size_type count) const noexcept;
+
+    storage_type m_words;
+    size_type m_size = 0;
+    unsigned m_bits = Bits ? Bits : 32;
+};
+
+// Width picked at runtime, see packed_bits_for()
+template <int A = 16, typename M = malloc_allocator, typename G = factor_growth<>>
+using dynamic_packed_int_vector = packed_int_vector<dynamic_bits, A, M, G>;
+
+template <unsigned Bits, int A, typename M, typename G>
+packed_int_vector<Bits,A,M,G>::packed_int_vector(unsigned bits) :
+    m_bits(bits)
+{
+    assert(bits > 0 && bits <= 32 && "Width is out of range");
+    assert((Bits == dynamic_bits || bits == Bits) && "Width differs from Bits");
+}
+
+template <unsigned Bits, int A, typename M, typename G>
+void packed_int_vector<Bits,A,M,G>::swap(packed_int_vector& a, packed_int_vector& b) noexcept
+{
+    storage_type::swap(a.m_words, b.m_words);
+    std::swap(a.m_size, b.m_size);
+    std::swap(a.m_bits, b.m_bits);
+}
+
+template <unsigned Bits, int A, typename M, typename G>
+typename packed_int_vector<Bits,A,M,G>::word_type packed_int_vector<Bits,A,M,G>::mask() const noexcept
+{
+    return (word_type(1) << bits()) - 1;
+}
+
+template <unsigned Bits, int A, typename M, typename G>
+typename packed_int_vector<Bits,A,M,G>::size_type packed_int_vector<Bits,A,M,G>::words_for(size_type count) const noexcept
+{
+    return count ? (count - 1) * bits() / 64 + 2 : 0;
+}
+
+// Element access
+
+template <unsigned Bits, int A, typename M, typename G>
+typename packed_int_vector<Bits,A,M,G>::value_type packed_int_vector<Bits,A,M,G>::get(size_type pos) const noexcept
+{
+    assert(pos < m_size && "Position is out of range");
+    return value_type(packed_read64(m_words.data(), pos * bits()) & mask());
+}
+
+template <unsigned Bits, int A, typename M, typename G>
+typename packed_int_vector<Bits,A,M,G>::value_type packed_int_vector<Bits,A,M,G>::operator[](size_type pos) const noexcept
+{
+    return get(pos);
+}
+
+template <unsigned Bits, int A, typename M, typename G>
+template <bool F, int B, typename N, typename H>
+void packed_int_vector<Bits,A,M,G>::unpack_to(fast_vector<value_type, F, B, N, H>& out) const
+{
+    out.resize(m_size, no_init);
+    unpack_to(out.data());
+}
+
+template <unsigned Bits, int A, typename M, typename G>
+void packed_int_vector<Bits,A,M,G>::unpack_to(value_type* out) const noexcept
+{
+    if (m_size)
+        packed_unpack(m_words.data(), out, m_size, bits());
+}
+
+template <unsigned Bits, int A, typename M, typename G>
+const typename packed_int_vector<Bits,A,M,G>::storage_type& packed_int_vector<Bits,A,M,G>::words() const noexcept
+{
+    return m_words;
+}
+
+// Capacity
+
+template <unsigned Bits, int A, typename M, typename G>
+bool packed_int_vector<Bits,A,M,G>::empty() const noexcept
+{
+    return m_size == 0;
+}
+
+template <unsigned Bits, int A, typename M, typename G>
+typename packed_int_vector<Bits,A,M,G>::size_type packed_int_vector<Bits,A,M,G>::size() const noexcept
+{
+    return m_size;
+}
+
+template <unsigned Bits, int A, typename M, typename G>
+unsigned packed_int_vector<Bits,A,M,G>::bits() const noexcept
+{
+    if constexpr (Bits != dynamic_bits)
+        return Bits;
+    else
+        return m_bits;
+}
+
+template <unsigned Bits, int A, typename M, typename G>
+typename packed_int_vector<Bits,A,M,G>::value_type packed_int_vector<Bits,A,M,G>::max_value() const noexcept
+{
+    return value_type(mask());
+}
+
+template <unsigned Bits, int A, typename M, typename G>
+typename packed_int_vector<Bits,A,M,G>::size_type packed_int_vector<Bits,A,M,G>::capacity() const noexcept
+{
+    return m_words.capacity() > 1 ? ((m_words.capacity() - 1) * 64 - 1) / bits() + 1 : 0;
+}
+
+template <unsigned Bits, int A, typename M, typename G>
+void packed_int_vector<Bits,A,M,G>::reserve(size_type new_cap)
+{
+    m_words.reserve(words_for(new_cap));
+}
+
+template <unsigned Bits, int A, typename M, typename G>
+void packed_int_vector<Bits,A,M,G>::shrink_to_fit()
+{
+    m_words.shrink_to_fit();
+}
+
+// Modifiers
+
+template <unsigned Bits, int A, typename M, typename G>
+void packed_int_vector<Bits,A,M,G>::clear() noexcept
+{
+    m_words.clear();
+    m_size = 0;
+}
+
+template <unsigned Bits, int A, typename M, typename G>
+void packed_int_vector<Bits,A,M,G>::push_back(value_type value)
+{
+    assert(value <= max_value() && "Value does not fit into the width");
+
+    // The words after the last element are zero, at most one is added per element
+    const size_type pos = m_size * bits();
+    while (m_words.size() < pos / 64 + 2)
+        m_words.push_back(0);
+
+    packed_or64(m_words.data(), pos, value & mask());
+    m_size++;
+}
+
+template <unsigned Bits, int A, typename M, typename G>
+void packed_int_vector<Bits,A,M,G>::set(size_type pos, value_type value) noexcept
+{
+    assert(pos < m_size && "Position is out of range");
+    assert(value <= max_value() && "Value does not fit into the width");
+
+    const size_type bit = pos * bits();
+    const size_type index = bit / 64;
+    const unsigned offset = unsigned(bit % 64);
+    const word_type field = mask();
+    const word_type item = value & field;
+
+    word_type* words = m_words.data();
+    words[index] = (words[index] & ~(field << offset)) | (item << offset);
+    words[index + 1] = (words[index + 1] & ~((field >> 1) >> (63 - offset))) | ((item >> 1) >> (63 - offset));
+}
+
+template <unsigned Bits, int A, typename M, typename G>
+template <bool F, int B, typename N, typename H>
+void packed_int_vector<Bits,A,M,G>::pack_from(const fast_vector<value_type, F, B, N, H>& in)
+{
+    pack_from(in.data(), in.size());
+}
+
+template <unsigned Bits, int A, typename M, typename G>
+void packed_int_vector<Bits,A,M,G>::pack_from(const value_type* in, size_type count)
+{
+    m_words.clear();
+    m_size = 0;
+
+    if (count == 0)
+        return;
+
+    m_words.resize(words_for(count), zero_init);
+    packed_pack(m_words.data(), in, count, bits());
+    m_size = count;
+}
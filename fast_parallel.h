@@ -0,0 +1,589 @@
+//
+// Parallel algorithms over the fast_vector family on a reusable work-stealing pool
+//
+// Advanced & fixed version by Marian Krivos
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "fast_vector.h"
+
+// Elements per chunk unless the caller picks another grain
+inline constexpr std::size_t parallel_default_grain = std::size_t(1) << 16;
+
+/**
+ * Fixed set of worker threads running index ranges. Every participant (the workers and the
+ * calling thread) gets a contiguous share of the task indices and takes them from the front,
+ * once it runs dry it steals the back half of another participant's share, so uneven tasks
+ * are balanced without a shared queue. The threads sleep between the runs and are reused,
+ * only the first run pays for spawning them.
+ */
+class fast_thread_pool
+{
+public:
+    // threads counts the caller too, so a pool of one runs everything inline
+    explicit fast_thread_pool(std::size_t threads = std::thread::hardware_concurrency());
+    fast_thread_pool(const fast_thread_pool&) = delete;
+    fast_thread_pool& operator=(const fast_thread_pool&) = delete;
+
+    ~fast_thread_pool();
+
+    std::size_t size() const noexcept;
+
+    /**
+     * Calls fn(index) for every index in [0, tasks) and returns when all are done. Runs
+     * inline when called from a task of this pool. fn must not throw.
+     */
+    template <typename Fn>
+    void run(std::size_t tasks, Fn&& fn);
+
+    // The process wide pool sized to the hardware, created on the first use
+    static fast_thread_pool& instance();
+
+private:
+    // [begin, end) of the task indices owned by one participant, packed to be swapped at once
+    struct alignas(64) share
+    {
+        std::atomic<std::uint64_t> range{0};
+    };
+
+    static std::uint64_t pack(std::uint64_t begin, std::uint64_t end) noexcept;
+
+    bool take(std::size_t self, std::size_t& task) noexcept;
+    bool steal(std::size_t self, std::size_t& task) noexcept;
+    void execute(std::size_t self, void (*invoke)(void*, std::size_t), void* context) noexcept;
+    void work(std::size_t self);
+
+    std::unique_ptr<share[]> m_shares;
+    std::vector<std::thread> m_threads;
+    std::size_t m_size;
+
+    // The current run, guarded by m_mutex
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    void (*m_invoke)(void*, std::size_t) = nullptr;
+    void* m_context = nullptr;
+    std::size_t m_generation = 0;
+    std::size_t m_active = 0;
+    bool m_open = false;
+    bool m_stop = false;
+
+    alignas(64) std::atomic<std::size_t> m_pending{0};
+    std::mutex m_run;
+
+    static inline thread_local const fast_thread_pool* t_current = nullptr;
+};
+
+inline fast_thread_pool::fast_thread_pool(std::size_t threads) :
+    m_shares(new share[threads ? threads : 1]),
+    m_size(threads ? threads : 1)
+{
+    m_threads.reserve(m_size - 1);
+
+    for (std::size_t self = 1; self < m_size; self++)
+    {
+        m_threads.emplace_back([this, self] { work(self); });
+    }
+}
+
+inline fast_thread_pool::~fast_thread_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+
+    for (std::thread& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+inline std::size_t fast_thread_pool::size() const noexcept
+{
+    return m_size;
+}
+
+inline fast_thread_pool& fast_thread_pool::instance()
+{
+    static fast_thread_pool pool;
+    return pool;
+}
+
+inline std::uint64_t fast_thread_pool::pack(std::uint64_t begin, std::uint64_t end) noexcept
+{
+    return begin << 32 | end;
+}
+
+inline bool fast_thread_pool::take(std::size_t self, std::size_t& task) noexcept
+{
+    std::atomic<std::uint64_t>& range = m_shares[self].range;
+    std::uint64_t current = range.load(std::memory_order_acquire);
+
+    for (;;)
+    {
+        std::uint64_t begin = current >> 32;
+        std::uint64_t end = current & 0xffffffffu;
+
+        if (begin >= end)
+            return steal(self, task);
+
+        if (range.compare_exchange_weak(current, pack(begin + 1, end), std::memory_order_acq_rel))
+        {
+            task = std::size_t(begin);
+            return true;
+        }
+    }
+}
+
+inline bool fast_thread_pool::steal(std::size_t self, std::size_t& task) noexcept
+{
+    for (std::size_t step = 1; step < m_size; step++)
+    {
+        std::atomic<std::uint64_t>& range = m_shares[(self + step) % m_size].range;
+        std::uint64_t current = range.load(std::memory_order_acquire);
+
+        for (;;)
+        {
+            std::uint64_t begin = current >> 32;
+            std::uint64_t end = current & 0xffffffffu;
+
+            if (begin >= end)
+                break;
+
+            // The victim keeps the front half, the thief runs the first stolen task right away
+            std::uint64_t middle = end - (end - begin + 1) / 2;
+
+            if (range.compare_exchange_weak(current, pack(begin, middle), std::memory_order_acq_rel))
+            {
+                m_shares[self].range.store(pack(middle + 1, end), std::memory_order_release);
+                task = std::size_t(middle);
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+inline void fast_thread_pool::execute(std::size_t self, void (*invoke)(void*, std::size_t), void* context) noexcept
+{
+    const fast_thread_pool* outer = t_current;
+    t_current = this;
+
+    std::size_t task;
+    while (take(self, task))
+    {
+        invoke(context, task);
+
+        if (m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_done.notify_all();
+        }
+    }
+
+    t_current = outer;
+}
+
+inline void fast_thread_pool::work(std::size_t self)
+{
+    std::size_t seen = 0;
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    for (;;)
+    {
+        m_wake.wait(lock, [&] { return m_stop || (m_open && m_generation != seen); });
+        if (m_stop)
+            return;
+
+        seen = m_generation;
+        auto invoke = m_invoke;
+        void* context = m_context;
+        m_active++;
+
+        lock.unlock();
+        execute(self, invoke, context);
+        lock.lock();
+
+        if (--m_active == 0)
+            m_done.notify_all();
+    }
+}
+
+template <typename Fn>
+void fast_thread_pool::run(std::size_t tasks, Fn&& fn)
+{
+    if (tasks == 0)
+        return;
+
+    if (m_size == 1 || tasks == 1 || t_current == this)
+    {
+        for (std::size_t task = 0; task < tasks; task++)
+            fn(task);
+        return;
+    }
+
+    assert(tasks <= 0xffffffffu && "Too many tasks for one run");
+
+    // One run at a time, concurrent callers queue up here
+    std::lock_guard<std::mutex> run_lock(m_run);
+
+    auto invoke = [](void* context, std::size_t task)
+    {
+        (*static_cast<std::remove_reference_t<Fn>*>(context))(task);
+    };
+
+    // Even initial shares, the stealing evens out the rest
+    for (std::size_t self = 0; self < m_size; self++)
+    {
+        m_shares[self].range.store(pack(tasks * self / m_size, tasks * (self + 1) / m_size), std::memory_order_relaxed);
+    }
+    m_pending.store(tasks, std::memory_order_relaxed);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_invoke = invoke;
+        m_context = const_cast<void*>(static_cast<const void*>(std::addressof(fn)));
+        m_generation++;
+        m_open = true;
+    }
+    m_wake.notify_all();
+
+    execute(0, invoke, m_context);
+
+    // Late workers must not join, and the ones inside must leave before fn goes away
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_pending.load(std::memory_order_acquire) == 0; });
+    m_open = false;
+    m_done.wait(lock, [this] { return m_active == 0; });
+}
+
+/**
+ * Splits n elements starting at first into chunks of about grain elements whose inner
+ * boundaries fall on cache lines, so no two threads write the same line.
+ */
+template <typename T>
+class parallel_chunks
+{
+public:
+    parallel_chunks(const T* first, std::size_t count, std::size_t grain) noexcept :
+        m_count(count)
+    {
+        constexpr std::size_t line = 64;
+        constexpr std::size_t line_items = line % sizeof(T) == 0 ? line / sizeof(T) : 1;
+
+        m_step = grain < line_items ? line_items : (grain + line_items - 1) / line_items * line_items;
+
+        std::size_t misalignment = reinterpret_cast<std::uintptr_t>(first) % line;
+        m_head = line_items > 1 && misalignment % sizeof(T) == 0 ? (line - misalignment) % line / sizeof(T) : 0;
+    }
+
+    std::size_t size() const noexcept
+    {
+        if (m_count <= m_head + m_step)
+            return 1;
+        return 1 + (m_count - m_head - m_step + m_step - 1) / m_step;
+    }
+
+    std::size_t begin(std::size_t chunk) const noexcept
+    {
+        return chunk ? m_head + chunk * m_step : 0;
+    }
+
+    std::size_t end(std::size_t chunk) const noexcept
+    {
+        std::size_t last = m_head + (chunk + 1) * m_step;
+        return last < m_count ? last : m_count;
+    }
+
+private:
+    std::size_t m_count;
+    std::size_t m_step;
+    std::size_t m_head;
+};
+
+/**
+ * Calls fn(item) for every element of v.
+ */
+template <typename V, typename Fn>
+void parallel_for_each(V& v, Fn fn, std::size_t grain = parallel_default_grain, fast_thread_pool& pool = fast_thread_pool::instance())
+{
+    auto* items = v.data();
+    parallel_chunks<std::remove_pointer_t<decltype(items)>> chunks(items, v.size(), grain);
+
+    pool.run(chunks.size(), [&](std::size_t chunk)
+    {
+        for (std::size_t i = chunks.begin(chunk), end = chunks.end(chunk); i < end; i++)
+            fn(items[i]);
+    });
+}
+
+/**
+ * out[i] = fn(in[i]), out is resized to the size of in when shorter. in and out may be the same vector.
+ */
+template <typename V, typename W, typename Fn>
+void parallel_transform(const V& in, W& out, Fn fn, std::size_t grain = parallel_default_grain, fast_thread_pool& pool = fast_thread_pool::instance())
+{
+    if (out.size() < in.size())
+        out.resize(in.size());
+
+    const auto* source = in.data();
+    auto* dest = out.data();
+    parallel_chunks<std::remove_pointer_t<decltype(dest)>> chunks(dest, in.size(), grain);
+
+    pool.run(chunks.size(), [&](std::size_t chunk)
+    {
+        for (std::size_t i = chunks.begin(chunk), end = chunks.end(chunk); i < end; i++)
+            dest[i] = fn(source[i]);
+    });
+}
+
+/**
+ * Folds the elements with op starting from init. Every chunk is folded on its own and the
+ * chunk results in their order, so op has to be associative; the result does not depend on
+ * the thread count for a given grain.
+ */
+template <typename V, typename R, typename Op>
+R parallel_reduce(const V& v, R init, Op op, std::size_t grain = parallel_default_grain, fast_thread_pool& pool = fast_thread_pool::instance())
+{
+    const auto* items = v.data();
+    parallel_chunks<std::remove_const_t<std::remove_pointer_t<decltype(items)>>> chunks(items, v.size(), grain);
+
+    if (v.size() == 0)
+        return init;
+
+    // One slot per chunk, R has to be default constructible
+    fast_vector<R> partials(chunks.size());
+
+    pool.run(chunks.size(), [&](std::size_t chunk)
+    {
+        std::size_t i = chunks.begin(chunk);
+        std::size_t end = chunks.end(chunk);
+
+        R partial = items[i++];
+        for (; i < end; i++)
+            partial = op(partial, items[i]);
+
+        partials[chunk] = std::move(partial);
+    });
+
+    for (std::size_t chunk = 0; chunk < partials.size(); chunk++)
+        init = op(init, partials[chunk]);
+
+    return init;
+}
+
+/**
+ * Assigns value to every element of v.
+ */
+template <typename V, typename T>
+void parallel_fill(V& v, const T& value, std::size_t grain = parallel_default_grain, fast_thread_pool& pool = fast_thread_pool::instance())
+{
+    auto* items = v.data();
+    parallel_chunks<std::remove_pointer_t<decltype(items)>> chunks(items, v.size(), grain);
+
+    pool.run(chunks.size(), [&](std::size_t chunk)
+    {
+        for (std::size_t i = chunks.begin(chunk), end = chunks.end(chunk); i < end; i++)
+            items[i] = value;
+    });
+}
+
+/**
+ * Counts the elements equal to value, with the SIMD kernels of the fast_vector where they apply.
+ */
+template <typename V, typename T>
+std::size_t parallel_count(const V& v, const T& value, std::size_t grain = parallel_default_grain, fast_thread_pool& pool = fast_thread_pool::instance())
+{
+    using item_type = std::remove_const_t<std::remove_pointer_t<decltype(v.data())>>;
+
+    const item_type* items = v.data();
+    parallel_chunks<item_type> chunks(items, v.size(), grain);
+    std::atomic<std::size_t> total{0};
+
+    pool.run(chunks.size(), [&](std::size_t chunk)
+    {
+        const item_type* begin = items + chunks.begin(chunk);
+        const item_type* end = items + chunks.end(chunk);
+        std::size_t count = 0;
+
+        if constexpr (is_simd_element_v<item_type>)
+        {
+            count = count_equal<item_type>(begin, end, item_type(value));
+        }
+        else
+        {
+            for (; begin != end; ++begin)
+                count += *begin == value;
+        }
+
+        total.fetch_add(count, std::memory_order_relaxed);
+    });
+
+    return total.load(std::memory_order_relaxed);
+}
+
+// Vectors below this size are sorted on the calling thread
+inline constexpr std::size_t parallel_sort_threshold = 10'000'000;
+
+/**
+ * radix_sort() spread over the pool. Every participant owns a contiguous block; in each pass
+ * it counts the key bytes of its block, a prefix sum ordered by digit and then by block gives
+ * each block its own output offsets, and all the blocks are scattered at once. Stable.
+ */
+template <typename T, typename Key>
+void parallel_radix_sort(T* data, T* scratch, std::size_t count, Key key, fast_thread_pool& pool = fast_thread_pool::instance())
+{
+    using key_type = decltype(key(*data));
+
+    if (count < 2)
+        return;
+
+    const std::size_t blocks = pool.size() < count ? pool.size() : count;
+    const std::size_t block = (count + blocks - 1) / blocks;
+    fast_vector<std::size_t> offsets(blocks * 256);
+
+    T* from = data;
+    T* to = scratch;
+
+    // An already sorted input is noticed by the first counting run, every block checks its
+    // own order and the one across its start
+    std::atomic<bool> unsorted{false};
+
+    for (std::size_t pass = 0; pass < sizeof(key_type); pass++)
+    {
+        const unsigned shift = unsigned(pass * 8);
+
+        pool.run(blocks, [&](std::size_t b)
+        {
+            std::size_t* counts = &offsets[b * 256];
+            std::fill(counts, counts + 256, std::size_t(0));
+
+            std::size_t i = b * block;
+            const std::size_t end = std::min(count, i + block);
+
+            if (pass == 0)
+            {
+                bool sorted = true;
+                for (key_type previous = key(from[i ? i - 1 : 0]); i < end; i++)
+                {
+                    const key_type k = key(from[i]);
+                    ++counts[k & 0xff];
+                    sorted &= previous <= k;
+                    previous = k;
+                }
+
+                if (!sorted)
+                    unsorted.store(true, std::memory_order_relaxed);
+                return;
+            }
+
+            for (; i < end; i++)
+                ++counts[(key(from[i]) >> shift) & 0xff];
+        });
+
+        if (pass == 0 && !unsorted.load(std::memory_order_relaxed))
+            return;
+
+        const std::size_t first_digit = (key(from[0]) >> shift) & 0xff;
+        std::size_t same = 0;
+        for (std::size_t b = 0; b < blocks; b++)
+            same += offsets[b * 256 + first_digit];
+
+        if (same == count)
+            continue;
+
+        std::size_t sum = 0;
+        for (std::size_t digit = 0; digit < 256; digit++)
+        {
+            for (std::size_t b = 0; b < blocks; b++)
+            {
+                const std::size_t n = offsets[b * 256 + digit];
+                offsets[b * 256 + digit] = sum;
+                sum += n;
+            }
+        }
+
+        pool.run(blocks, [&](std::size_t b)
+        {
+            std::size_t* next = &offsets[b * 256];
+
+            for (std::size_t i = b * block, end = std::min(count, i + block); i < end; i++)
+            {
+                const std::size_t digit = (key(from[i]) >> shift) & 0xff;
+                std::memcpy(static_cast<void*>(to + next[digit]++), static_cast<const void*>(from + i), sizeof(T));
+            }
+        });
+
+        std::swap(from, to);
+    }
+
+    if (from != data)
+    {
+        pool.run(blocks, [&](std::size_t b)
+        {
+            const std::size_t i = b * block;
+            const std::size_t end = std::min(count, i + block);
+            std::memcpy(static_cast<void*>(data + i), static_cast<const void*>(from + i), sizeof(T) * (end - i));
+        });
+    }
+}
+
+/**
+ * v.sort_by_key(key), radix sorted on the pool when v holds at least parallel_sort_threshold
+ * elements and the key has radix_key_traits<>.
+ */
+template <typename T, bool F, int A, typename M, typename G, typename Key>
+void parallel_sort_by_key(fast_vector<T,F,A,M,G>& v, Key key, fast_thread_pool& pool = fast_thread_pool::instance())
+{
+    using key_type = std::decay_t<std::invoke_result_t<Key&, const T&>>;
+    constexpr std::size_t alignment = fast_vector<T,F,A,M,G>::alignment;
+
+    if constexpr (has_radix_key_v<key_type> && (is_trivially_relocatable_v<T> || F))
+    {
+        if (v.size() >= parallel_sort_threshold && pool.size() > 1)
+        {
+            T* scratch = reinterpret_cast<T*>(M::allocate(sizeof(T) * v.size(), alignment));
+
+            if (scratch)
+            {
+                parallel_radix_sort(v.data(), scratch, v.size(),
+                    [&key](const T& item) { return radix_key_traits<key_type>::key(std::invoke(key, item)); }, pool);
+                M::deallocate(scratch, sizeof(T) * v.size(), alignment);
+                return;
+            }
+        }
+    }
+
+    v.sort_by_key(key);
+}
+
+/**
+ * v.sort(), radix sorted on the pool when v holds at least parallel_sort_threshold elements
+ * with radix_key_traits<>.
+ */
+template <typename T, bool F, int A, typename M, typename G>
+void parallel_sort(fast_vector<T,F,A,M,G>& v, fast_thread_pool& pool = fast_thread_pool::instance())
+{
+    if constexpr (has_radix_key_v<T>)
+    {
+        parallel_sort_by_key(v, [](const T& item) -> const T& { return item; }, pool);
+    }
+    else
+    {
+        v.sort();
+    }
+}
@@ -0,0 +1,637 @@
+//
+// Chunked sibling of the fast_vector, elements never move once appended
+//
+// Advanced & fixed version by Marian Krivos
+//
+
+#pragma once
+
+#include "fast_vector.h"
+
+/**
+ * The fast_vector stored in fixed chunks of 2^ChunkBits elements, found through a small
+ * directory of chunk pointers. Appending never moves the existing elements, so pointers and
+ * references stay valid, and indexing costs a shift and a mask. Every chunk is contiguous
+ * and aligned, chunk() and for_each_chunk() hand them out for vectorized bulk loops.
+ */
+template <typename T, std::size_t ChunkBits = 12, bool F = false, int A = 16, typename M = malloc_allocator>
+class fast_segmented_vector
+{
+    template <typename U>
+    class basic_iterator;
+
+public:
+    using size_type = std::size_t;
+    using value_type = T;
+    using iterator = basic_iterator<T>;
+    using const_iterator = basic_iterator<const T>;
+
+    fast_segmented_vector() = default;
+    fast_segmented_vector(const fast_segmented_vector& other);
+    fast_segmented_vector(fast_segmented_vector&& other) noexcept;
+    fast_segmented_vector& operator=(const fast_segmented_vector& other);
+    fast_segmented_vector& operator=(fast_segmented_vector&& other) noexcept;
+
+    ~fast_segmented_vector();
+
+    // Element access
+
+    T& operator[](size_type pos);
+    const T& operator[](size_type pos) const;
+
+#if !defined(FAST_VECTOR_NO_EXCEPTIONS)
+    T& at(size_type pos);
+    const T& at(size_type pos) const;
+#endif
+
+    T& front();
+    const T& front() const;
+
+    T& back();
+    const T& back() const;
+
+    // Chunks, the last one may be partially filled
+
+    size_type chunk_count() const noexcept;
+    fast_span<T> chunk(size_type index) noexcept;
+    fast_span<const T> chunk(size_type index) const noexcept;
+
+    // Calls fn(fast_span<T>) for every chunk holding elements, in order
+    template< class Fn >
+    void for_each_chunk(Fn&& fn);
+    template< class Fn >
+    void for_each_chunk(Fn&& fn) const;
+
+    // Iterators
+
+    iterator begin() noexcept;
+    const_iterator begin() const noexcept;
+
+    iterator end() noexcept;
+    const_iterator end() const noexcept;
+
+    // Capacity
+
+    bool empty() const noexcept;
+    size_type size() const noexcept;
+    void reserve(size_type new_cap);
+    size_type capacity() const noexcept;
+    // Releases the chunks past the last element
+    void shrink_to_fit();
+
+    // Modifiers
+
+    void clear() noexcept;
+
+    void push_back(const T& value);
+    void push_back(T&& value);
+
+    template< class... Args >
+    T& emplace_back(Args&&... args);
+
+    // Copies chunk by chunk, memcpy for the trivial types
+    void append(const T values[], size_type count);
+
+    void pop_back();
+    void resize(size_type count);
+
+    static void swap(fast_segmented_vector& a, fast_segmented_vector& b);
+
+    static constexpr size_type chunk_size = size_type(1) << ChunkBits;
+    static constexpr size_type alignment = A > int(alignof(T)) ? size_type(A) : alignof(T);
+
+    static_assert(ChunkBits < sizeof(size_type) * 8, "Chunk size out of range");
+    static_assert(A > 0 && (A & (A - 1)) == 0, "Alignment must be a power of two");
+
+    using allocator_type = M;
+
+private:
+    static constexpr size_type chunk_mask = chunk_size - 1;
+    static constexpr bool trivial = std::is_trivial_v<T> | F;
+
+    T* slot(size_type pos) const noexcept;
+    void add_chunk();
+    void next_chunk();
+    void set_size(size_type count) noexcept;
+
+    // The directory, chunks are never moved once allocated
+    fast_vector<T*> m_chunks;
+    // Append cursor and end of the last used chunk, both null while no chunk is used. No separate
+    // size counter: a size_t member may alias the stored elements and would be spilled on every append
+    T* m_tail = nullptr;
+    T* m_tail_end = nullptr;
+    // Index of the first element of the m_tail chunk
+    size_type m_tail_first = 0;
+};
+
+/**
+ * Walks the elements chunk by chunk, the chunk pointer is looked up only when crossing into the next one.
+ */
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+template <typename U>
+class fast_segmented_vector<T,ChunkBits,F,A,M>::basic_iterator
+{
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::remove_const_t<U>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = U*;
+    using reference = U&;
+
+    basic_iterator() = default;
+
+    basic_iterator(T* const* chunks, size_type chunk_count, size_type index) noexcept :
+        m_chunks(chunks),
+        m_chunk_count(chunk_count),
+        m_index(index),
+        m_item((index >> ChunkBits) < chunk_count ? chunks[index >> ChunkBits] + (index & chunk_mask) : nullptr)
+    {
+    }
+
+    U& operator*() const noexcept { return *m_item; }
+    U* operator->() const noexcept { return m_item; }
+
+    basic_iterator& operator++() noexcept
+    {
+        m_index++;
+        if (m_index & chunk_mask)
+            m_item++;
+        else
+            m_item = (m_index >> ChunkBits) < m_chunk_count ? m_chunks[m_index >> ChunkBits] : nullptr;
+        return *this;
+    }
+
+    basic_iterator operator++(int) noexcept
+    {
+        basic_iterator previous = *this;
+        ++*this;
+        return previous;
+    }
+
+    // Position of the element in the vector
+    size_type index() const noexcept { return m_index; }
+
+    bool operator==(const basic_iterator& other) const noexcept { return m_index == other.m_index; }
+    bool operator!=(const basic_iterator& other) const noexcept { return m_index != other.m_index; }
+
+private:
+    T* const* m_chunks = nullptr;
+    size_type m_chunk_count = 0;
+    size_type m_index = 0;
+    U* m_item = nullptr;
+};
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+fast_segmented_vector<T,ChunkBits,F,A,M>::fast_segmented_vector(const fast_segmented_vector& other)
+{
+    reserve(other.size());
+
+    size_type count = 0;
+
+    other.for_each_chunk([this, &count](fast_span<const T> items)
+    {
+        T* dest = slot(count);
+
+        if constexpr (trivial)
+        {
+            std::memcpy(static_cast<void*>(dest), items.data(), sizeof(T) * items.size());
+        }
+        else
+        {
+            copy_range(items.begin(), items.end(), dest);
+        }
+
+        count += items.size();
+    });
+
+    set_size(count);
+}
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+fast_segmented_vector<T,ChunkBits,F,A,M>::fast_segmented_vector(fast_segmented_vector&& other) noexcept
+{
+    swap(*this, other);
+}
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+fast_segmented_vector<T,ChunkBits,F,A,M>& fast_segmented_vector<T,ChunkBits,F,A,M>::operator=(const fast_segmented_vector& other)
+{
+    if (this != &other)
+    {
+        fast_segmented_vector copy(other);
+        swap(*this, copy);
+    }
+    return *this;
+}
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+fast_segmented_vector<T,ChunkBits,F,A,M>& fast_segmented_vector<T,ChunkBits,F,A,M>::operator=(fast_segmented_vector&& other) noexcept
+{
+    if (this != &other)
+    {
+        fast_segmented_vector released(std::move(other));
+        swap(*this, released);
+    }
+    return *this;
+}
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+fast_segmented_vector<T,ChunkBits,F,A,M>::~fast_segmented_vector()
+{
+    clear();
+
+    for (T* chunk : m_chunks)
+    {
+        M::deallocate(chunk, sizeof(T) * chunk_size, alignment);
+    }
+}
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+void fast_segmented_vector<T,ChunkBits,F,A,M>::swap(fast_segmented_vector& a, fast_segmented_vector& b)
+{
+    fast_vector<T*>::swap(a.m_chunks, b.m_chunks);
+    std::swap(a.m_tail, b.m_tail);
+    std::swap(a.m_tail_end, b.m_tail_end);
+    std::swap(a.m_tail_first, b.m_tail_first);
+}
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+T* fast_segmented_vector<T,ChunkBits,F,A,M>::slot(size_type pos) const noexcept
+{
+    return m_chunks[pos >> ChunkBits] + (pos & chunk_mask);
+}
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+void fast_segmented_vector<T,ChunkBits,F,A,M>::add_chunk()
+{
+    // The directory entry goes first, nothing leaks when it cannot grow
+    m_chunks.push_back(nullptr);
+
+    T* chunk = reinterpret_cast<T*>(M::allocate(sizeof(T) * chunk_size, alignment));
+    if (!chunk)
+    {
+        m_chunks.pop_back();
+        fast_vector_out_of_memory();
+    }
+
+    m_chunks.back() = chunk;
+}
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+void fast_segmented_vector<T,ChunkBits,F,A,M>::next_chunk()
+{
+    // The cursor runs out only on a chunk boundary, the next chunk may be reserved already
+    size_type count = size();
+
+    if (count == capacity())
+    {
+        add_chunk();
+    }
+
+    m_tail = slot(count);
+    m_tail_end = m_tail + chunk_size;
+    m_tail_first = count;
+}
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+void fast_segmented_vector<T,ChunkBits,F,A,M>::set_size(size_type count) noexcept
+{
+    if (count == 0)
+    {
+        m_tail = m_tail_end = nullptr;
+        m_tail_first = 0;
+        return;
+    }
+
+    // The cursor stays in the chunk of the last element, a full chunk is left on the next append
+    size_type last = count - 1;
+
+    m_tail_first = last & ~chunk_mask;
+    m_tail = m_chunks[last >> ChunkBits] + (last & chunk_mask) + 1;
+    m_tail_end = m_tail - (count - m_tail_first) + chunk_size;
+}
+
+// Element access
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+T& fast_segmented_vector<T,ChunkBits,F,A,M>::operator[](size_type pos)
+{
+    assert(pos < size() && "Position is out of range");
+    return *slot(pos);
+}
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+const T& fast_segmented_vector<T,ChunkBits,F,A,M>::operator[](size_type pos) const
+{
+    assert(pos < size() && "Position is out of range");
+    return *slot(pos);
+}
+
+#if !defined(FAST_VECTOR_NO_EXCEPTIONS)
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+T& fast_segmented_vector<T,ChunkBits,F,A,M>::at(size_type pos)
+{
+    if (pos >= size())
+        throw std::range_error{"Position is out of range"};
+
+    return operator [](pos);
+}
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+const T& fast_segmented_vector<T,ChunkBits,F,A,M>::at(size_type pos) const
+{
+    if (pos >= size())
+        throw std::range_error{"Position is out of range"};
+
+    return operator [](pos);
+}
+
+#endif // FAST_VECTOR_NO_EXCEPTIONS
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+T& fast_segmented_vector<T,ChunkBits,F,A,M>::front()
+{
+    assert(!empty() && "Container is empty");
+    return *slot(0);
+}
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+const T& fast_segmented_vector<T,ChunkBits,F,A,M>::front() const
+{
+    assert(!empty() && "Container is empty");
+    return *slot(0);
+}
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+T& fast_segmented_vector<T,ChunkBits,F,A,M>::back()
+{
+    assert(!empty() && "Container is empty");
+    return *slot(size() - 1);
+}
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+const T& fast_segmented_vector<T,ChunkBits,F,A,M>::back() const
+{
+    assert(!empty() && "Container is empty");
+    return *slot(size() - 1);
+}
+
+// Chunks
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+typename fast_segmented_vector<T,ChunkBits,F,A,M>::size_type fast_segmented_vector<T,ChunkBits,F,A,M>::chunk_count() const noexcept
+{
+    return (size() + chunk_mask) >> ChunkBits;
+}
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+fast_span<T> fast_segmented_vector<T,ChunkBits,F,A,M>::chunk(size_type index) noexcept
+{
+    assert(index < chunk_count() && "Chunk is out of range");
+
+    size_type rest = size() - (index << ChunkBits);
+    size_type count = rest < chunk_size ? rest : chunk_size;
+
+    return {assume_aligned<alignment>(m_chunks[index]), count};
+}
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+fast_span<const T> fast_segmented_vector<T,ChunkBits,F,A,M>::chunk(size_type index) const noexcept
+{
+    assert(index < chunk_count() && "Chunk is out of range");
+
+    size_type rest = size() - (index << ChunkBits);
+    size_type count = rest < chunk_size ? rest : chunk_size;
+
+    return {assume_aligned<alignment>(static_cast<const T*>(m_chunks[index])), count};
+}
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+template< class Fn >
+void fast_segmented_vector<T,ChunkBits,F,A,M>::for_each_chunk(Fn&& fn)
+{
+    for (size_type index = 0, count = chunk_count(); index < count; index++)
+    {
+        fn(chunk(index));
+    }
+}
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+template< class Fn >
+void fast_segmented_vector<T,ChunkBits,F,A,M>::for_each_chunk(Fn&& fn) const
+{
+    for (size_type index = 0, count = chunk_count(); index < count; index++)
+    {
+        fn(chunk(index));
+    }
+}
+
+// Iterators
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+typename fast_segmented_vector<T,ChunkBits,F,A,M>::iterator fast_segmented_vector<T,ChunkBits,F,A,M>::begin() noexcept
+{
+    return iterator(m_chunks.data(), m_chunks.size(), 0);
+}
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+typename fast_segmented_vector<T,ChunkBits,F,A,M>::const_iterator fast_segmented_vector<T,ChunkBits,F,A,M>::begin() const noexcept
+{
+    return const_iterator(m_chunks.data(), m_chunks.size(), 0);
+}
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+typename fast_segmented_vector<T,ChunkBits,F,A,M>::iterator fast_segmented_vector<T,ChunkBits,F,A,M>::end() noexcept
+{
+    return iterator(m_chunks.data(), m_chunks.size(), size());
+}
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+typename fast_segmented_vector<T,ChunkBits,F,A,M>::const_iterator fast_segmented_vector<T,ChunkBits,F,A,M>::end() const noexcept
+{
+    return const_iterator(m_chunks.data(), m_chunks.size(), size());
+}
+
+// Capacity
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+bool fast_segmented_vector<T,ChunkBits,F,A,M>::empty() const noexcept
+{
+    return size() == 0;
+}
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+typename fast_segmented_vector<T,ChunkBits,F,A,M>::size_type fast_segmented_vector<T,ChunkBits,F,A,M>::size() const noexcept
+{
+    if (!m_tail)
+        return 0;
+
+    return m_tail_first + chunk_size - size_type(m_tail_end - m_tail);
+}
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+typename fast_segmented_vector<T,ChunkBits,F,A,M>::size_type fast_segmented_vector<T,ChunkBits,F,A,M>::capacity() const noexcept
+{
+    return m_chunks.size() << ChunkBits;
+}
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+void fast_segmented_vector<T,ChunkBits,F,A,M>::reserve(size_type new_cap)
+{
+    m_chunks.reserve((new_cap + chunk_mask) >> ChunkBits);
+
+    while (capacity() < new_cap)
+    {
+        add_chunk();
+    }
+}
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+void fast_segmented_vector<T,ChunkBits,F,A,M>::shrink_to_fit()
+{
+    while (m_chunks.size() > chunk_count())
+    {
+        M::deallocate(m_chunks.back(), sizeof(T) * chunk_size, alignment);
+        m_chunks.pop_back();
+    }
+
+    m_chunks.shrink_to_fit();
+}
+
+// Modifiers
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+void fast_segmented_vector<T,ChunkBits,F,A,M>::clear() noexcept
+{
+    if constexpr (!trivial)
+    {
+        for_each_chunk([](fast_span<T> items)
+        {
+            destruct_range(items.begin(), items.end());
+        });
+    }
+
+    set_size(0);
+}
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+void fast_segmented_vector<T,ChunkBits,F,A,M>::push_back(const T& value)
+{
+    // No element ever moves, a value living inside stays valid
+    if (m_tail == m_tail_end)
+    {
+        next_chunk();
+    }
+
+    new (m_tail) T(value);
+    m_tail++;
+}
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+void fast_segmented_vector<T,ChunkBits,F,A,M>::push_back(T&& value)
+{
+    if (m_tail == m_tail_end)
+    {
+        next_chunk();
+    }
+
+    new (m_tail) T(std::move(value));
+    m_tail++;
+}
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+template< class... Args >
+T& fast_segmented_vector<T,ChunkBits,F,A,M>::emplace_back(Args&&... args)
+{
+    if (m_tail == m_tail_end)
+    {
+        next_chunk();
+    }
+
+    T* item = new (m_tail) T(std::forward<Args>(args)...);
+    m_tail++;
+
+    return *item;
+}
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+void fast_segmented_vector<T,ChunkBits,F,A,M>::append(const T values[], size_type count)
+{
+    while (count)
+    {
+        if (m_tail == m_tail_end)
+        {
+            next_chunk();
+        }
+
+        size_type room = size_type(m_tail_end - m_tail);
+        size_type part = count < room ? count : room;
+
+        if constexpr (trivial)
+        {
+            std::memcpy(static_cast<void*>(m_tail), values, sizeof(T) * part);
+        }
+        else
+        {
+            copy_range(values, values + part, m_tail);
+        }
+
+        m_tail += part;
+        values += part;
+        count -= part;
+    }
+}
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+void fast_segmented_vector<T,ChunkBits,F,A,M>::pop_back()
+{
+    assert(!empty() && "Container is empty");
+
+    // A throwing constructor may leave the cursor at the start of the next chunk
+    if (m_tail == m_tail_end - chunk_size)
+    {
+        set_size(size());
+    }
+
+    m_tail--;
+
+    if constexpr (!trivial)
+    {
+        m_tail->~T();
+    }
+
+    // Leaving the chunk of the popped element, the cursor moves to the end of the previous one
+    if (m_tail == m_tail_end - chunk_size)
+    {
+        set_size(m_tail_first);
+    }
+}
+
+template <typename T, std::size_t ChunkBits, bool F, int A, typename M>
+void fast_segmented_vector<T,ChunkBits,F,A,M>::resize(size_type count)
+{
+    size_type current = size();
+
+    if (count > current)
+    {
+        reserve(count);
+
+        if constexpr (!trivial)
+        {
+            for (; current < count; current++)
+            {
+                new (slot(current)) T;
+            }
+        }
+    }
+    else if constexpr (!trivial)
+    {
+        for (; current > count; current--)
+        {
+            slot(current - 1)->~T();
+        }
+    }
+
+    set_size(count);
+}
@@ -0,0 +1,662 @@
+//
+// Small buffer optimized sibling of the fast_vector
+//
+// Advanced & fixed version by Marian Krivos
+//
+
+#pragma once
+
+#include "fast_vector.h"
+
+/**
+ * The fast_vector with the first N elements stored inside the object itself.
+ * The heap (through the allocation policy M) is used only after the inline buffer overflows.
+ */
+template <typename T, std::size_t N = 16, bool F = false, int A = 16, typename M = malloc_allocator, typename G = factor_growth<>>
+class fast_small_vector
+{
+public:
+    using size_type = std::size_t;
+    using value_type = T;
+
+    fast_small_vector() = default;
+    fast_small_vector(size_t size);
+    fast_small_vector(const fast_small_vector& other);
+    fast_small_vector(std::initializer_list<T>&& other);
+    fast_small_vector(fast_small_vector&& other) noexcept;
+    fast_small_vector& operator=(const fast_small_vector& other);
+    fast_small_vector& operator=(fast_small_vector&& other) noexcept;
+    fast_small_vector(const T a[], const T b[]);
+
+    ~fast_small_vector();
+
+    // Element access
+
+    T& operator[](size_type pos);
+    const T& operator[](size_type pos) const;
+
+#if !defined(FAST_VECTOR_NO_EXCEPTIONS)
+    T& at(size_type pos);
+    const T& at(size_type pos) const;
+#endif
+
+    T& front();
+    const T& front() const;
+
+    T& back();
+    const T& back() const;
+
+    T* data() noexcept;
+    const T* data() const noexcept;
+
+    // Iterators
+
+    T* begin() noexcept;
+    const T* begin() const noexcept;
+
+    T* end() noexcept;
+    const T* end() const noexcept;
+
+    // Capacity
+
+    bool empty() const noexcept;
+    size_type size() const noexcept;
+    void reserve(size_type new_cap);
+    size_type capacity() const noexcept;
+    void shrink_to_fit();
+
+    // True while the elements live in the inline buffer
+    bool is_inline() const noexcept;
+
+    // Modifiers
+
+    void clear() noexcept;
+
+    void push_back(const T& value);
+    void push_back(T&& value);
+
+    template< class... Args >
+    void emplace_back(Args&&... args);
+
+    void append(const T value[], size_t count);
+
+    void pop_back();
+    void resize(size_type count);
+    bool erase(const T value);
+
+    static void swap(fast_small_vector& a, fast_small_vector& b);
+
+    static constexpr size_type inline_capacity = N;
+    static constexpr size_type alignment = A > int(alignof(T)) ? size_type(A) : alignof(T);
+
+    static_assert(N > 0, "Use fast_vector when no inline storage is wanted");
+    static_assert(A > 0 && (A & (A - 1)) == 0, "Alignment must be a power of two");
+
+    using allocator_type = M;
+    using growth_policy = G;
+
+private:
+    // Elements may be moved by realloc/memmove instead of constructors
+    static constexpr bool relocatable = is_trivially_relocatable_v<T> | F;
+
+    T* inline_data() noexcept;
+    const T* inline_data() const noexcept;
+
+    // Moves the elements of other (inline ones) into this empty vector
+    void steal(fast_small_vector& other) noexcept;
+    // Moves the elements to new_data, releasing the current heap block
+    void relocate(T* new_data);
+
+    T* m_data = reinterpret_cast<T*>(m_buffer);
+    size_type m_size = 0;
+    size_type m_capacity = N;
+    alignas(alignment) unsigned char m_buffer[N * sizeof(T)];
+};
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+fast_small_vector<T,N,F,A,M,G>::fast_small_vector(size_t size)
+{
+    reserve(size);
+
+    if constexpr (!(std::is_trivial_v<T> | F))
+        construct_range(m_data, m_data + size);
+
+    m_size = size;
+}
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+fast_small_vector<T,N,F,A,M,G>::fast_small_vector(std::initializer_list<T>&& other) :
+    fast_small_vector(other.begin(), other.end())
+{
+}
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+fast_small_vector<T,N,F,A,M,G>::fast_small_vector(const T a[], const T b[])
+{
+    append(a, b - a);
+}
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+fast_small_vector<T,N,F,A,M,G>::fast_small_vector(const fast_small_vector& other)
+{
+    append(other.m_data, other.m_size);
+}
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+fast_small_vector<T,N,F,A,M,G>::fast_small_vector(fast_small_vector&& other) noexcept
+{
+    steal(other);
+}
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+fast_small_vector<T,N,F,A,M,G>& fast_small_vector<T,N,F,A,M,G>::operator=(const fast_small_vector& other)
+{
+    if (this != &other)
+    {
+        // Copied aside first, a failed allocation leaves this vector intact
+        fast_small_vector copy(other);
+        *this = std::move(copy);
+    }
+
+    return *this;
+}
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+fast_small_vector<T,N,F,A,M,G>& fast_small_vector<T,N,F,A,M,G>::operator=(fast_small_vector&& other) noexcept
+{
+    if (this != &other)
+    {
+        this->~fast_small_vector<T,N,F,A,M,G>();
+
+        m_data = inline_data();
+        m_size = 0;
+        m_capacity = N;
+
+        steal(other);
+    }
+
+    return *this;
+}
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+fast_small_vector<T,N,F,A,M,G>::~fast_small_vector()
+{
+    if (!std::is_trivial_v<T>)
+    {
+        destruct_range(begin(), end());
+    }
+
+    if (!is_inline())
+    {
+        M::deallocate(m_data, sizeof(T) * m_capacity, alignment);
+    }
+}
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+void fast_small_vector<T,N,F,A,M,G>::swap(fast_small_vector& a, fast_small_vector& b)
+{
+    if (!a.is_inline() && !b.is_inline())
+    {
+        std::swap(a.m_data, b.m_data);
+        std::swap(a.m_size, b.m_size);
+        std::swap(a.m_capacity, b.m_capacity);
+    }
+    else
+    {
+        fast_small_vector tmp(std::move(a));
+        a = std::move(b);
+        b = std::move(tmp);
+    }
+}
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+T* fast_small_vector<T,N,F,A,M,G>::inline_data() noexcept
+{
+    return reinterpret_cast<T*>(m_buffer);
+}
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+const T* fast_small_vector<T,N,F,A,M,G>::inline_data() const noexcept
+{
+    return reinterpret_cast<const T*>(m_buffer);
+}
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+void fast_small_vector<T,N,F,A,M,G>::steal(fast_small_vector& other) noexcept
+{
+    if (other.is_inline())
+    {
+        // Only N elements at most, the copy is cheap
+        if constexpr (relocatable)
+        {
+            relocate_range(other.begin(), other.end(), m_data);
+        }
+        else
+        {
+            for (size_type i = 0; i < other.m_size; i++)
+            {
+                new (m_data + i) T(std::move(other.m_data[i]));
+            }
+            destruct_range(other.begin(), other.end());
+        }
+        m_size = other.m_size;
+    }
+    else
+    {
+        m_data = other.m_data;
+        m_size = other.m_size;
+        m_capacity = other.m_capacity;
+
+        other.m_data = other.inline_data();
+        other.m_capacity = N;
+    }
+
+    other.m_size = 0;
+}
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+void fast_small_vector<T,N,F,A,M,G>::relocate(T* new_data)
+{
+    if constexpr (relocatable)
+    {
+        relocate_range(begin(), end(), new_data);
+    }
+    else
+    {
+        uninitialized_move_range(begin(), end(), new_data);
+        destruct_range(begin(), end());
+    }
+
+    if (!is_inline())
+    {
+        M::deallocate(m_data, sizeof(T) * m_capacity, alignment);
+    }
+
+    m_data = new_data;
+}
+
+// Element access
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+T& fast_small_vector<T,N,F,A,M,G>::operator[](size_type pos)
+{
+    assert(pos < m_size && "Position is out of range");
+    return m_data[pos];
+}
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+const T& fast_small_vector<T,N,F,A,M,G>::operator[](size_type pos) const
+{
+    assert(pos < m_size && "Position is out of range");
+    return m_data[pos];
+}
+
+#if !defined(FAST_VECTOR_NO_EXCEPTIONS)
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+T& fast_small_vector<T,N,F,A,M,G>::at(size_type pos)
+{
+    if (pos >= m_size)
+        throw std::range_error{"Position is out of range"};
+
+    return operator [](pos);
+}
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+const T& fast_small_vector<T,N,F,A,M,G>::at(size_type pos) const
+{
+    if (pos >= m_size)
+        throw std::range_error{"Position is out of range"};
+
+    return operator [](pos);
+}
+
+#endif // FAST_VECTOR_NO_EXCEPTIONS
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+T& fast_small_vector<T,N,F,A,M,G>::front()
+{
+    assert(m_size > 0 && "Container is empty");
+    return m_data[0];
+}
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+const T& fast_small_vector<T,N,F,A,M,G>::front() const
+{
+    assert(m_size > 0 && "Container is empty");
+    return m_data[0];
+}
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+T& fast_small_vector<T,N,F,A,M,G>::back()
+{
+    assert(m_size > 0 && "Container is empty");
+    return m_data[m_size - 1];
+}
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+const T& fast_small_vector<T,N,F,A,M,G>::back() const
+{
+    assert(m_size > 0 && "Container is empty");
+    return m_data[m_size - 1];
+}
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+T* fast_small_vector<T,N,F,A,M,G>::data() noexcept
+{
+    return m_data;
+}
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+const T* fast_small_vector<T,N,F,A,M,G>::data() const noexcept
+{
+    return m_data;
+}
+
+// Iterators
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+T* fast_small_vector<T,N,F,A,M,G>::begin() noexcept
+{
+    return m_data;
+}
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+const T* fast_small_vector<T,N,F,A,M,G>::begin() const noexcept
+{
+    return m_data;
+}
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+T* fast_small_vector<T,N,F,A,M,G>::end() noexcept
+{
+    return m_data + m_size;
+}
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+const T* fast_small_vector<T,N,F,A,M,G>::end() const noexcept
+{
+    return m_data + m_size;
+}
+
+// Capacity
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+bool fast_small_vector<T,N,F,A,M,G>::empty() const noexcept
+{
+    return m_size == 0;
+}
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+typename fast_small_vector<T,N,F,A,M,G>::size_type fast_small_vector<T,N,F,A,M,G>::size() const noexcept
+{
+    return m_size;
+}
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+bool fast_small_vector<T,N,F,A,M,G>::is_inline() const noexcept
+{
+    return m_data == inline_data();
+}
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+void fast_small_vector<T,N,F,A,M,G>::reserve(size_type new_cap)
+{
+    if (new_cap <= m_capacity)
+        return;
+
+    if (is_inline())
+    {
+        // Spill to the heap
+        T* new_data_location = reinterpret_cast<T*>(M::allocate(sizeof(T) * new_cap, alignment));
+        if (!new_data_location)
+            fast_vector_out_of_memory();
+
+        relocate(new_data_location);
+    }
+    else if (M::try_expand(m_data, sizeof(T) * m_capacity, sizeof(T) * new_cap, alignment))
+    {
+        // Grown in place, nothing to move
+    }
+    else if constexpr (relocatable)
+    {
+        T* new_data_location = reinterpret_cast<T*>(M::reallocate(m_data, sizeof(T) * m_capacity, sizeof(T) * new_cap, alignment));
+        if (!new_data_location)
+            fast_vector_out_of_memory();
+
+        m_data = new_data_location;
+    }
+    else
+    {
+        T* new_data_location = reinterpret_cast<T*>(M::allocate(sizeof(T) * new_cap, alignment));
+        if (!new_data_location)
+            fast_vector_out_of_memory();
+
+        relocate(new_data_location);
+    }
+
+    m_capacity = new_cap;
+}
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+typename fast_small_vector<T,N,F,A,M,G>::size_type fast_small_vector<T,N,F,A,M,G>::capacity() const noexcept
+{
+    return m_capacity;
+}
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+void fast_small_vector<T,N,F,A,M,G>::shrink_to_fit()
+{
+    if (is_inline() || m_size == m_capacity)
+        return;
+
+    if (m_size <= N)
+    {
+        // Back to the inline buffer
+        relocate(inline_data());
+        m_capacity = N;
+    }
+    else if constexpr (relocatable)
+    {
+        // Shrinking is only a request, the vector keeps its block when no new one is available
+        T* new_data_location = reinterpret_cast<T*>(M::reallocate(m_data, sizeof(T) * m_capacity, sizeof(T) * m_size, alignment));
+        if (!new_data_location)
+            return;
+
+        m_data = new_data_location;
+        m_capacity = m_size;
+    }
+    else
+    {
+        T* new_data_location = reinterpret_cast<T*>(M::allocate(sizeof(T) * m_size, alignment));
+        if (!new_data_location)
+            return;
+
+        relocate(new_data_location);
+        m_capacity = m_size;
+    }
+}
+
+// Modifiers
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+void fast_small_vector<T,N,F,A,M,G>::clear() noexcept
+{
+    if constexpr (!(std::is_trivial_v<T> | F))
+    {
+        destruct_range(begin(), end());
+    }
+
+    m_size = 0;
+}
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+void fast_small_vector<T,N,F,A,M,G>::append(const T values[], size_t count)
+{
+    if (m_size + count > m_capacity)
+    {
+        // A source inside the vector moves with it
+        bool inside = values >= begin() && values < end();
+        size_type offset = inside ? size_type(values - m_data) : 0;
+
+        reserve(G::next_capacity(m_capacity, m_size + count, sizeof(T)));
+
+        if (inside)
+            values = m_data + offset;
+    }
+
+    if constexpr (std::is_trivial_v<T>)
+    {
+        std::memcpy(m_data + m_size, values, count * sizeof(T));
+    }
+    else
+    {
+        copy_range(values, values + count, m_data + m_size);
+    }
+
+    m_size += count;
+}
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+bool fast_small_vector<T,N,F,A,M,G>::erase(const T value)
+{
+    T* position = find_item(begin(), end(), value);
+    if (position < end())
+    {
+        size_t count = end() - position - 1;
+
+        if constexpr (relocatable)
+        {
+            position->~T();
+            if (count > 0)
+            {
+                relocate_range(position + 1, end(), position);
+            }
+        }
+        else
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                *position = std::move(*(position + 1));
+                ++position;
+            }
+            position->~T();
+        }
+        --m_size;
+        return true;
+    }
+    return false;
+}
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+void fast_small_vector<T,N,F,A,M,G>::push_back(const T& value)
+{
+    if (m_size == m_capacity)
+    {
+        // The value may live inside and be freed by the growth, copy it first
+        T copy(value);
+        push_back(std::move(copy));
+        return;
+    }
+
+    if constexpr (std::is_trivial_v<T>)
+    {
+        m_data[m_size] = value;
+    }
+    else
+    {
+        new (m_data + m_size) T(value);
+    }
+
+    m_size++;
+}
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+void fast_small_vector<T,N,F,A,M,G>::push_back(T&& value)
+{
+    if (m_size == m_capacity)
+    {
+        if (&value >= begin() && &value < end())
+        {
+            // The value lives inside and would be freed by the growth
+            T moved(std::move(value));
+            reserve(G::next_capacity(m_capacity, m_size + 1, sizeof(T)));
+            new (m_data + m_size) T(std::move(moved));
+            m_size++;
+            return;
+        }
+
+        reserve(G::next_capacity(m_capacity, m_size + 1, sizeof(T)));
+    }
+
+    if constexpr (std::is_trivial_v<T>)
+    {
+        m_data[m_size] = value;
+    }
+    else
+    {
+        new (m_data + m_size) T(std::move(value));
+    }
+
+    m_size++;
+}
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+template< class... Args >
+void fast_small_vector<T,N,F,A,M,G>::emplace_back(Args&&... args)
+{
+    static_assert(!std::is_trivial_v<T>, "Use push_back() instead of emplace_back() with trivial types");
+
+    if (m_size == m_capacity)
+    {
+        // The arguments may refer into the storage the growth frees, build the element first
+        T value(std::forward<Args>(args)...);
+        reserve(G::next_capacity(m_capacity, m_size + 1, sizeof(T)));
+        new (m_data + m_size) T(std::move(value));
+        m_size++;
+        return;
+    }
+
+    new (m_data + m_size) T(std::forward<Args>(args)...);
+
+    m_size++;
+}
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+void fast_small_vector<T,N,F,A,M,G>::pop_back()
+{
+    assert(m_size > 0 && "Container is empty");
+
+    if constexpr (!std::is_trivial_v<T>)
+    {
+        m_data[m_size - 1].~T();
+    }
+
+    m_size--;
+}
+
+template <typename T, std::size_t N, bool F, int A, typename M, typename G>
+void fast_small_vector<T,N,F,A,M,G>::resize(size_type count)
+{
+    if (count == m_size)
+        return;
+
+    if (count > m_capacity)
+    {
+        reserve(count);
+    }
+
+    if constexpr (!std::is_trivial_v<T>)
+    {
+        if (count > m_size)
+        {
+            construct_range(m_data + m_size, m_data + count);
+        }
+        else if (count < m_size)
+        {
+            destruct_range(m_data + count, m_data + m_size);
+        }
+    }
+
+    m_size = count;
+}
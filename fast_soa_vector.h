@@ -0,0 +1,500 @@
+//
+// Struct of arrays sibling of the fast_vector, every field in its own column
+//
+// Advanced & fixed version by Marian Krivos
+//
+
+#pragma once
+
+#include <tuple>
+#include <utility>
+
+#include "fast_vector.h"
+
+/**
+ * Vector of the Ts... records stored field by field: each field has its own aligned column,
+ * so a loop over one or two fields reads only those. All the columns share one size and
+ * capacity and grow together with the M allocation and G growth policies, the trivially
+ * relocatable columns by realloc like the fast_vector. Elements are accessed through
+ * a tuple of references, value_type is the std::tuple<Ts...> record.
+ */
+template <int A, typename M, typename G, typename... Ts>
+class basic_soa_vector
+{
+public:
+    using size_type = std::size_t;
+    using value_type = std::tuple<Ts...>;
+    using reference = std::tuple<Ts&...>;
+    using const_reference = std::tuple<const Ts&...>;
+
+    template <std::size_t I>
+    using column_type = std::tuple_element_t<I, value_type>;
+
+    basic_soa_vector() noexcept = default;
+    basic_soa_vector(const basic_soa_vector& other);
+    basic_soa_vector(basic_soa_vector&& other) noexcept;
+    basic_soa_vector& operator=(const basic_soa_vector& other);
+    basic_soa_vector& operator=(basic_soa_vector&& other) noexcept;
+
+    ~basic_soa_vector();
+
+    // Element access
+
+    reference operator[](size_type pos);
+    const_reference operator[](size_type pos) const;
+
+    reference front();
+    const_reference front() const;
+
+    reference back();
+    const_reference back() const;
+
+    // Columns, aligned to at least A bytes
+
+    template <std::size_t I>
+    column_type<I>* data() noexcept;
+    template <std::size_t I>
+    const column_type<I>* data() const noexcept;
+
+    template <std::size_t I>
+    fast_span<column_type<I>> column() noexcept;
+    template <std::size_t I>
+    fast_span<const column_type<I>> column() const noexcept;
+
+    // Capacity
+
+    bool empty() const noexcept;
+    size_type size() const noexcept;
+    void reserve(size_type new_cap);
+    fast_vector_status try_reserve(size_type new_cap);
+    size_type capacity() const noexcept;
+
+    // Modifiers
+
+    void clear() noexcept;
+
+    void push_back(const value_type& value);
+    void push_back(value_type&& value);
+
+    // One argument per column
+    template< class... Args >
+    reference emplace_back(Args&&... args);
+
+    void pop_back();
+    void resize(size_type count);
+
+    static void swap(basic_soa_vector& a, basic_soa_vector& b) noexcept;
+
+    static constexpr size_type column_count = sizeof...(Ts);
+    // Bytes of one record over all the columns, what the growth policy sees as the element size
+    static constexpr size_type record_size = (sizeof(Ts) + ...);
+
+    static_assert(sizeof...(Ts) > 0, "At least one column is required");
+    static_assert(A > 0 && (A & (A - 1)) == 0, "Alignment must be a power of two");
+
+    using allocator_type = M;
+    using growth_policy = G;
+
+private:
+    template <std::size_t I>
+    static constexpr size_type column_alignment = A > int(alignof(column_type<I>)) ? size_type(A) : alignof(column_type<I>);
+
+    template <typename Fn, std::size_t... Is>
+    static void for_each_column(Fn& fn, std::index_sequence<Is...>);
+    // Calls fn(std::integral_constant<std::size_t, I>) for every column I
+    template <typename Fn>
+    static void for_each_column(Fn&& fn);
+
+    template <std::size_t I>
+    bool grow_column(size_type new_cap);
+    template <typename Tuple>
+    void construct_back(Tuple&& values);
+
+    std::tuple<Ts*...> m_columns{};
+    // Allocated elements per column, above m_capacity when a lockstep growth failed halfway
+    size_type m_column_capacity[sizeof...(Ts)] = {};
+    size_type m_size = 0;
+    size_type m_capacity = 0;
+};
+
+/**
+ * The basic_soa_vector with the fast_vector default policies.
+ */
+template <typename... Ts>
+using soa_vector = basic_soa_vector<16, malloc_allocator, factor_growth<>, Ts...>;
+
+template <int A, typename M, typename G, typename... Ts>
+template <typename Fn, std::size_t... Is>
+void basic_soa_vector<A,M,G,Ts...>::for_each_column(Fn& fn, std::index_sequence<Is...>)
+{
+    (fn(std::integral_constant<std::size_t, Is>{}), ...);
+}
+
+template <int A, typename M, typename G, typename... Ts>
+template <typename Fn>
+void basic_soa_vector<A,M,G,Ts...>::for_each_column(Fn&& fn)
+{
+    for_each_column(fn, std::index_sequence_for<Ts...>{});
+}
+
+template <int A, typename M, typename G, typename... Ts>
+basic_soa_vector<A,M,G,Ts...>::basic_soa_vector(const basic_soa_vector& other)
+{
+    reserve(other.m_size);
+
+    for_each_column([this, &other](auto index)
+    {
+        using T = column_type<index.value>;
+        const T* source = std::get<index.value>(other.m_columns);
+
+        if constexpr (std::is_trivial_v<T>)
+        {
+            if (other.m_size)
+                std::memcpy(static_cast<void*>(std::get<index.value>(m_columns)), source, sizeof(T) * other.m_size);
+        }
+        else
+        {
+            copy_range(source, source + other.m_size, std::get<index.value>(m_columns));
+        }
+    });
+
+    m_size = other.m_size;
+}
+
+template <int A, typename M, typename G, typename... Ts>
+basic_soa_vector<A,M,G,Ts...>::basic_soa_vector(basic_soa_vector&& other) noexcept
+{
+    swap(*this, other);
+}
+
+template <int A, typename M, typename G, typename... Ts>
+basic_soa_vector<A,M,G,Ts...>& basic_soa_vector<A,M,G,Ts...>::operator=(const basic_soa_vector& other)
+{
+    if (this != &other)
+    {
+        basic_soa_vector copy(other);
+        swap(*this, copy);
+    }
+    return *this;
+}
+
+template <int A, typename M, typename G, typename... Ts>
+basic_soa_vector<A,M,G,Ts...>& basic_soa_vector<A,M,G,Ts...>::operator=(basic_soa_vector&& other) noexcept
+{
+    if (this != &other)
+    {
+        basic_soa_vector released(std::move(other));
+        swap(*this, released);
+    }
+    return *this;
+}
+
+template <int A, typename M, typename G, typename... Ts>
+basic_soa_vector<A,M,G,Ts...>::~basic_soa_vector()
+{
+    clear();
+
+    for_each_column([this](auto index)
+    {
+        using T = column_type<index.value>;
+        M::deallocate(std::get<index.value>(m_columns), sizeof(T) * m_column_capacity[index.value], column_alignment<index.value>);
+    });
+}
+
+template <int A, typename M, typename G, typename... Ts>
+void basic_soa_vector<A,M,G,Ts...>::swap(basic_soa_vector& a, basic_soa_vector& b) noexcept
+{
+    std::swap(a.m_columns, b.m_columns);
+    std::swap(a.m_column_capacity, b.m_column_capacity);
+    std::swap(a.m_size, b.m_size);
+    std::swap(a.m_capacity, b.m_capacity);
+}
+
+// Element access
+
+template <int A, typename M, typename G, typename... Ts>
+typename basic_soa_vector<A,M,G,Ts...>::reference basic_soa_vector<A,M,G,Ts...>::operator[](size_type pos)
+{
+    assert(pos < m_size && "Position is out of range");
+    return std::apply([pos](Ts*... columns) { return reference(columns[pos]...); }, m_columns);
+}
+
+template <int A, typename M, typename G, typename... Ts>
+typename basic_soa_vector<A,M,G,Ts...>::const_reference basic_soa_vector<A,M,G,Ts...>::operator[](size_type pos) const
+{
+    assert(pos < m_size && "Position is out of range");
+    return std::apply([pos](Ts*... columns) { return const_reference(columns[pos]...); }, m_columns);
+}
+
+template <int A, typename M, typename G, typename... Ts>
+typename basic_soa_vector<A,M,G,Ts...>::reference basic_soa_vector<A,M,G,Ts...>::front()
+{
+    assert(m_size > 0 && "Container is empty");
+    return operator [](0);
+}
+
+template <int A, typename M, typename G, typename... Ts>
+typename basic_soa_vector<A,M,G,Ts...>::const_reference basic_soa_vector<A,M,G,Ts...>::front() const
+{
+    assert(m_size > 0 && "Container is empty");
+    return operator [](0);
+}
+
+template <int A, typename M, typename G, typename... Ts>
+typename basic_soa_vector<A,M,G,Ts...>::reference basic_soa_vector<A,M,G,Ts...>::back()
+{
+    assert(m_size > 0 && "Container is empty");
+    return operator [](m_size - 1);
+}
+
+template <int A, typename M, typename G, typename... Ts>
+typename basic_soa_vector<A,M,G,Ts...>::const_reference basic_soa_vector<A,M,G,Ts...>::back() const
+{
+    assert(m_size > 0 && "Container is empty");
+    return operator [](m_size - 1);
+}
+
+// Columns
+
+template <int A, typename M, typename G, typename... Ts>
+template <std::size_t I>
+typename basic_soa_vector<A,M,G,Ts...>::template column_type<I>* basic_soa_vector<A,M,G,Ts...>::data() noexcept
+{
+    return assume_aligned<column_alignment<I>>(std::get<I>(m_columns));
+}
+
+template <int A, typename M, typename G, typename... Ts>
+template <std::size_t I>
+const typename basic_soa_vector<A,M,G,Ts...>::template column_type<I>* basic_soa_vector<A,M,G,Ts...>::data() const noexcept
+{
+    return assume_aligned<column_alignment<I>>(static_cast<const column_type<I>*>(std::get<I>(m_columns)));
+}
+
+template <int A, typename M, typename G, typename... Ts>
+template <std::size_t I>
+fast_span<typename basic_soa_vector<A,M,G,Ts...>::template column_type<I>> basic_soa_vector<A,M,G,Ts...>::column() noexcept
+{
+    return {data<I>(), m_size};
+}
+
+template <int A, typename M, typename G, typename... Ts>
+template <std::size_t I>
+fast_span<const typename basic_soa_vector<A,M,G,Ts...>::template column_type<I>> basic_soa_vector<A,M,G,Ts...>::column() const noexcept
+{
+    return {data<I>(), m_size};
+}
+
+// Capacity
+
+template <int A, typename M, typename G, typename... Ts>
+bool basic_soa_vector<A,M,G,Ts...>::empty() const noexcept
+{
+    return m_size == 0;
+}
+
+template <int A, typename M, typename G, typename... Ts>
+typename basic_soa_vector<A,M,G,Ts...>::size_type basic_soa_vector<A,M,G,Ts...>::size() const noexcept
+{
+    return m_size;
+}
+
+template <int A, typename M, typename G, typename... Ts>
+typename basic_soa_vector<A,M,G,Ts...>::size_type basic_soa_vector<A,M,G,Ts...>::capacity() const noexcept
+{
+    return m_capacity;
+}
+
+template <int A, typename M, typename G, typename... Ts>
+void basic_soa_vector<A,M,G,Ts...>::reserve(size_type new_cap)
+{
+    if (try_reserve(new_cap) != fast_vector_status::ok)
+        fast_vector_out_of_memory();
+}
+
+template <int A, typename M, typename G, typename... Ts>
+template <std::size_t I>
+bool basic_soa_vector<A,M,G,Ts...>::grow_column(size_type new_cap)
+{
+    using T = column_type<I>;
+
+    size_type old_cap = m_column_capacity[I];
+    if (new_cap <= old_cap)
+        return true;
+
+    T*& column = std::get<I>(m_columns);
+
+    if (column && M::try_expand(column, sizeof(T) * old_cap, sizeof(T) * new_cap, column_alignment<I>))
+    {
+        // Grown in place, nothing to move
+    }
+    else if constexpr (is_trivially_relocatable_v<T>)
+    {
+        T* new_column = reinterpret_cast<T*>(M::reallocate(column, sizeof(T) * old_cap, sizeof(T) * new_cap, column_alignment<I>));
+        if (!new_column)
+            return false;
+
+        column = new_column;
+    }
+    else
+    {
+        T* new_column = reinterpret_cast<T*>(M::allocate(sizeof(T) * new_cap, column_alignment<I>));
+        if (!new_column)
+            return false;
+
+        uninitialized_move_range(column, column + m_size, new_column);
+        destruct_range(column, column + m_size);
+
+        M::deallocate(column, sizeof(T) * old_cap, column_alignment<I>);
+
+        column = new_column;
+    }
+
+    m_column_capacity[I] = new_cap;
+    return true;
+}
+
+template <int A, typename M, typename G, typename... Ts>
+fast_vector_status basic_soa_vector<A,M,G,Ts...>::try_reserve(size_type new_cap)
+{
+    if (new_cap <= m_capacity)
+        return fast_vector_status::ok;
+
+    if (new_cap > size_type(-1) / record_size)
+        return fast_vector_status::length_error;
+
+    // The columns grown before a failure keep their larger blocks, the next attempt skips them
+    bool grown = true;
+
+    for_each_column([this, new_cap, &grown](auto index)
+    {
+        if (grown)
+            grown = grow_column<index.value>(new_cap);
+    });
+
+    if (!grown)
+        return fast_vector_status::out_of_memory;
+
+    m_capacity = new_cap;
+    return fast_vector_status::ok;
+}
+
+// Modifiers
+
+template <int A, typename M, typename G, typename... Ts>
+void basic_soa_vector<A,M,G,Ts...>::clear() noexcept
+{
+    for_each_column([this](auto index)
+    {
+        using T = column_type<index.value>;
+
+        if constexpr (!std::is_trivial_v<T>)
+        {
+            T* column = std::get<index.value>(m_columns);
+            destruct_range(column, column + m_size);
+        }
+    });
+
+    m_size = 0;
+}
+
+template <int A, typename M, typename G, typename... Ts>
+template <typename Tuple>
+void basic_soa_vector<A,M,G,Ts...>::construct_back(Tuple&& values)
+{
+    for_each_column([this, &values](auto index)
+    {
+        using T = column_type<index.value>;
+        new (std::get<index.value>(m_columns) + m_size) T(std::get<index.value>(std::forward<Tuple>(values)));
+    });
+
+    m_size++;
+}
+
+template <int A, typename M, typename G, typename... Ts>
+void basic_soa_vector<A,M,G,Ts...>::push_back(const value_type& value)
+{
+    // A record is never stored as a whole, value cannot live inside
+    if (m_size == m_capacity)
+    {
+        reserve(G::next_capacity(m_capacity, m_size + 1, record_size));
+    }
+
+    construct_back(value);
+}
+
+template <int A, typename M, typename G, typename... Ts>
+void basic_soa_vector<A,M,G,Ts...>::push_back(value_type&& value)
+{
+    if (m_size == m_capacity)
+    {
+        reserve(G::next_capacity(m_capacity, m_size + 1, record_size));
+    }
+
+    construct_back(std::move(value));
+}
+
+template <int A, typename M, typename G, typename... Ts>
+template< class... Args >
+typename basic_soa_vector<A,M,G,Ts...>::reference basic_soa_vector<A,M,G,Ts...>::emplace_back(Args&&... args)
+{
+    static_assert(sizeof...(Args) == sizeof...(Ts), "One argument per column is required");
+
+    if (m_size == m_capacity)
+    {
+        // The arguments may refer to the elements, which move with the columns
+        value_type copy(std::forward<Args>(args)...);
+        reserve(G::next_capacity(m_capacity, m_size + 1, record_size));
+        construct_back(std::move(copy));
+    }
+    else
+    {
+        construct_back(std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
+    return back();
+}
+
+template <int A, typename M, typename G, typename... Ts>
+void basic_soa_vector<A,M,G,Ts...>::pop_back()
+{
+    assert(m_size > 0 && "Container is empty");
+
+    m_size--;
+
+    for_each_column([this](auto index)
+    {
+        using T = column_type<index.value>;
+
+        if constexpr (!std::is_trivial_v<T>)
+        {
+            std::get<index.value>(m_columns)[m_size].~T();
+        }
+    });
+}
+
+template <int A, typename M, typename G, typename... Ts>
+void basic_soa_vector<A,M,G,Ts...>::resize(size_type count)
+{
+    if (count > m_capacity)
+    {
+        reserve(count);
+    }
+
+    // Like the fast_vector, the trivial columns stay uninitialized
+    for_each_column([this, count](auto index)
+    {
+        using T = column_type<index.value>;
+
+        if constexpr (!std::is_trivial_v<T>)
+        {
+            T* column = std::get<index.value>(m_columns);
+
+            if (count > m_size)
+                construct_range(column + m_size, column + count);
+            else
+                destruct_range(column + count, column + m_size);
+        }
+    });
+
+    m_size = count;
+}
@@ -8,11 +8,59 @@
 #pragma once
 
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <cstdlib>
 #include <cstring> // std::memcpy()
+#include <iterator>
+#include <memory>
 #include <new>
 #include <stdexcept>
+#include <string>
+#include <tuple>
 #include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "fast_vector_simd.h"
+#include "fast_vector_sort.h"
+
+// Exceptions are used only when the compiler has them enabled. Define FAST_VECTOR_NO_EXCEPTIONS
+// to leave them out anyway: at() goes away and a failed allocation aborts.
+#if !defined(FAST_VECTOR_NO_EXCEPTIONS) && !defined(__cpp_exceptions) && !defined(_CPPUNWIND)
+#define FAST_VECTOR_NO_EXCEPTIONS
+#endif
+
+#if defined(_MSC_VER)
+#include <malloc.h> // _aligned_malloc()
+#elif defined(__GLIBC__)
+#include <malloc.h> // malloc_usable_size()
+#endif
+
+// Error reporting
+
+/**
+ * Result of the non-throwing try_* members. On failure the vector is left unchanged.
+ */
+enum class [[nodiscard]] fast_vector_status
+{
+    ok,
+    out_of_memory,
+    length_error // the size in bytes does not fit into size_t
+};
+
+/**
+ * Reports a failed allocation of the members without a status result: throws std::bad_alloc,
+ * aborts under FAST_VECTOR_NO_EXCEPTIONS. The try_* members return the failure instead.
+ */
+[[noreturn]] inline void fast_vector_out_of_memory()
+{
+#if defined(FAST_VECTOR_NO_EXCEPTIONS)
+    std::abort();
+#else
+    throw std::bad_alloc{};
+#endif
+}
 
 // Helper functions
 
@@ -26,6 +74,16 @@ inline void construct_range(T* begin, T* end)
     }
 }
 
+template <typename T>
+inline void fill_range(T* begin, T* end, const T& value)
+{
+    while (begin != end)
+    {
+        new (begin) T(value);
+        begin++;
+    }
+}
+
 template <typename T>
 inline void copy_range(const T* begin, const T* end, T* dest)
 {
@@ -37,27 +95,53 @@ inline void copy_range(const T* begin, const T* end, T* dest)
     }
 }
 
+// Move-constructs into raw memory, copies instead when T's move constructor may throw
 template <typename T>
-inline void move_range(const T* begin, const T* end, T* dest)
+inline void uninitialized_move_range(T* begin, T* end, T* dest)
 {
     while (begin != end)
     {
-        *dest = std::move(*begin);
+        new (dest) T(std::move_if_noexcept(*begin));
         begin++;
         dest++;
     }
 }
 
 template <typename T>
-inline T* find_item(T* begin, T* end, const T& value)
+inline void move_range(T* begin, T* end, T* dest)
 {
     while (begin != end)
     {
-        if (*begin == value)
-            return begin;
+        *dest = std::move(*begin);
         begin++;
+        dest++;
+    }
+}
+
+// Moves the elements as raw bytes (ranges may overlap), valid for trivially relocatable types only
+template <typename T>
+inline void relocate_range(T* begin, T* end, T* dest)
+{
+    std::memmove(static_cast<void*>(dest), static_cast<const void*>(begin), sizeof(T) * (end - begin));
+}
+
+template <typename T>
+inline T* find_item(T* begin, T* end, const std::remove_const_t<T>& value)
+{
+    if constexpr (is_simd_element_v<std::remove_const_t<T>>)
+    {
+        return begin + (find_equal<std::remove_const_t<T>>(begin, end, value) - begin);
+    }
+    else
+    {
+        while (begin != end)
+        {
+            if (*begin == value)
+                return begin;
+            begin++;
+        }
+        return end;
     }
-    return end;
 }
 
 template <typename T>
@@ -70,10 +154,327 @@ inline void destruct_range(T* begin, T* end)
     }
 }
 
+// Initialization tags of the sized constructors and resize()
+
+/**
+ * Default-initialized elements: trivial types stay uninitialized. The default behaviour.
+ */
+struct no_init_t
+{
+    explicit no_init_t() = default;
+};
+
+inline constexpr no_init_t no_init{};
+
+/**
+ * Zero filled trivial elements. Fresh blocks come from calloc or fresh pages, so the zeros
+ * are free whenever the allocator or the kernel supplies them.
+ */
+struct zero_init_t
+{
+    explicit zero_init_t() = default;
+};
+
+inline constexpr zero_init_t zero_init{};
+
+/**
+ * Customization point telling that a T may be moved around with memcpy/realloc, the moved-from
+ * bytes being simply forgotten. True for trivially copyable types, specialize it for your own
+ * handle-like classes which keep no pointers into themselves.
+ */
+template <typename T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+template <typename T>
+inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+template <typename T, typename D>
+struct is_trivially_relocatable<std::unique_ptr<T, D>> : is_trivially_relocatable<D> {};
+
+template <typename T>
+struct is_trivially_relocatable<std::shared_ptr<T>> : std::true_type {};
+
+template <typename T>
+struct is_trivially_relocatable<std::weak_ptr<T>> : std::true_type {};
+
+template <typename T>
+struct is_trivially_relocatable<std::vector<T>> : std::true_type {};
+
+template <typename T1, typename T2>
+struct is_trivially_relocatable<std::pair<T1, T2>> :
+    std::bool_constant<is_trivially_relocatable_v<T1> && is_trivially_relocatable_v<T2>> {};
+
+template <typename... Ts>
+struct is_trivially_relocatable<std::tuple<Ts...>> :
+    std::bool_constant<(is_trivially_relocatable_v<Ts> && ...)> {};
+
+#if defined(_LIBCPP_VERSION)
+// libstdc++ strings point into their own SSO buffer, libc++ ones do not
+template <>
+struct is_trivially_relocatable<std::string> : std::true_type {};
+#endif
+
+template <std::size_t N, typename T>
+inline T* assume_aligned(T* ptr) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<T*>(__builtin_assume_aligned(ptr, N));
+#else
+    return ptr;
+#endif
+}
+
+// Aligned memory helpers
+//
+// Alignments up to alignof(std::max_align_t) are served by plain malloc/realloc,
+// so the default configuration keeps the realloc fast path untouched.
+
+inline bool is_aligned(const void* ptr, std::size_t alignment) noexcept
+{
+    return (reinterpret_cast<std::uintptr_t>(ptr) & (alignment - 1)) == 0;
+}
+
+inline void* aligned_allocate(std::size_t bytes, std::size_t alignment)
+{
+    if (alignment <= alignof(std::max_align_t))
+        return std::malloc(bytes);
+#if defined(_MSC_VER)
+    return _aligned_malloc(bytes, alignment);
+#else
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, alignment, bytes) != 0)
+        return nullptr;
+    return ptr;
+#endif
+}
+
+/**
+ * Resizes a block obtained from aligned_allocate(). On failure nullptr is returned
+ * and the original block is left untouched, just like std::realloc().
+ */
+inline void* aligned_reallocate(void* ptr, std::size_t old_bytes, std::size_t new_bytes, std::size_t alignment)
+{
+    if (alignment <= alignof(std::max_align_t))
+        return std::realloc(ptr, new_bytes);
+#if defined(_MSC_VER)
+    (void)old_bytes;
+    return _aligned_realloc(ptr, new_bytes, alignment);
+#else
+    if (!ptr)
+        return aligned_allocate(new_bytes, alignment);
+#if defined(__GLIBC__)
+    // The chunk may already be large enough, no need to move anything
+    if (new_bytes >= old_bytes && malloc_usable_size(ptr) >= new_bytes)
+        return ptr;
+#endif
+    // std::realloc() keeps only the fundamental alignment, so the block is moved by hand
+    void* moved = aligned_allocate(new_bytes, alignment);
+    if (!moved)
+        return nullptr;
+    std::memcpy(moved, ptr, old_bytes < new_bytes ? old_bytes : new_bytes);
+    std::free(ptr);
+    return moved;
+#endif
+}
+
+// Zero filled aligned_allocate(), calloc skips the clearing of memory fresh from the system
+inline void* aligned_allocate_zeroed(std::size_t bytes, std::size_t alignment)
+{
+    if (alignment <= alignof(std::max_align_t))
+        return std::calloc(bytes, 1);
+
+    void* ptr = aligned_allocate(bytes, alignment);
+    if (ptr)
+        std::memset(ptr, 0, bytes);
+    return ptr;
+}
+
+inline void aligned_deallocate(void* ptr, std::size_t alignment) noexcept
+{
+#if defined(_MSC_VER)
+    if (alignment > alignof(std::max_align_t))
+    {
+        _aligned_free(ptr);
+        return;
+    }
+#else
+    (void)alignment;
+#endif
+    std::free(ptr);
+}
+
+// Allocation policies
+//
+// A policy is a stateless type with the following static interface:
+//
+//   void* allocate(std::size_t bytes, std::size_t alignment);
+//   void* allocate_zeroed(std::size_t bytes, std::size_t alignment);
+//   bool  try_expand(void* ptr, std::size_t old_bytes, std::size_t new_bytes, std::size_t alignment) noexcept;
+//   void* reallocate(void* ptr, std::size_t old_bytes, std::size_t new_bytes, std::size_t alignment);
+//   void  deallocate(void* ptr, std::size_t bytes, std::size_t alignment) noexcept;
+//
+// reallocate() follows the std::realloc() contract: on failure nullptr is returned and
+// the original block stays valid. deallocate() must accept nullptr.
+// See fast_allocators.h for the arena and pool policies.
+
+/**
+ * The default policy, plain malloc/realloc/free (aligned when asked to).
+ */
+struct malloc_allocator
+{
+    static void* allocate(std::size_t bytes, std::size_t alignment)
+    {
+        return aligned_allocate(bytes, alignment);
+    }
+
+    static void* allocate_zeroed(std::size_t bytes, std::size_t alignment)
+    {
+        return aligned_allocate_zeroed(bytes, alignment);
+    }
+
+    static bool try_expand(void* ptr, std::size_t old_bytes, std::size_t new_bytes, std::size_t alignment) noexcept
+    {
+#if defined(__GLIBC__)
+        (void)alignment;
+        return ptr && new_bytes >= old_bytes && malloc_usable_size(ptr) >= new_bytes;
+#else
+        (void)ptr; (void)old_bytes; (void)new_bytes; (void)alignment;
+        return false;
+#endif
+    }
+
+    static void* reallocate(void* ptr, std::size_t old_bytes, std::size_t new_bytes, std::size_t alignment)
+    {
+        return aligned_reallocate(ptr, old_bytes, new_bytes, alignment);
+    }
+
+    static void deallocate(void* ptr, std::size_t bytes, std::size_t alignment) noexcept
+    {
+        (void)bytes;
+        aligned_deallocate(ptr, alignment);
+    }
+};
+
+// Growth policies
+//
+// A policy is a stateless type returning the capacity to grow to once the vector is full:
+//
+//   std::size_t next_capacity(std::size_t capacity, std::size_t required, std::size_t element_size) noexcept;
+//
+// The result must be at least `required` elements.
+
+/**
+ * Geometric growth by Num/Den, factor_growth<3, 2> gives the memory friendly 1.5 factor.
+ */
+template <std::size_t Num = 2, std::size_t Den = 1>
+struct factor_growth
+{
+    static_assert(Den > 0 && Num > Den, "The growth factor must be greater than one");
+
+    static std::size_t next_capacity(std::size_t capacity, std::size_t required, std::size_t) noexcept
+    {
+        std::size_t grown = capacity / Den * Num + capacity % Den * Num / Den + 1;
+        return grown < required ? required : grown;
+    }
+};
+
+/**
+ * Base growth, large buffers (at least Threshold bytes) rounded up to whole pages.
+ */
+template <typename Base = factor_growth<>, std::size_t PageSize = 4096, std::size_t Threshold = 64 * 1024>
+struct page_growth
+{
+    static_assert((PageSize & (PageSize - 1)) == 0, "Page size must be a power of two");
+
+    static std::size_t next_capacity(std::size_t capacity, std::size_t required, std::size_t element_size) noexcept
+    {
+        std::size_t grown = Base::next_capacity(capacity, required, element_size);
+        std::size_t bytes = grown * element_size;
+
+        if (bytes < Threshold)
+            return grown;
+
+        return ((bytes + PageSize - 1) & ~(PageSize - 1)) / element_size;
+    }
+};
+
+/**
+ * Base growth rounded up to the allocator size classes (four classes per power of two,
+ * as in jemalloc & co), so the slack the allocator hands out anyway becomes usable capacity.
+ */
+template <typename Base = factor_growth<>>
+struct size_class_growth
+{
+    static std::size_t round_to_size_class(std::size_t bytes) noexcept
+    {
+        if (bytes <= 16)
+            return 16;
+
+        // bytes lies in (power, 2 * power], split into four classes (never finer than 16 bytes)
+        std::size_t power = 16;
+        while (power * 2 < bytes)
+            power <<= 1;
+
+        std::size_t step = power / 4 < 16 ? 16 : power / 4;
+        return (bytes + step - 1) / step * step;
+    }
+
+    static std::size_t next_capacity(std::size_t capacity, std::size_t required, std::size_t element_size) noexcept
+    {
+        std::size_t grown = Base::next_capacity(capacity, required, element_size);
+        return round_to_size_class(grown * element_size) / element_size;
+    }
+};
+
+/**
+ * Non-owning view of contiguous elements, a minimal stand-in for the C++20 std::span.
+ */
+template <typename T>
+class fast_span
+{
+public:
+    using size_type = std::size_t;
+    using value_type = std::remove_cv_t<T>;
+
+    constexpr fast_span() noexcept = default;
+    constexpr fast_span(T* data, size_type size) noexcept : m_data(data), m_size(size) {}
+
+    constexpr T* data() const noexcept { return m_data; }
+    constexpr size_type size() const noexcept { return m_size; }
+    constexpr bool empty() const noexcept { return m_size == 0; }
+
+    constexpr T* begin() const noexcept { return m_data; }
+    constexpr T* end() const noexcept { return m_data + m_size; }
+
+    T& operator[](size_type pos) const
+    {
+        assert(pos < m_size && "Position is out of range");
+        return m_data[pos];
+    }
+
+    fast_span first(size_type count) const
+    {
+        assert(count <= m_size && "Count is out of range");
+        return {m_data, count};
+    }
+
+    fast_span subspan(size_type offset, size_type count) const
+    {
+        assert(offset + count <= m_size && "Range is out of range");
+        return {m_data + offset, count};
+    }
+
+private:
+    T* m_data = nullptr;
+    size_type m_size = 0;
+};
+
 /**
  * The fast & light-weight std::vector replacement, best used for plain POD types.
+ * The storage is aligned to at least A bytes (and never less than alignof(T))
+ * and obtained from the allocation policy M. The capacity grows according to the policy G.
  */
-template <typename T, bool F = false, int A = 16>
+template <typename T, bool F = false, int A = 16, typename M = malloc_allocator, typename G = factor_growth<>>
 class fast_vector
 {
 public:
@@ -82,6 +483,9 @@ public:
 
     fast_vector() = default;
     fast_vector(size_t size);
+    fast_vector(size_t size, no_init_t);
+    fast_vector(size_t size, zero_init_t);
+    fast_vector(size_t size, const T& value);
     fast_vector(const fast_vector& other);
     fast_vector(std::initializer_list<T>&& other);
     fast_vector(fast_vector&& other) noexcept;
@@ -96,8 +500,10 @@ public:
     T& operator[](size_type pos);
     const T& operator[](size_type pos) const;
 
+#if !defined(FAST_VECTOR_NO_EXCEPTIONS)
     T& at(size_type pos);
     const T& at(size_type pos) const;
+#endif
 
     T& front();
     const T& front() const;
@@ -108,6 +514,10 @@ public:
     T* data() noexcept;
     const T* data() const noexcept;
 
+    // data() with the alignment promise attached, lets the compiler emit aligned SIMD loads
+    T* aligned_data() noexcept;
+    const T* aligned_data() const noexcept;
+
     // Iterators
 
     T* begin() noexcept;
@@ -116,6 +526,17 @@ public:
     T* end() noexcept;
     const T* end() const noexcept;
 
+    // Lookup, vectorized for the arithmetic types
+
+    T* find(const T& value);
+    const T* find(const T& value) const;
+    bool contains(const T& value) const;
+    size_type count(const T& value) const;
+    // Position of the first occurrence, npos when there is none
+    size_type index_of(const T& value) const;
+
+    static constexpr size_type npos = size_type(-1);
+
     // Capacity
 
     bool empty() const noexcept;
@@ -124,6 +545,15 @@ public:
     size_type capacity() const noexcept;
     void shrink_to_fit();
 
+    // Non-throwing counterparts of reserve(), push_back(), append() and resize(), the vector
+    // stays as it was when the allocation fails
+
+    fast_vector_status try_reserve(size_type new_cap);
+    fast_vector_status try_push_back(const T& value);
+    fast_vector_status try_push_back(T&& value);
+    fast_vector_status try_append(const T value[], size_type count);
+    fast_vector_status try_resize(size_type count);
+
     // Modifiers
 
     void clear() noexcept;
@@ -136,53 +566,195 @@ public:
     
     void append(const T value[], size_t count);
 
+    class append_buffer;
+
+    // Zero-copy producers (trivial types only): grows the size by count at once and returns
+    // the uninitialized tail to be written in place, commit() gives back the unused part
+    append_buffer append_uninitialized(size_type count);
+
     void pop_back();
+
+    // New elements are default-initialized (trivial ones left as they are) unless asked otherwise
     void resize(size_type count);
+    void resize(size_type count, no_init_t);
+    void resize(size_type count, zero_init_t);
+    void resize(size_type count, const T& value);
+
     bool erase(const T value);
 
-    static void swap(fast_vector<T>& a, fast_vector<T>& b);
+    // Positional modifiers, the returned pointer addresses the first inserted element
+
+    T* insert(const T* pos, const T& value);
+    T* insert(const T* pos, T&& value);
+    T* insert(const T* pos, size_type count, const T& value);
+    T* insert(const T* pos, std::initializer_list<T> values);
+
+    template< class InputIt, typename = std::enable_if_t<!std::is_integral_v<InputIt>> >
+    T* insert(const T* pos, InputIt first, InputIt last);
+
+    template< class... Args >
+    T* emplace(const T* pos, Args&&... args);
+
+    // Returns the pointer following the removed elements
+    T* erase(const T* pos);
+    T* erase(const T* first, const T* last);
+
+    // One pass compaction keeping the order, return the number of removed elements
+    template< class Pred >
+    size_type erase_if(Pred pred);
+    size_type erase_all(const T& value);
 
-    static constexpr size_type grow_factor = 2;
+    // Sorting: LSD radix sort over the keys with radix_key_traits<> (integers, floating point,
+    // pairs of integers) using a scratch buffer from M, pattern-defeating quicksort otherwise.
+    // The *_by_key() members order by key(element), any callable or a member pointer.
+    // The stable members sort floating point keys by comparison, the radix order would put
+    // -0.0 before 0.0 and reorder the elements operator< treats as equal.
+
+    void sort();
+    template< class Compare >
+    void sort(Compare comp);
+    template< class Key >
+    void sort_by_key(Key key);
+
+    void stable_sort();
+    template< class Compare >
+    void stable_sort(Compare comp);
+    template< class Key >
+    void stable_sort_by_key(Key key);
+
+    static void swap(fast_vector& a, fast_vector& b);
+
+    static constexpr size_type alignment = A > int(alignof(T)) ? size_type(A) : alignof(T);
+
+    static_assert(A > 0 && (A & (A - 1)) == 0, "Alignment must be a power of two");
+
+    using allocator_type = M;
+    using growth_policy = G;
 
 private:
+    // Elements may be moved by realloc/memmove instead of constructors
+    static constexpr bool relocatable = is_trivially_relocatable_v<T> | F;
+
+    // Opens a hole of count raw slots at index and lets fill(T*) construct them there.
+    // Every existing element is moved at most once.
+    template <typename Fill>
+    T* insert_gap(size_type index, size_type count, Fill&& fill);
+
+    // Radix sorts by key(element) (already an unsigned radix key). False when the vector is
+    // too small to pay off or the scratch buffer cannot be allocated, the caller then falls
+    // back to a comparison sort.
+    template <typename Key>
+    bool radix_sort_by(Key key);
+
     T* m_data = nullptr;
     size_type m_size = 0;
     size_type m_capacity = 0;
 };
 
-template <typename T, bool F, int A>
-fast_vector<T,F,A>::fast_vector(size_t size) :
+/**
+ * The tail handed out by append_uninitialized(). The elements belong to the vector already,
+ * commit(used) shrinks them to the written ones. Any other change of the vector invalidates it.
+ */
+template <typename T, bool F, int A, typename M, typename G>
+class fast_vector<T,F,A,M,G>::append_buffer
+{
+public:
+    T* data() const noexcept { return m_owner->m_data + m_offset; }
+    size_type size() const noexcept { return m_count; }
+
+    T* begin() const noexcept { return data(); }
+    T* end() const noexcept { return data() + m_count; }
+
+    fast_span<T> span() const noexcept { return {data(), m_count}; }
+
+    // Keeps the first used elements, drops the rest of the tail
+    void commit(size_type used) noexcept
+    {
+        assert(used <= m_count && "More elements committed than appended");
+        assert(m_owner->m_size == m_offset + m_count && "The vector changed since the append");
+
+        m_owner->m_size = m_offset + used;
+        m_count = used;
+    }
+
+private:
+    friend class fast_vector;
+
+    append_buffer(fast_vector* owner, size_type offset, size_type count) noexcept :
+        m_owner(owner),
+        m_offset(offset),
+        m_count(count)
+    {
+    }
+
+    fast_vector* m_owner;
+    size_type m_offset;
+    size_type m_count;
+};
+
+template <typename T, bool F, int A, typename M, typename G>
+fast_vector<T,F,A,M,G>::fast_vector(size_t size) :
+    fast_vector(size, no_init)
+{
+}
+
+template <typename T, bool F, int A, typename M, typename G>
+fast_vector<T,F,A,M,G>::fast_vector(size_t size, no_init_t) :
     m_size(size),
     m_capacity(size)
 {
-    m_data = reinterpret_cast<T*>(std::malloc(sizeof(T) * m_capacity));
+    m_data = reinterpret_cast<T*>(M::allocate(sizeof(T) * m_capacity, alignment));
 
-    if (!m_data)
-        throw std::bad_alloc{};
+    if (!m_data && m_capacity)
+        fast_vector_out_of_memory();
 
-    if (std::is_trivial_v<T> | F)
-        memset(m_data, 0, sizeof(T) * m_capacity);
-    else
+    if constexpr (!(std::is_trivial_v<T> | F))
         construct_range(begin(), end());
 }
 
-template <typename T, bool F, int A>
-fast_vector<T,F,A>::fast_vector(std::initializer_list<T>&& other) :
+template <typename T, bool F, int A, typename M, typename G>
+fast_vector<T,F,A,M,G>::fast_vector(size_t size, zero_init_t) :
+    m_size(size),
+    m_capacity(size)
+{
+    static_assert(std::is_trivial_v<T> | F, "Only trivial types can be zero initialized");
+
+    m_data = reinterpret_cast<T*>(M::allocate_zeroed(sizeof(T) * m_capacity, alignment));
+
+    if (!m_data && m_capacity)
+        fast_vector_out_of_memory();
+}
+
+template <typename T, bool F, int A, typename M, typename G>
+fast_vector<T,F,A,M,G>::fast_vector(size_t size, const T& value) :
+    m_size(size),
+    m_capacity(size)
+{
+    m_data = reinterpret_cast<T*>(M::allocate(sizeof(T) * m_capacity, alignment));
+
+    if (!m_data && m_capacity)
+        fast_vector_out_of_memory();
+
+    fill_range(begin(), end(), value);
+}
+
+template <typename T, bool F, int A, typename M, typename G>
+fast_vector<T,F,A,M,G>::fast_vector(std::initializer_list<T>&& other) :
     fast_vector(other.begin(), other.end())
 {
 }
 
-template <typename T, bool F, int A>
-fast_vector<T,F,A>::fast_vector(const T a[], const T b[])
+template <typename T, bool F, int A, typename M, typename G>
+fast_vector<T,F,A,M,G>::fast_vector(const T a[], const T b[])
   : m_size(b - a)
   , m_capacity(b - a)
 {
-    m_data = reinterpret_cast<T*>(std::malloc(sizeof(T) * m_capacity));
+    m_data = reinterpret_cast<T*>(M::allocate(sizeof(T) * m_capacity, alignment));
 
-    if (!m_data)
-        throw std::bad_alloc{};
+    if (!m_data && m_capacity)
+        fast_vector_out_of_memory();
 
-    if (std::is_trivial_v<T>)
+    if constexpr (std::is_trivial_v<T>)
     {
         std::memcpy(m_data, a, sizeof(T) * m_capacity);
     }
@@ -192,19 +764,20 @@ fast_vector<T,F,A>::fast_vector(const T a[], const T b[])
     }
 }
 
-template <typename T, bool F, int A>
-fast_vector<T,F,A>::fast_vector(const fast_vector& other)
+template <typename T, bool F, int A, typename M, typename G>
+fast_vector<T,F,A,M,G>::fast_vector(const fast_vector& other)
     : m_size(other.m_size)
     , m_capacity(other.m_size)
 {
-    m_data = reinterpret_cast<T*>(std::malloc(sizeof(T) * m_size));
+    m_data = reinterpret_cast<T*>(M::allocate(sizeof(T) * m_size, alignment));
 
-    if (!m_data)
-        throw std::bad_alloc{};
+    if (!m_data && m_capacity)
+        fast_vector_out_of_memory();
 
-    if (std::is_trivial_v<T>)
+    if constexpr (std::is_trivial_v<T>)
     {
-        std::memcpy(m_data, other.m_data, sizeof(T) * m_size);
+        if (m_size)
+            std::memcpy(m_data, other.m_data, sizeof(T) * m_size);
     }
     else
     {
@@ -212,56 +785,50 @@ fast_vector<T,F,A>::fast_vector(const fast_vector& other)
     }
 }
 
-template <typename T, bool F, int A>
-fast_vector<T,F,A>::fast_vector(fast_vector&& other) noexcept
+template <typename T, bool F, int A, typename M, typename G>
+fast_vector<T,F,A,M,G>::fast_vector(fast_vector&& other) noexcept
     : m_data(other.m_data)
     , m_size(other.m_size)
     , m_capacity(other.m_capacity)
 {
     other.m_data = nullptr;
+    other.m_size = 0;
+    other.m_capacity = 0;
 }
 
-template <typename T, bool F, int A>
-fast_vector<T,F,A>& fast_vector<T,F,A>::operator=(const fast_vector& other)
+template <typename T, bool F, int A, typename M, typename G>
+fast_vector<T,F,A,M,G>& fast_vector<T,F,A,M,G>::operator=(const fast_vector& other)
 {
-    this->~fast_vector<T,F,A>();
-
-    m_size = other.m_size;
-    m_capacity = other.m_size;
-
-    m_data = reinterpret_cast<T*>(std::malloc(sizeof(T) * m_size));
-
-    if (!m_data)
-        throw std::bad_alloc{};
-
-    if (std::is_trivial_v<T>)
-    {
-        std::memcpy(m_data, other.m_data, sizeof(T) * m_size);
-    }
-    else
-    {
-        copy_range(other.begin(), other.end(), m_data);
-    }
+    if (this == &other)
+        return *this;
 
+    // Copied into a new block first, a failed allocation leaves this vector intact
+    fast_vector copy(other);
+    *this = std::move(copy);
     return *this;
 }
 
-template <typename T, bool F, int A>
-fast_vector<T,F,A>& fast_vector<T,F,A>::operator=(fast_vector&& other) noexcept
+template <typename T, bool F, int A, typename M, typename G>
+fast_vector<T,F,A,M,G>& fast_vector<T,F,A,M,G>::operator=(fast_vector&& other) noexcept
 {
-    this->~fast_vector<T,F,A>();
+    if (this == &other)
+        return *this;
+
+    this->~fast_vector<T,F,A,M,G>();
 
     m_data = other.m_data;
     m_size = other.m_size;
-    m_capacity = other.m_size;
+    m_capacity = other.m_capacity;
 
     other.m_data = nullptr;
+    other.m_size = 0;
+    other.m_capacity = 0;
 
     return *this;
 }
 
-template <typename T, bool F, int A>
-fast_vector<T,F,A>::~fast_vector()
+template <typename T, bool F, int A, typename M, typename G>
+fast_vector<T,F,A,M,G>::~fast_vector()
 {
     if (m_data)
     {
@@ -269,12 +836,12 @@ fast_vector<T,F,A>::~fast_vector()
         {
             destruct_range(begin(), end());
         }
-        std::free(m_data);
+        M::deallocate(m_data, sizeof(T) * m_capacity, alignment);
     }
 }
 
-template <typename T, bool F, int A>
-void fast_vector<T,F,A>::swap(fast_vector<T>& a, fast_vector<T>& b)
+template <typename T, bool F, int A, typename M, typename G>
+void fast_vector<T,F,A,M,G>::swap(fast_vector& a, fast_vector& b)
 {
     std::swap(a.m_data, b.m_data);
     std::swap(a.m_size, b.m_size);
@@ -283,22 +850,24 @@ void fast_vector<T,F,A>::swap(fast_vector<T>& a, fast_vector<T>& b)
 
 // Element access
 
-template <typename T, bool F, int A>
-T& fast_vector<T,F,A>::operator[](size_type pos)
+template <typename T, bool F, int A, typename M, typename G>
+T& fast_vector<T,F,A,M,G>::operator[](size_type pos)
 {
     assert(pos < m_size && "Position is out of range");
     return m_data[pos];
 }
 
-template <typename T, bool F, int A>
-const T& fast_vector<T,F,A>::operator[](size_type pos) const
+template <typename T, bool F, int A, typename M, typename G>
+const T& fast_vector<T,F,A,M,G>::operator[](size_type pos) const
 {
     assert(pos < m_size && "Position is out of range");
     return m_data[pos];
 }
 
-template <typename T, bool F, int A>
-T& fast_vector<T,F,A>::at(size_type pos)
+#if !defined(FAST_VECTOR_NO_EXCEPTIONS)
+
+template <typename T, bool F, int A, typename M, typename G>
+T& fast_vector<T,F,A,M,G>::at(size_type pos)
 {
     if (pos >= m_size)
         throw std::range_error{"Position is out of range"};
@@ -306,8 +875,8 @@ T& fast_vector<T,F,A>::at(size_type pos)
     return operator [](pos);
 }
 
-template <typename T, bool F, int A>
-const T& fast_vector<T,F,A>::at(size_type pos) const
+template <typename T, bool F, int A, typename M, typename G>
+const T& fast_vector<T,F,A,M,G>::at(size_type pos) const
 {
     if (pos >= m_size)
         throw std::range_error{"Position is out of range"};
@@ -315,151 +884,233 @@ const T& fast_vector<T,F,A>::at(size_type pos) const
     return operator [](pos);
 }
 
-template <typename T, bool F, int A>
-T& fast_vector<T,F,A>::front()
+#endif // FAST_VECTOR_NO_EXCEPTIONS
+
+template <typename T, bool F, int A, typename M, typename G>
+T& fast_vector<T,F,A,M,G>::front()
 {
     assert(m_size > 0 && "Container is empty");
     return m_data[0];
 }
 
-template <typename T, bool F, int A>
-const T& fast_vector<T,F,A>::front() const
+template <typename T, bool F, int A, typename M, typename G>
+const T& fast_vector<T,F,A,M,G>::front() const
 {
     assert(m_size > 0 && "Container is empty");
     return m_data[0];
 }
 
-template <typename T, bool F, int A>
-T& fast_vector<T,F,A>::back()
+template <typename T, bool F, int A, typename M, typename G>
+T& fast_vector<T,F,A,M,G>::back()
 {
     assert(m_size > 0 && "Container is empty");
     return m_data[m_size - 1];
 }
 
-template <typename T, bool F, int A>
-const T& fast_vector<T,F,A>::back() const
+template <typename T, bool F, int A, typename M, typename G>
+const T& fast_vector<T,F,A,M,G>::back() const
 {
     assert(m_size > 0 && "Container is empty");
     return m_data[m_size - 1];
 }
 
-template <typename T, bool F, int A>
-T* fast_vector<T,F,A>::data() noexcept
+template <typename T, bool F, int A, typename M, typename G>
+T* fast_vector<T,F,A,M,G>::data() noexcept
 {
     return m_data;
 }
 
-template <typename T, bool F, int A>
-const T* fast_vector<T,F,A>::data() const noexcept
+template <typename T, bool F, int A, typename M, typename G>
+const T* fast_vector<T,F,A,M,G>::data() const noexcept
 {
     return m_data;
 }
 
+template <typename T, bool F, int A, typename M, typename G>
+T* fast_vector<T,F,A,M,G>::aligned_data() noexcept
+{
+    return assume_aligned<alignment>(m_data);
+}
+
+template <typename T, bool F, int A, typename M, typename G>
+const T* fast_vector<T,F,A,M,G>::aligned_data() const noexcept
+{
+    return assume_aligned<alignment>(m_data);
+}
+
 // Iterators
 
-template <typename T, bool F, int A>
-T* fast_vector<T,F,A>::begin() noexcept
+template <typename T, bool F, int A, typename M, typename G>
+T* fast_vector<T,F,A,M,G>::begin() noexcept
 {
     return m_data;
 }
 
-template <typename T, bool F, int A>
-const T* fast_vector<T,F,A>::begin() const noexcept
+template <typename T, bool F, int A, typename M, typename G>
+const T* fast_vector<T,F,A,M,G>::begin() const noexcept
 {
     return m_data;
 }
 
-template <typename T, bool F, int A>
-T* fast_vector<T,F,A>::end() noexcept
+template <typename T, bool F, int A, typename M, typename G>
+T* fast_vector<T,F,A,M,G>::end() noexcept
 {
     return m_data + m_size;
 }
 
-template <typename T, bool F, int A>
-const T* fast_vector<T,F,A>::end() const noexcept
+template <typename T, bool F, int A, typename M, typename G>
+const T* fast_vector<T,F,A,M,G>::end() const noexcept
 {
     return m_data + m_size;
 }
 
+// Lookup
+
+template <typename T, bool F, int A, typename M, typename G>
+T* fast_vector<T,F,A,M,G>::find(const T& value)
+{
+    return find_item(begin(), end(), value);
+}
+
+template <typename T, bool F, int A, typename M, typename G>
+const T* fast_vector<T,F,A,M,G>::find(const T& value) const
+{
+    return find_item(begin(), end(), value);
+}
+
+template <typename T, bool F, int A, typename M, typename G>
+bool fast_vector<T,F,A,M,G>::contains(const T& value) const
+{
+    return find(value) != end();
+}
+
+template <typename T, bool F, int A, typename M, typename G>
+typename fast_vector<T,F,A,M,G>::size_type fast_vector<T,F,A,M,G>::count(const T& value) const
+{
+    if constexpr (is_simd_element_v<T>)
+    {
+        return count_equal(begin(), end(), value);
+    }
+    else
+    {
+        size_type count = 0;
+        for (const T& item : *this)
+        {
+            count += item == value;
+        }
+        return count;
+    }
+}
+
+template <typename T, bool F, int A, typename M, typename G>
+typename fast_vector<T,F,A,M,G>::size_type fast_vector<T,F,A,M,G>::index_of(const T& value) const
+{
+    const T* position = find(value);
+    return position != end() ? size_type(position - begin()) : npos;
+}
+
 // Capacity
 
-template <typename T, bool F, int A>
-bool fast_vector<T,F,A>::empty() const noexcept
+template <typename T, bool F, int A, typename M, typename G>
+bool fast_vector<T,F,A,M,G>::empty() const noexcept
 {
     return m_size == 0;
 }
 
-template <typename T, bool F, int A>
-typename fast_vector<T,F,A>::size_type fast_vector<T,F,A>::size() const noexcept
+template <typename T, bool F, int A, typename M, typename G>
+typename fast_vector<T,F,A,M,G>::size_type fast_vector<T,F,A,M,G>::size() const noexcept
 {
     return m_size;
 }
 
-template <typename T, bool F, int A>
-void fast_vector<T,F,A>::reserve(size_type new_cap)
+template <typename T, bool F, int A, typename M, typename G>
+void fast_vector<T,F,A,M,G>::reserve(size_type new_cap)
+{
+    if (try_reserve(new_cap) != fast_vector_status::ok)
+        fast_vector_out_of_memory();
+}
+
+template <typename T, bool F, int A, typename M, typename G>
+fast_vector_status fast_vector<T,F,A,M,G>::try_reserve(size_type new_cap)
 {
-    if (new_cap > m_capacity)
+    if (new_cap <= m_capacity)
+        return fast_vector_status::ok;
+
+    if (new_cap > size_type(-1) / sizeof(T))
+        return fast_vector_status::length_error;
+
+    if (m_data && M::try_expand(m_data, sizeof(T) * m_capacity, sizeof(T) * new_cap, alignment))
     {
-        if constexpr (std::is_trivial_v<T> | F)
-        {
-            auto old_capacity = m_capacity;
-            m_data = reinterpret_cast<T*>(std::realloc(m_data, sizeof(T) * new_cap));
-            assert(m_data != nullptr && "Reallocation failed");
-            // Reset new range to zero
-            memset(m_data + old_capacity, 0, new_cap-old_capacity);
-        }
-        else
-        {
-            T* new_data_location = reinterpret_cast<T*>(std::malloc(sizeof(T) * new_cap));
-            assert(new_data_location != nullptr && "Allocation failed");
+        // Grown in place, nothing to move
+    }
+    else if constexpr (relocatable)
+    {
+        T* new_data_location = reinterpret_cast<T*>(M::reallocate(m_data, sizeof(T) * m_capacity, sizeof(T) * new_cap, alignment));
+        if (!new_data_location)
+            return fast_vector_status::out_of_memory;
 
-            copy_range(begin(), end(), new_data_location);
-            destruct_range(begin(), end());
+        m_data = new_data_location;
+    }
+    else
+    {
+        T* new_data_location = reinterpret_cast<T*>(M::allocate(sizeof(T) * new_cap, alignment));
+        if (!new_data_location)
+            return fast_vector_status::out_of_memory;
 
-            std::free(m_data);
+        uninitialized_move_range(begin(), end(), new_data_location);
+        destruct_range(begin(), end());
 
-            m_data = new_data_location;
-        }
+        M::deallocate(m_data, sizeof(T) * m_capacity, alignment);
 
-        m_capacity = new_cap;
+        m_data = new_data_location;
     }
+
+    m_capacity = new_cap;
+    return fast_vector_status::ok;
 }
 
-template <typename T, bool F, int A>
-typename fast_vector<T,F,A>::size_type fast_vector<T,F,A>::capacity() const noexcept
+template <typename T, bool F, int A, typename M, typename G>
+typename fast_vector<T,F,A,M,G>::size_type fast_vector<T,F,A,M,G>::capacity() const noexcept
 {
     return m_capacity;
 }
 
-template <typename T, bool F, int A>
-void fast_vector<T,F,A>::shrink_to_fit()
+template <typename T, bool F, int A, typename M, typename G>
+void fast_vector<T,F,A,M,G>::shrink_to_fit()
 {
     if (m_size && m_size < m_capacity)
     {
-        if constexpr (std::is_trivial_v<T> | F)
+        // Shrinking is only a request, the vector keeps its block when no new one is available
+        if constexpr (relocatable)
         {
-            m_data = reinterpret_cast<T*>(std::realloc(m_data, sizeof(T) * m_size));
-            assert(m_data != nullptr && "Reallocation failed");
+            T* new_data_location = reinterpret_cast<T*>(M::reallocate(m_data, sizeof(T) * m_capacity, sizeof(T) * m_size, alignment));
+            if (!new_data_location)
+                return;
+
+            m_data = new_data_location;
         }
         else
         {
-            T* new_data_location = reinterpret_cast<T*>(std::malloc(sizeof(T) * m_size));
-            assert(new_data_location != nullptr && "Allocation failed");
+            T* new_data_location = reinterpret_cast<T*>(M::allocate(sizeof(T) * m_size, alignment));
+            if (!new_data_location)
+                return;
 
-            copy_range(begin(), end(), new_data_location);
+            uninitialized_move_range(begin(), end(), new_data_location);
             destruct_range(begin(), end());
 
-            std::free(m_data);
+            M::deallocate(m_data, sizeof(T) * m_capacity, alignment);
 
             m_data = new_data_location;
         }
+
+        m_capacity = m_size;
     }
 }
 
 // Modifiers
 
-template <typename T, bool F, int A>
-void fast_vector<T,F,A>::clear() noexcept
+template <typename T, bool F, int A, typename M, typename G>
+void fast_vector<T,F,A,M,G>::clear() noexcept
 {
     if constexpr (!(std::is_trivial_v<T> | F))
     {
@@ -469,73 +1120,517 @@ void fast_vector<T,F,A>::clear() noexcept
     m_size = 0;
 }
 
-template <typename T, bool F, int A>
-void fast_vector<T,F,A>::append(const T values[], size_t count)
+template <typename T, bool F, int A, typename M, typename G>
+void fast_vector<T,F,A,M,G>::append(const T values[], size_t count)
+{
+    if (try_append(values, count) != fast_vector_status::ok)
+        fast_vector_out_of_memory();
+}
+
+template <typename T, bool F, int A, typename M, typename G>
+fast_vector_status fast_vector<T,F,A,M,G>::try_append(const T values[], size_type count)
+{
+    if (count == 0)
+        return fast_vector_status::ok;
+
+    if (count > size_type(-1) / sizeof(T) - m_size)
+        return fast_vector_status::length_error;
+
+    if (m_size + count > m_capacity)
+    {
+        // One growth step for the whole batch. A source inside the vector moves with it.
+        bool inside = values >= begin() && values < end();
+        size_type offset = inside ? size_type(values - m_data) : 0;
+
+        fast_vector_status status = try_reserve(G::next_capacity(m_capacity, m_size + count, sizeof(T)));
+        if (status != fast_vector_status::ok)
+            return status;
+
+        if (inside)
+            values = m_data + offset;
+    }
+
+    if constexpr (std::is_trivial_v<T>)
+    {
+        std::memcpy(m_data+m_size, values, count*sizeof(T));
+    }
+    else
+    {
+        copy_range(values, values + count, m_data + m_size);
+    }
+    m_size += count;
+    return fast_vector_status::ok;
+}
+
+template <typename T, bool F, int A, typename M, typename G>
+typename fast_vector<T,F,A,M,G>::append_buffer fast_vector<T,F,A,M,G>::append_uninitialized(size_type count)
+{
+    static_assert(std::is_trivial_v<T> | F, "Only trivial types can be left uninitialized");
+
+    // Reported like reserve() reports a length_error
+    if (count > size_type(-1) / sizeof(T) - m_size)
+        fast_vector_out_of_memory();
+
+    if (m_size + count > m_capacity)
+    {
+        reserve(G::next_capacity(m_capacity, m_size + count, sizeof(T)));
+    }
+
+    size_type offset = m_size;
+    m_size += count;
+
+    return append_buffer(this, offset, count);
+}
+
+template <typename T, bool F, int A, typename M, typename G>
+bool fast_vector<T,F,A,M,G>::erase(const T value)
+{
+    T* position = find_item(begin(), end(), value);
+    if (position < end())
+    {
+        erase(position);
+        return true;
+    }
+    return false;
+}
+
+template <typename T, bool F, int A, typename M, typename G>
+T* fast_vector<T,F,A,M,G>::erase(const T* pos)
+{
+    return erase(pos, pos + 1);
+}
+
+template <typename T, bool F, int A, typename M, typename G>
+T* fast_vector<T,F,A,M,G>::erase(const T* first, const T* last)
 {
-    if (m_size + count >= m_capacity)
+    assert(first >= begin() && first <= last && last <= end() && "Range is out of bounds");
+
+    T* position = m_data + (first - m_data);
+    T* tail = m_data + (last - m_data);
+    size_type count = last - first;
+
+    if (count == 0)
+        return position;
+
+    if constexpr (relocatable)
     {
-        for (size_t i = 0; i < count; i++)
+        if constexpr (!std::is_trivially_destructible_v<T>)
         {
-            push_back(values[i]);
+            destruct_range(position, tail);
         }
+        relocate_range(tail, end(), position);
     }
     else
     {
-        if constexpr (std::is_trivial_v<T>)
+        move_range(tail, end(), position);
+        destruct_range(end() - count, end());
+    }
+
+    m_size -= count;
+    return position;
+}
+
+template <typename T, bool F, int A, typename M, typename G>
+template< class Pred >
+typename fast_vector<T,F,A,M,G>::size_type fast_vector<T,F,A,M,G>::erase_if(Pred pred)
+{
+    T* last = end();
+    T* it = begin();
+
+    while (it != last && !pred(*it))
+        ++it;
+
+    T* out = it;
+
+    if constexpr (relocatable)
+    {
+        // *it is always a removed one here, the survivors in between are moved run by run
+        while (it != last)
         {
-            std::memcpy(m_data+m_size, values, count*sizeof(T));
+            if constexpr (!std::is_trivially_destructible_v<T>)
+            {
+                it->~T();
+            }
+            T* run = ++it;
+
+            while (it != last && !pred(*it))
+                ++it;
+
+            relocate_range(run, it, out);
+            out += it - run;
         }
-        else
+    }
+    else
+    {
+        if (it != last)
         {
-            copy_range(values, values + count, m_data + m_size);
+            for (++it; it != last; ++it)
+            {
+                if (!pred(*it))
+                {
+                    *out = std::move(*it);
+                    ++out;
+                }
+            }
+            destruct_range(out, last);
         }
-        m_size += count;
     }
+
+    size_type removed = last - out;
+    m_size -= removed;
+    return removed;
 }
 
-template <typename T, bool F, int A>
-bool fast_vector<T,F,A>::erase(const T value)
+template <typename T, bool F, int A, typename M, typename G>
+typename fast_vector<T,F,A,M,G>::size_type fast_vector<T,F,A,M,G>::erase_all(const T& value)
 {
-    T* position = find_item(begin(), end(), value);
-    if (position < end())
+    if constexpr (is_simd_element_v<T>)
+    {
+        size_type removed = end() - compress_not_equal(begin(), end(), value);
+        m_size -= removed;
+        return removed;
+    }
+    else
+    {
+        return erase_if([&value](const T& item) { return item == value; });
+    }
+}
+
+// Sorting
+
+template <typename T, bool F, int A, typename M, typename G>
+template <typename Key>
+bool fast_vector<T,F,A,M,G>::radix_sort_by(Key key)
+{
+    if (m_size < radix_sort_threshold * sizeof(decltype(key(*m_data))))
+        return false;
+
+    T* scratch = reinterpret_cast<T*>(M::allocate(sizeof(T) * m_size, alignment));
+    if (!scratch)
+        return false;
+
+    radix_sort(m_data, scratch, m_size, key);
+
+    M::deallocate(scratch, sizeof(T) * m_size, alignment);
+    return true;
+}
+
+template <typename T, bool F, int A, typename M, typename G>
+void fast_vector<T,F,A,M,G>::sort()
+{
+    if constexpr (has_radix_key_v<T> && relocatable)
+    {
+        if (radix_sort_by([](const T& item) { return radix_key_traits<T>::key(item); }))
+            return;
+    }
+
+    pdqsort(begin(), end(), std::less<T>());
+}
+
+template <typename T, bool F, int A, typename M, typename G>
+template< class Compare >
+void fast_vector<T,F,A,M,G>::sort(Compare comp)
+{
+    pdqsort(begin(), end(), comp);
+}
+
+template <typename T, bool F, int A, typename M, typename G>
+template< class Key >
+void fast_vector<T,F,A,M,G>::sort_by_key(Key key)
+{
+    using key_type = std::decay_t<std::invoke_result_t<Key&, const T&>>;
+
+    if constexpr (has_radix_key_v<key_type> && relocatable)
+    {
+        if (radix_sort_by([&key](const T& item) { return radix_key_traits<key_type>::key(std::invoke(key, item)); }))
+            return;
+    }
+
+    auto less = [&key](const T& a, const T& b) { return std::invoke(key, a) < std::invoke(key, b); };
+    pdqsort<std::is_arithmetic_v<key_type>>(begin(), end(), less);
+}
+
+template <typename T, bool F, int A, typename M, typename G>
+void fast_vector<T,F,A,M,G>::stable_sort()
+{
+    // The radix sort is stable already
+    if constexpr (has_radix_key_v<T> && !std::is_floating_point_v<T> && relocatable)
+    {
+        if (radix_sort_by([](const T& item) { return radix_key_traits<T>::key(item); }))
+            return;
+    }
+
+    std::stable_sort(begin(), end());
+}
+
+template <typename T, bool F, int A, typename M, typename G>
+template< class Compare >
+void fast_vector<T,F,A,M,G>::stable_sort(Compare comp)
+{
+    std::stable_sort(begin(), end(), comp);
+}
+
+template <typename T, bool F, int A, typename M, typename G>
+template< class Key >
+void fast_vector<T,F,A,M,G>::stable_sort_by_key(Key key)
+{
+    using key_type = std::decay_t<std::invoke_result_t<Key&, const T&>>;
+
+    if constexpr (has_radix_key_v<key_type> && !std::is_floating_point_v<key_type> && relocatable)
+    {
+        if (radix_sort_by([&key](const T& item) { return radix_key_traits<key_type>::key(std::invoke(key, item)); }))
+            return;
+    }
+
+    std::stable_sort(begin(), end(), [&key](const T& a, const T& b) { return std::invoke(key, a) < std::invoke(key, b); });
+}
+
+template <typename T, bool F, int A, typename M, typename G>
+template <typename Fill>
+T* fast_vector<T,F,A,M,G>::insert_gap(size_type index, size_type count, Fill&& fill)
+{
+    assert(index <= m_size && "Position is out of range");
+
+    if (count == 0)
+        return m_data + index;
+
+    if (m_size + count > m_capacity)
     {
-        size_t count = end() - position - 1;
+        size_type new_cap = G::next_capacity(m_capacity, m_size + count, sizeof(T));
 
-        if constexpr (std::is_trivial_v<T> | F)
+        if (index == m_size)
         {
-            position->~T();
-            if (count > 0)
+            // Appending, the realloc fast path applies
+            reserve(new_cap);
+        }
+        else if (m_data && M::try_expand(m_data, sizeof(T) * m_capacity, sizeof(T) * new_cap, alignment))
+        {
+            m_capacity = new_cap;
+        }
+        else
+        {
+            // Build the new block around the hole, the old one stays valid until fill() is done
+            T* new_data_location = reinterpret_cast<T*>(M::allocate(sizeof(T) * new_cap, alignment));
+            if (!new_data_location)
+                fast_vector_out_of_memory();
+
+            fill(new_data_location + index);
+
+            if constexpr (relocatable)
+            {
+                relocate_range(begin(), begin() + index, new_data_location);
+                relocate_range(begin() + index, end(), new_data_location + index + count);
+            }
+            else
             {
-                std::memcpy(position, position + 1, count*sizeof(T));
+                uninitialized_move_range(begin(), begin() + index, new_data_location);
+                uninitialized_move_range(begin() + index, end(), new_data_location + index + count);
+                destruct_range(begin(), end());
             }
+
+            M::deallocate(m_data, sizeof(T) * m_capacity, alignment);
+
+            m_data = new_data_location;
+            m_capacity = new_cap;
+            m_size += count;
+
+            return m_data + index;
         }
-        else
+    }
+
+    T* position = m_data + index;
+    T* old_end = end();
+
+    if constexpr (relocatable)
+    {
+        relocate_range(position, old_end, position + count);
+    }
+    else if (position != old_end)
+    {
+        // The elements landing past the old end are constructed, the rest is assigned
+        T* split = size_type(old_end - position) > count ? old_end - count : position;
+
+        uninitialized_move_range(split, old_end, split + count);
+
+        T* src = split;
+        while (src != position)
+        {
+            --src;
+            src[count] = std::move(*src);
+        }
+
+        // The hole is handed over as raw memory
+        destruct_range(position, split == position ? old_end : position + count);
+    }
+
+    fill(position);
+    m_size += count;
+
+    return position;
+}
+
+template <typename T, bool F, int A, typename M, typename G>
+T* fast_vector<T,F,A,M,G>::insert(const T* pos, const T& value)
+{
+    return insert(pos, 1, value);
+}
+
+template <typename T, bool F, int A, typename M, typename G>
+T* fast_vector<T,F,A,M,G>::insert(const T* pos, T&& value)
+{
+    return insert_gap(pos - m_data, 1, [&value](T* hole)
+    {
+        new (hole) T(std::move(value));
+    });
+}
+
+template <typename T, bool F, int A, typename M, typename G>
+T* fast_vector<T,F,A,M,G>::insert(const T* pos, size_type count, const T& value)
+{
+    if (&value >= begin() && &value < end())
+    {
+        // The value lives inside and would be moved by the insertion
+        T copy(value);
+        return insert(pos, count, copy);
+    }
+
+    return insert_gap(pos - m_data, count, [&value, count](T* hole)
+    {
+        for (size_type i = 0; i < count; i++)
+        {
+            new (hole + i) T(value);
+        }
+    });
+}
+
+template <typename T, bool F, int A, typename M, typename G>
+T* fast_vector<T,F,A,M,G>::insert(const T* pos, std::initializer_list<T> values)
+{
+    return insert(pos, values.begin(), values.end());
+}
+
+template <typename T, bool F, int A, typename M, typename G>
+template< class InputIt, typename >
+T* fast_vector<T,F,A,M,G>::insert(const T* pos, InputIt first, InputIt last)
+{
+    using category = typename std::iterator_traits<InputIt>::iterator_category;
+
+    size_type index = pos - m_data;
+
+    if constexpr (std::is_base_of_v<std::forward_iterator_tag, category>)
+    {
+        size_type count = std::distance(first, last);
+
+        return insert_gap(index, count, [first, count](T* hole) mutable
         {
-            if (count > 0)
+            if constexpr (std::is_trivial_v<T> && std::is_pointer_v<InputIt> &&
+                          std::is_same_v<std::remove_cv_t<std::remove_pointer_t<InputIt>>, T>)
             {
-                for (size_t i = 0; i < count; i++)
-                {
-                    *position = std::move(*(position + 1));
-                    ++position;
-                }
+                std::memcpy(hole, first, sizeof(T) * count);
             }
             else
             {
-                position->~T();
+                for (size_type i = 0; i < count; i++, ++first)
+                {
+                    new (hole + i) T(*first);
+                }
             }
+        });
+    }
+    else
+    {
+        // Single pass input, one element at a time
+        for (size_type i = index; first != last; ++first, ++i)
+        {
+            emplace(m_data + i, *first);
         }
-        --m_size;
-        return true;
+        return m_data + index;
     }
-    return false;
 }
 
-template <typename T, bool F, int A>
-void fast_vector<T,F,A>::push_back(const T& value)
+template <typename T, bool F, int A, typename M, typename G>
+template< class... Args >
+T* fast_vector<T,F,A,M,G>::emplace(const T* pos, Args&&... args)
+{
+    size_type index = pos - m_data;
+
+    if (index != m_size || m_size == m_capacity)
+    {
+        // Shifting or growing could move or free what the arguments refer to, build the element first
+        T value(std::forward<Args>(args)...);
+
+        return insert_gap(index, 1, [&value](T* hole)
+        {
+            new (hole) T(std::move(value));
+        });
+    }
+
+    return insert_gap(index, 1, [&args...](T* hole)
+    {
+        new (hole) T(std::forward<Args>(args)...);
+    });
+}
+
+template <typename T, bool F, int A, typename M, typename G>
+void fast_vector<T,F,A,M,G>::push_back(const T& value)
+{
+    if (m_size == m_capacity)
+    {
+        if constexpr (std::is_trivial_v<T>)
+        {
+            // Read before the reallocation, the value may live inside
+            T copy = value;
+            reserve(G::next_capacity(m_capacity, m_size + 1, sizeof(T)));
+            m_data[m_size++] = copy;
+            return;
+        }
+        else if (&value >= begin() && &value < end())
+        {
+            // The value lives inside and would be moved by the reallocation
+            T copy(value);
+            push_back(std::move(copy));
+            return;
+        }
+
+        reserve(G::next_capacity(m_capacity, m_size + 1, sizeof(T)));
+    }
+
+    if constexpr (std::is_trivial_v<T>)
+    {
+        m_data[m_size] = value;
+    }
+    else
+    {
+        new (m_data + m_size) T(value);
+    }
+
+    m_size++;
+}
+
+template <typename T, bool F, int A, typename M, typename G>
+fast_vector_status fast_vector<T,F,A,M,G>::try_push_back(const T& value)
 {
     if (m_size == m_capacity)
     {
-        reserve(m_capacity * fast_vector::grow_factor + 1);
+        if constexpr (std::is_trivial_v<T>)
+        {
+            // Read before the reallocation, the value may live inside
+            T copy = value;
+            fast_vector_status status = try_reserve(G::next_capacity(m_capacity, m_size + 1, sizeof(T)));
+            if (status == fast_vector_status::ok)
+                m_data[m_size++] = copy;
+            return status;
+        }
+        else if (&value >= begin() && &value < end())
+        {
+            // The value lives inside and would be moved by the reallocation
+            T copy(value);
+            return try_push_back(std::move(copy));
+        }
+
+        fast_vector_status status = try_reserve(G::next_capacity(m_capacity, m_size + 1, sizeof(T)));
+        if (status != fast_vector_status::ok)
+            return status;
     }
 
     if constexpr (std::is_trivial_v<T>)
@@ -547,15 +1642,66 @@ void fast_vector<T,F,A>::push_back(const T& value)
         new (m_data + m_size) T(value);
     }
 
+    m_size++;
+    return fast_vector_status::ok;
+}
+
+template <typename T, bool F, int A, typename M, typename G>
+void fast_vector<T,F,A,M,G>::push_back(T&& value)
+{
+    if (m_size == m_capacity)
+    {
+        if constexpr (std::is_trivial_v<T>)
+        {
+            T copy = value;
+            reserve(G::next_capacity(m_capacity, m_size + 1, sizeof(T)));
+            m_data[m_size++] = copy;
+            return;
+        }
+        else if (&value >= begin() && &value < end())
+        {
+            T moved(std::move(value));
+            push_back(std::move(moved));
+            return;
+        }
+
+        reserve(G::next_capacity(m_capacity, m_size + 1, sizeof(T)));
+    }
+
+    if constexpr (std::is_trivial_v<T>)
+    {
+        m_data[m_size] = value;
+    }
+    else
+    {
+        new (m_data + m_size) T(std::move(value));
+    }
+
     m_size++;
 }
 
-template <typename T, bool F, int A>
-void fast_vector<T,F,A>::push_back(T&& value)
+template <typename T, bool F, int A, typename M, typename G>
+fast_vector_status fast_vector<T,F,A,M,G>::try_push_back(T&& value)
 {
     if (m_size == m_capacity)
     {
-        reserve(m_capacity * fast_vector::grow_factor + 1);
+        if constexpr (std::is_trivial_v<T>)
+        {
+            T copy = value;
+            fast_vector_status status = try_reserve(G::next_capacity(m_capacity, m_size + 1, sizeof(T)));
+            if (status == fast_vector_status::ok)
+                m_data[m_size++] = copy;
+            return status;
+        }
+        else if (&value >= begin() && &value < end())
+        {
+            T moved(std::move(value));
+            return try_push_back(std::move(moved));
+        }
+
+        fast_vector_status status = try_reserve(G::next_capacity(m_capacity, m_size + 1, sizeof(T)));
+        if (status != fast_vector_status::ok)
+            return status;
     }
 
     if constexpr (std::is_trivial_v<T>)
@@ -568,17 +1714,23 @@ void fast_vector<T,F,A>::push_back(T&& value)
     }
 
     m_size++;
+    return fast_vector_status::ok;
 }
 
-template <typename T, bool F, int A>
+template <typename T, bool F, int A, typename M, typename G>
 template< class... Args >
-void fast_vector<T,F,A>::emplace_back(Args&&... args)
+void fast_vector<T,F,A,M,G>::emplace_back(Args&&... args)
 {
     static_assert(!std::is_trivial_v<T>, "Use push_back() instead of emplace_back() with trivial types");
 
     if (m_size == m_capacity)
     {
-        reserve(m_capacity * fast_vector::grow_factor + 1);
+        // The arguments may refer into the block the reallocation frees, build the element first
+        T value(std::forward<Args>(args)...);
+        reserve(G::next_capacity(m_capacity, m_size + 1, sizeof(T)));
+        new (m_data + m_size) T(std::move(value));
+        m_size++;
+        return;
     }
 
     new (m_data + m_size) T(std::forward<Args>(args)...);
@@ -586,8 +1738,8 @@ void fast_vector<T,F,A>::emplace_back(Args&&... args)
     m_size++;
 }
 
-template <typename T, bool F, int A>
-void fast_vector<T,F,A>::pop_back()
+template <typename T, bool F, int A, typename M, typename G>
+void fast_vector<T,F,A,M,G>::pop_back()
 {
     assert(m_size > 0 && "Container is empty");
 
@@ -599,15 +1751,30 @@ void fast_vector<T,F,A>::pop_back()
     m_size--;
 }
 
-template <typename T, bool F, int A>
-void fast_vector<T,F,A>::resize(size_type count)
+template <typename T, bool F, int A, typename M, typename G>
+void fast_vector<T,F,A,M,G>::resize(size_type count)
+{
+    resize(count, no_init);
+}
+
+template <typename T, bool F, int A, typename M, typename G>
+void fast_vector<T,F,A,M,G>::resize(size_type count, no_init_t)
+{
+    if (try_resize(count) != fast_vector_status::ok)
+        fast_vector_out_of_memory();
+}
+
+template <typename T, bool F, int A, typename M, typename G>
+fast_vector_status fast_vector<T,F,A,M,G>::try_resize(size_type count)
 {
     if (count == m_size)
-        return;
+        return fast_vector_status::ok;
 
     if (count > m_capacity)
     {
-        reserve(count);
+        fast_vector_status status = try_reserve(count);
+        if (status != fast_vector_status::ok)
+            return status;
     }
 
     if constexpr (!std::is_trivial_v<T>)
@@ -622,5 +1789,66 @@ void fast_vector<T,F,A>::resize(size_type count)
         }
     }
 
+    m_size = count;
+    return fast_vector_status::ok;
+}
+
+template <typename T, bool F, int A, typename M, typename G>
+void fast_vector<T,F,A,M,G>::resize(size_type count, zero_init_t)
+{
+    static_assert(std::is_trivial_v<T> | F, "Only trivial types can be zero initialized");
+
+    if (count <= m_size)
+    {
+        m_size = count;
+        return;
+    }
+
+    if (!m_data)
+    {
+        // Nothing to keep, the allocator may hand out memory which is already zero
+        m_data = reinterpret_cast<T*>(M::allocate_zeroed(sizeof(T) * count, alignment));
+        if (!m_data)
+            fast_vector_out_of_memory();
+
+        m_capacity = count;
+    }
+    else
+    {
+        if (count > m_capacity)
+        {
+            reserve(count);
+        }
+
+        std::memset(static_cast<void*>(m_data + m_size), 0, sizeof(T) * (count - m_size));
+    }
+
+    m_size = count;
+}
+
+template <typename T, bool F, int A, typename M, typename G>
+void fast_vector<T,F,A,M,G>::resize(size_type count, const T& value)
+{
+    if (count <= m_size)
+    {
+        resize(count, no_init);
+        return;
+    }
+
+    if (count > m_capacity && &value >= begin() && &value < end())
+    {
+        // The value lives inside and would be moved by the reallocation
+        T copy(value);
+        resize(count, copy);
+        return;
+    }
+
+    if (count > m_capacity)
+    {
+        reserve(count);
+    }
+
+    fill_range(m_data + m_size, m_data + count, value);
+
     m_size = count;
 }
@@ -0,0 +1,74 @@
+//
+// POSIX I/O straight into the tail of a byte fast_vector
+//
+// Advanced & fixed version by Marian Krivos
+//
+
+#pragma once
+
+#include "fast_vector.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <cerrno>
+#include <sys/socket.h> // recv()
+#include <sys/types.h>
+#include <unistd.h>     // read(), pread()
+
+// Each helper appends up to max_bytes to the vector and returns what the system call did:
+// the number of bytes appended, 0 at the end of the data or -1 with errno set. The vector
+// grows at most once per call and keeps exactly the bytes received.
+
+template <typename V>
+inline ssize_t append_read(V& vector, int fd, std::size_t max_bytes)
+{
+    static_assert(sizeof(typename V::value_type) == 1, "Only byte vectors can be read into");
+
+    auto tail = vector.append_uninitialized(max_bytes);
+    ssize_t received = ::read(fd, tail.data(), max_bytes);
+    tail.commit(received > 0 ? std::size_t(received) : 0);
+
+    return received;
+}
+
+template <typename V>
+inline ssize_t append_recv(V& vector, int socket, std::size_t max_bytes, int flags = 0)
+{
+    static_assert(sizeof(typename V::value_type) == 1, "Only byte vectors can be received into");
+
+    auto tail = vector.append_uninitialized(max_bytes);
+    ssize_t received = ::recv(socket, tail.data(), max_bytes, flags);
+    tail.commit(received > 0 ? std::size_t(received) : 0);
+
+    return received;
+}
+
+template <typename V>
+inline ssize_t append_pread(V& vector, int fd, std::size_t max_bytes, off_t offset)
+{
+    static_assert(sizeof(typename V::value_type) == 1, "Only byte vectors can be read into");
+
+    auto tail = vector.append_uninitialized(max_bytes);
+    ssize_t received = ::pread(fd, tail.data(), max_bytes, offset);
+    tail.commit(received > 0 ? std::size_t(received) : 0);
+
+    return received;
+}
+
+/**
+ * Reads the whole file (or the rest of a pipe) in chunk_bytes steps, returns false on error.
+ */
+template <typename V>
+inline bool append_read_all(V& vector, int fd, std::size_t chunk_bytes = 64 * 1024)
+{
+    for (;;)
+    {
+        ssize_t received = append_read(vector, fd, chunk_bytes);
+        if (received == 0)
+            return true;
+        if (received < 0 && errno != EINTR)
+            return false;
+    }
+}
+
+#endif // __unix__ || __APPLE__
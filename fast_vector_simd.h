@@ -0,0 +1,338 @@
+//
+// SIMD kernels for the arithmetic fast_vector element types
+//
+// Advanced & fixed version by Marian Krivos
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// x86 kernels are compiled with per-function target attributes and picked at runtime,
+// so no -mavx2/-mavx512f is needed and the binary still runs on older CPUs
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__)) && !defined(FAST_VECTOR_NO_SIMD)
+#define FAST_VECTOR_X86_DISPATCH 1
+#include <immintrin.h>
+#endif
+
+// Element types the kernels know about: 4 and 8 byte integers and floats
+template <typename T>
+inline constexpr bool is_simd_element_v = std::is_arithmetic_v<T> && !std::is_same_v<T, bool> &&
+                                          (sizeof(T) == 4 || sizeof(T) == 8);
+
+// Scalar fallbacks
+
+template <typename T>
+inline const T* find_equal_scalar(const T* begin, const T* end, T value)
+{
+    for (; begin != end; ++begin)
+    {
+        if (*begin == value)
+            return begin;
+    }
+    return end;
+}
+
+template <typename T>
+inline std::size_t count_equal_scalar(const T* begin, const T* end, T value)
+{
+    std::size_t count = 0;
+    for (; begin != end; ++begin)
+    {
+        count += *begin == value;
+    }
+    return count;
+}
+
+template <typename T>
+inline T* compress_not_equal_scalar(T* begin, T* end, T value)
+{
+    T* out = begin;
+    for (; begin != end; ++begin)
+    {
+        // Written as !(a == b) so NaN is never matched, like the operator== based paths
+        if (!(*begin == value))
+            *out++ = *begin;
+    }
+    return out;
+}
+
+#if defined(FAST_VECTOR_X86_DISPATCH)
+
+enum class simd_level
+{
+    scalar,
+    sse2,
+    avx2,
+    avx512
+};
+
+inline simd_level detect_simd_level() noexcept
+{
+    static const simd_level level = []
+    {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f"))
+            return simd_level::avx512;
+        if (__builtin_cpu_supports("avx2"))
+            return simd_level::avx2;
+        if (__builtin_cpu_supports("sse2"))
+            return simd_level::sse2;
+        return simd_level::scalar;
+    }();
+    return level;
+}
+
+// Permutation tables for the AVX2 left-packing: entry m lists the lanes whose bit is set in m
+
+struct compress_tables
+{
+    std::uint64_t lanes8[256];  // 8 x 32 bit lanes, one byte index each
+    std::uint64_t lanes4[16];   // 4 x 64 bit lanes as pairs of 32 bit indices
+
+    constexpr compress_tables() : lanes8(), lanes4()
+    {
+        for (int mask = 0; mask < 256; mask++)
+        {
+            std::uint64_t entry = 0;
+            int slot = 0;
+            for (int lane = 0; lane < 8; lane++)
+            {
+                if (mask & (1 << lane))
+                    entry |= std::uint64_t(lane) << (8 * slot++);
+            }
+            lanes8[mask] = entry;
+        }
+        for (int mask = 0; mask < 16; mask++)
+        {
+            std::uint64_t entry = 0;
+            int slot = 0;
+            for (int lane = 0; lane < 4; lane++)
+            {
+                if (mask & (1 << lane))
+                {
+                    entry |= std::uint64_t(2 * lane) << (8 * slot++);
+                    entry |= std::uint64_t(2 * lane + 1) << (8 * slot++);
+                }
+            }
+            lanes4[mask] = entry;
+        }
+    }
+};
+
+inline constexpr compress_tables compress_lut{};
+
+// Lane masks of the elements equal to value, NaN never matches
+
+template <typename T>
+__attribute__((target("sse2"))) inline unsigned equal_mask_sse2(const T* src, T value)
+{
+    __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+
+    if constexpr (std::is_same_v<T, float>)
+        return _mm_movemask_ps(_mm_cmpeq_ps(_mm_castsi128_ps(raw), _mm_set1_ps(value)));
+    else if constexpr (std::is_same_v<T, double>)
+        return _mm_movemask_pd(_mm_cmpeq_pd(_mm_castsi128_pd(raw), _mm_set1_pd(value)));
+    else if constexpr (sizeof(T) == 4)
+        return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(raw, _mm_set1_epi32(int(value)))));
+    else
+    {
+        // No 64 bit compare before SSE4.1, both halves have to match
+        __m128i halves = _mm_cmpeq_epi32(raw, _mm_set1_epi64x((long long)value));
+        __m128i both = _mm_and_si128(halves, _mm_shuffle_epi32(halves, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_movemask_pd(_mm_castsi128_pd(both));
+    }
+}
+
+template <typename T>
+__attribute__((target("avx2"))) inline unsigned equal_mask_avx2(const T* src, T value)
+{
+    __m256i raw = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+
+    if constexpr (std::is_same_v<T, float>)
+        return _mm256_movemask_ps(_mm256_cmp_ps(_mm256_castsi256_ps(raw), _mm256_set1_ps(value), _CMP_EQ_OQ));
+    else if constexpr (std::is_same_v<T, double>)
+        return _mm256_movemask_pd(_mm256_cmp_pd(_mm256_castsi256_pd(raw), _mm256_set1_pd(value), _CMP_EQ_OQ));
+    else if constexpr (sizeof(T) == 4)
+        return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(raw, _mm256_set1_epi32(int(value)))));
+    else
+        return _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(raw, _mm256_set1_epi64x((long long)value))));
+}
+
+template <typename T>
+__attribute__((target("avx512f"))) inline unsigned equal_mask_avx512f(const T* src, T value)
+{
+    if constexpr (std::is_same_v<T, float>)
+        return _mm512_cmp_ps_mask(_mm512_loadu_ps(src), _mm512_set1_ps(value), _CMP_EQ_OQ);
+    else if constexpr (std::is_same_v<T, double>)
+        return _mm512_cmp_pd_mask(_mm512_loadu_pd(src), _mm512_set1_pd(value), _CMP_EQ_OQ);
+    else if constexpr (sizeof(T) == 4)
+        return _mm512_cmpeq_epi32_mask(_mm512_loadu_si512(src), _mm512_set1_epi32(int(value)));
+    else
+        return _mm512_cmpeq_epi64_mask(_mm512_loadu_si512(src), _mm512_set1_epi64((long long)value));
+}
+
+// The same search & count loop for every instruction set, Width is the vector size in bytes
+
+#define FAST_VECTOR_SEARCH_KERNELS(ISA, Width)                                                  \
+template <typename T>                                                                           \
+__attribute__((target(#ISA))) inline const T* find_equal_##ISA(const T* begin, const T* end, T value) \
+{                                                                                               \
+    constexpr std::ptrdiff_t lanes = Width / sizeof(T);                                         \
+    for (; end - begin >= lanes; begin += lanes)                                                \
+    {                                                                                           \
+        if (unsigned mask = equal_mask_##ISA(begin, value))                                     \
+            return begin + __builtin_ctz(mask);                                                 \
+    }                                                                                           \
+    return find_equal_scalar(begin, end, value);                                                \
+}                                                                                               \
+                                                                                                \
+template <typename T>                                                                           \
+__attribute__((target(#ISA))) inline std::size_t count_equal_##ISA(const T* begin, const T* end, T value) \
+{                                                                                               \
+    constexpr std::ptrdiff_t lanes = Width / sizeof(T);                                         \
+    std::size_t count = 0;                                                                      \
+    for (; end - begin >= lanes; begin += lanes)                                                \
+    {                                                                                           \
+        count += __builtin_popcount(equal_mask_##ISA(begin, value));                            \
+    }                                                                                           \
+    return count + count_equal_scalar(begin, end, value);                                       \
+}
+
+FAST_VECTOR_SEARCH_KERNELS(sse2, 16)
+FAST_VECTOR_SEARCH_KERNELS(avx2, 32)
+FAST_VECTOR_SEARCH_KERNELS(avx512f, 64)
+
+#undef FAST_VECTOR_SEARCH_KERNELS
+
+// In-place left-packing: the output never overtakes the block being read, so full
+// width stores are safe
+
+template <typename T>
+__attribute__((target("avx2"))) inline T* compress_not_equal_avx2(T* begin, T* end, T value)
+{
+    constexpr std::size_t lanes = 32 / sizeof(T);
+
+    T* out = begin;
+    for (; end - begin >= std::ptrdiff_t(lanes); begin += lanes)
+    {
+        unsigned keep = ~equal_mask_avx2(begin, value) & ((1u << lanes) - 1);
+
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+        std::uint64_t entry = sizeof(T) == 4 ? compress_lut.lanes8[keep] : compress_lut.lanes4[keep];
+        __m256i permutation = _mm256_cvtepu8_epi32(_mm_cvtsi64_si128((long long)entry));
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_permutevar8x32_epi32(block, permutation));
+        out += __builtin_popcount(keep);
+    }
+    for (; begin != end; ++begin)
+    {
+        if (!(*begin == value))
+            *out++ = *begin;
+    }
+    return out;
+}
+
+template <typename T>
+__attribute__((target("avx512f"))) inline T* compress_not_equal_avx512(T* begin, T* end, T value)
+{
+    constexpr std::size_t lanes = 64 / sizeof(T);
+
+    T* out = begin;
+    for (; end - begin >= std::ptrdiff_t(lanes); begin += lanes)
+    {
+        unsigned keep = ~equal_mask_avx512f(begin, value) & ((1u << lanes) - 1);
+
+        if constexpr (sizeof(T) == 4)
+            _mm512_mask_compressstoreu_epi32(out, __mmask16(keep), _mm512_loadu_si512(begin));
+        else
+            _mm512_mask_compressstoreu_epi64(out, __mmask8(keep), _mm512_loadu_si512(begin));
+
+        out += __builtin_popcount(keep);
+    }
+    for (; begin != end; ++begin)
+    {
+        if (!(*begin == value))
+            *out++ = *begin;
+    }
+    return out;
+}
+
+#endif // FAST_VECTOR_X86_DISPATCH
+
+/**
+ * Returns the first element equal to value or end. Vectorized for is_simd_element_v types.
+ */
+template <typename T>
+inline const T* find_equal(const T* begin, const T* end, T value)
+{
+#if defined(FAST_VECTOR_X86_DISPATCH)
+    if constexpr (is_simd_element_v<T>)
+    {
+        switch (detect_simd_level())
+        {
+        case simd_level::avx512:
+            return find_equal_avx512f(begin, end, value);
+        case simd_level::avx2:
+            return find_equal_avx2(begin, end, value);
+        case simd_level::sse2:
+            return find_equal_sse2(begin, end, value);
+        default:
+            break;
+        }
+    }
+#endif
+    return find_equal_scalar(begin, end, value);
+}
+
+/**
+ * Counts the elements equal to value. Vectorized for is_simd_element_v types.
+ */
+template <typename T>
+inline std::size_t count_equal(const T* begin, const T* end, T value)
+{
+#if defined(FAST_VECTOR_X86_DISPATCH)
+    if constexpr (is_simd_element_v<T>)
+    {
+        switch (detect_simd_level())
+        {
+        case simd_level::avx512:
+            return count_equal_avx512f(begin, end, value);
+        case simd_level::avx2:
+            return count_equal_avx2(begin, end, value);
+        case simd_level::sse2:
+            return count_equal_sse2(begin, end, value);
+        default:
+            break;
+        }
+    }
+#endif
+    return count_equal_scalar(begin, end, value);
+}
+
+/**
+ * Removes the elements equal to value from [begin, end) keeping the order of the rest,
+ * returns the new end. Vectorized for is_simd_element_v types.
+ */
+template <typename T>
+inline T* compress_not_equal(T* begin, T* end, T value)
+{
+#if defined(FAST_VECTOR_X86_DISPATCH)
+    if constexpr (is_simd_element_v<T>)
+    {
+        switch (detect_simd_level())
+        {
+        case simd_level::avx512:
+            return compress_not_equal_avx512(begin, end, value);
+        case simd_level::avx2:
+            return compress_not_equal_avx2(begin, end, value);
+        default:
+            break;
+        }
+    }
+#endif
+    return compress_not_equal_scalar(begin, end, value);
+}
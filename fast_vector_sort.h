@@ -0,0 +1,629 @@
+//
+// Sorting kernels for fast_vector: LSD radix sort and pattern-defeating quicksort
+//
+// Advanced & fixed version by Marian Krivos
+//
+
+#pragma once
+
+#include <algorithm> // std::make_heap(), std::sort_heap()
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+// Radix keys
+
+/**
+ * Customization point mapping a T to an unsigned key whose integer order is the order of T.
+ * Enabled for the integers, float, double and pairs of integers up to 32 bits each (ordered
+ * by first, then second). Specialize it with enabled, key_type and a static key() to radix
+ * sort other types.
+ */
+template <typename T, typename = void>
+struct radix_key_traits
+{
+    static constexpr bool enabled = false;
+};
+
+template <typename T>
+inline constexpr bool has_radix_key_v = radix_key_traits<T>::enabled;
+
+template <typename T>
+struct radix_key_traits<T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>>
+{
+    static constexpr bool enabled = true;
+    using key_type = std::make_unsigned_t<T>;
+
+    // Flipping the sign bit moves the negative numbers below the positive ones
+    static constexpr key_type sign_bit = std::is_signed_v<T> ? key_type(key_type(1) << (sizeof(T) * 8 - 1)) : 0;
+
+    static key_type key(T value) noexcept
+    {
+        return key_type(key_type(value) ^ sign_bit);
+    }
+};
+
+template <typename T>
+struct radix_key_traits<T, std::enable_if_t<std::is_same_v<T, float> || std::is_same_v<T, double>>>
+{
+    static constexpr bool enabled = true;
+    using key_type = std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>;
+
+    // Negative numbers get all bits flipped (larger magnitude sorts first), the rest just the
+    // sign bit. -0.0 sorts before 0.0, NaNs go to the ends by their sign.
+    static key_type key(T value) noexcept
+    {
+        key_type bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        const key_type negative = bits >> (sizeof(T) * 8 - 1);
+        return bits ^ (key_type(0 - negative) | (key_type(1) << (sizeof(T) * 8 - 1)));
+    }
+};
+
+template <typename T1, typename T2>
+struct radix_key_traits<std::pair<T1, T2>, std::enable_if_t<std::is_integral_v<T1> && std::is_integral_v<T2> &&
+                                                            has_radix_key_v<T1> && has_radix_key_v<T2> &&
+                                                            sizeof(T1) <= 4 && sizeof(T2) <= 4>>
+{
+    static constexpr bool enabled = true;
+    using key_type = std::uint64_t;
+
+    static key_type key(const std::pair<T1, T2>& value) noexcept
+    {
+        return key_type(radix_key_traits<T1>::key(value.first)) << 32 | radix_key_traits<T2>::key(value.second);
+    }
+};
+
+// Below this many elements per key byte a comparison sort beats the histogram and scatter passes
+inline constexpr std::size_t radix_sort_threshold = 1024;
+
+/**
+ * Stable LSD radix sort of count elements by key(element), an unsigned integer, one byte per
+ * pass. Sorted inputs are returned right away, all the byte histograms are taken in a single
+ * read of the data and the passes where every key has the same byte are skipped, so narrow
+ * key ranges cost a few passes only. Elements are moved by memcpy between data and
+ * scratch (count slots of raw storage) and end up in data.
+ */
+template <typename T, typename Key>
+void radix_sort(T* data, T* scratch, std::size_t count, Key key)
+{
+    using key_type = decltype(key(*data));
+    constexpr std::size_t passes = sizeof(key_type);
+
+    static_assert(std::is_unsigned_v<key_type>, "Radix keys must be unsigned integers");
+
+    if (count < 2)
+        return;
+
+    // Stops at the first descent, so it costs next to nothing unless the input is sorted
+    std::size_t ordered = 1;
+    while (ordered < count && key(data[ordered - 1]) <= key(data[ordered]))
+        ordered++;
+
+    if (ordered == count)
+        return;
+
+    std::size_t histogram[passes][256] = {};
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        const key_type k = key(data[i]);
+        for (std::size_t pass = 0; pass < passes; pass++)
+            ++histogram[pass][(k >> (pass * 8)) & 0xff];
+    }
+
+    T* from = data;
+    T* to = scratch;
+
+    for (std::size_t pass = 0; pass < passes; pass++)
+    {
+        std::size_t* offsets = histogram[pass];
+        const unsigned shift = unsigned(pass * 8);
+
+        if (offsets[(key(from[0]) >> shift) & 0xff] == count)
+            continue;
+
+        std::size_t sum = 0;
+        for (std::size_t digit = 0; digit < 256; digit++)
+        {
+            const std::size_t n = offsets[digit];
+            offsets[digit] = sum;
+            sum += n;
+        }
+
+        for (std::size_t i = 0; i < count; i++)
+        {
+            const std::size_t digit = (key(from[i]) >> shift) & 0xff;
+            std::memcpy(static_cast<void*>(to + offsets[digit]++), static_cast<const void*>(from + i), sizeof(T));
+        }
+
+        std::swap(from, to);
+    }
+
+    if (from != data)
+        std::memcpy(static_cast<void*>(data), static_cast<const void*>(from), sizeof(T) * count);
+}
+
+// Pattern-defeating quicksort (Orson Peters), over raw pointers
+
+namespace pdqsort_detail
+{
+    enum : std::size_t
+    {
+        insertion_sort_threshold = 24,
+        ninther_threshold = 128,
+        partial_insertion_sort_limit = 8,
+        block_size = 64,
+        cacheline_size = 64
+    };
+
+    template <typename T, typename Compare>
+    inline void insertion_sort(T* begin, T* end, Compare& comp)
+    {
+        if (begin == end)
+            return;
+
+        for (T* cur = begin + 1; cur != end; ++cur)
+        {
+            T* sift = cur;
+            T* sift_1 = cur - 1;
+
+            if (comp(*sift, *sift_1))
+            {
+                T tmp = std::move(*sift);
+
+                do
+                {
+                    *sift-- = std::move(*sift_1);
+                } while (sift != begin && comp(tmp, *--sift_1));
+
+                *sift = std::move(tmp);
+            }
+        }
+    }
+
+    // The element before begin is known to be no greater than any in the range
+    template <typename T, typename Compare>
+    inline void unguarded_insertion_sort(T* begin, T* end, Compare& comp)
+    {
+        if (begin == end)
+            return;
+
+        for (T* cur = begin + 1; cur != end; ++cur)
+        {
+            T* sift = cur;
+            T* sift_1 = cur - 1;
+
+            if (comp(*sift, *sift_1))
+            {
+                T tmp = std::move(*sift);
+
+                do
+                {
+                    *sift-- = std::move(*sift_1);
+                } while (comp(tmp, *--sift_1));
+
+                *sift = std::move(tmp);
+            }
+        }
+    }
+
+    // Gives up (returning false) after moving more than partial_insertion_sort_limit elements
+    template <typename T, typename Compare>
+    inline bool partial_insertion_sort(T* begin, T* end, Compare& comp)
+    {
+        if (begin == end)
+            return true;
+
+        std::size_t limit = 0;
+        for (T* cur = begin + 1; cur != end; ++cur)
+        {
+            T* sift = cur;
+            T* sift_1 = cur - 1;
+
+            if (comp(*sift, *sift_1))
+            {
+                T tmp = std::move(*sift);
+
+                do
+                {
+                    *sift-- = std::move(*sift_1);
+                } while (sift != begin && comp(tmp, *--sift_1));
+
+                *sift = std::move(tmp);
+                limit += std::size_t(cur - sift);
+            }
+
+            if (limit > partial_insertion_sort_limit)
+                return false;
+        }
+
+        return true;
+    }
+
+    template <typename T, typename Compare>
+    inline void sort2(T* a, T* b, Compare& comp)
+    {
+        if (comp(*b, *a))
+            std::iter_swap(a, b);
+    }
+
+    template <typename T, typename Compare>
+    inline void sort3(T* a, T* b, T* c, Compare& comp)
+    {
+        sort2(a, b, comp);
+        sort2(b, c, comp);
+        sort2(a, b, comp);
+    }
+
+    template <typename T>
+    inline T* align_cacheline(T* ptr)
+    {
+        std::uintptr_t address = reinterpret_cast<std::uintptr_t>(ptr);
+        address = (address + cacheline_size - 1) & ~std::uintptr_t(cacheline_size - 1);
+        return reinterpret_cast<T*>(address);
+    }
+
+    // Swaps the elements at the collected offsets, as a cycle of moves unless the two
+    // offset lists have the same length (then some elements would be swapped twice)
+    template <typename T>
+    inline void swap_offsets(T* first, T* last, const unsigned char* offsets_l, const unsigned char* offsets_r,
+                             std::size_t num, bool use_swaps)
+    {
+        if (use_swaps)
+        {
+            for (std::size_t i = 0; i < num; ++i)
+                std::iter_swap(first + offsets_l[i], last - offsets_r[i]);
+        }
+        else if (num > 0)
+        {
+            T* l = first + offsets_l[0];
+            T* r = last - offsets_r[0];
+            T tmp(std::move(*l));
+            *l = std::move(*r);
+
+            for (std::size_t i = 1; i < num; ++i)
+            {
+                l = first + offsets_l[i];
+                *r = std::move(*l);
+                r = last - offsets_r[i];
+                *l = std::move(*r);
+            }
+
+            *r = std::move(tmp);
+        }
+    }
+
+    /**
+     * Partitions around *begin, elements equal to the pivot go right. The comparisons only
+     * record offsets of misplaced elements into small buffers (block partitioning), so the
+     * loop has no data dependent branches. Returns the pivot position and whether the range
+     * was already partitioned.
+     */
+    template <typename T, typename Compare>
+    inline std::pair<T*, bool> partition_right_branchless(T* begin, T* end, Compare& comp)
+    {
+        T pivot(std::move(*begin));
+        T* first = begin;
+        T* last = end;
+
+        // The median of 3 guarantees an element >= pivot on the right and the pivot itself on the left
+        while (comp(*++first, pivot));
+
+        if (first - 1 == begin)
+            while (first < last && !comp(*--last, pivot));
+        else
+            while (!comp(*--last, pivot));
+
+        const bool already_partitioned = first >= last;
+
+        if (!already_partitioned)
+        {
+            std::iter_swap(first, last);
+            ++first;
+
+            alignas(cacheline_size) unsigned char offsets_l_storage[block_size + cacheline_size];
+            alignas(cacheline_size) unsigned char offsets_r_storage[block_size + cacheline_size];
+            unsigned char* offsets_l = align_cacheline(offsets_l_storage);
+            unsigned char* offsets_r = align_cacheline(offsets_r_storage);
+
+            T* offsets_l_base = first;
+            T* offsets_r_base = last;
+            std::size_t num_l = 0, num_r = 0, start_l = 0, start_r = 0;
+
+            while (first < last)
+            {
+                const std::size_t num_unknown = std::size_t(last - first);
+                const std::size_t left_split = num_l == 0 ? (num_r == 0 ? num_unknown / 2 : num_unknown) : 0;
+                const std::size_t right_split = num_r == 0 ? (num_unknown - left_split) : 0;
+
+                if (left_split >= block_size)
+                {
+                    for (std::size_t i = 0; i < block_size;)
+                    {
+                        offsets_l[num_l] = static_cast<unsigned char>(i++); num_l += !comp(*first, pivot); ++first;
+                        offsets_l[num_l] = static_cast<unsigned char>(i++); num_l += !comp(*first, pivot); ++first;
+                        offsets_l[num_l] = static_cast<unsigned char>(i++); num_l += !comp(*first, pivot); ++first;
+                        offsets_l[num_l] = static_cast<unsigned char>(i++); num_l += !comp(*first, pivot); ++first;
+                        offsets_l[num_l] = static_cast<unsigned char>(i++); num_l += !comp(*first, pivot); ++first;
+                        offsets_l[num_l] = static_cast<unsigned char>(i++); num_l += !comp(*first, pivot); ++first;
+                        offsets_l[num_l] = static_cast<unsigned char>(i++); num_l += !comp(*first, pivot); ++first;
+                        offsets_l[num_l] = static_cast<unsigned char>(i++); num_l += !comp(*first, pivot); ++first;
+                    }
+                }
+                else
+                {
+                    for (std::size_t i = 0; i < left_split;)
+                    {
+                        offsets_l[num_l] = static_cast<unsigned char>(i++); num_l += !comp(*first, pivot); ++first;
+                    }
+                }
+
+                if (right_split >= block_size)
+                {
+                    for (std::size_t i = 0; i < block_size;)
+                    {
+                        offsets_r[num_r] = static_cast<unsigned char>(++i); num_r += comp(*--last, pivot);
+                        offsets_r[num_r] = static_cast<unsigned char>(++i); num_r += comp(*--last, pivot);
+                        offsets_r[num_r] = static_cast<unsigned char>(++i); num_r += comp(*--last, pivot);
+                        offsets_r[num_r] = static_cast<unsigned char>(++i); num_r += comp(*--last, pivot);
+                        offsets_r[num_r] = static_cast<unsigned char>(++i); num_r += comp(*--last, pivot);
+                        offsets_r[num_r] = static_cast<unsigned char>(++i); num_r += comp(*--last, pivot);
+                        offsets_r[num_r] = static_cast<unsigned char>(++i); num_r += comp(*--last, pivot);
+                        offsets_r[num_r] = static_cast<unsigned char>(++i); num_r += comp(*--last, pivot);
+                    }
+                }
+                else
+                {
+                    for (std::size_t i = 0; i < right_split;)
+                    {
+                        offsets_r[num_r] = static_cast<unsigned char>(++i); num_r += comp(*--last, pivot);
+                    }
+                }
+
+                const std::size_t num = num_l < num_r ? num_l : num_r;
+                swap_offsets(offsets_l_base, offsets_r_base, offsets_l + start_l, offsets_r + start_r, num, num_l == num_r);
+                num_l -= num;
+                num_r -= num;
+                start_l += num;
+                start_r += num;
+
+                if (num_l == 0)
+                {
+                    start_l = 0;
+                    offsets_l_base = first;
+                }
+
+                if (num_r == 0)
+                {
+                    start_r = 0;
+                    offsets_r_base = last;
+                }
+            }
+
+            // One of the buffers may still hold misplaced elements, move them to the boundary
+            if (num_l)
+            {
+                offsets_l += start_l;
+                while (num_l--)
+                    std::iter_swap(offsets_l_base + offsets_l[num_l], --last);
+                first = last;
+            }
+
+            if (num_r)
+            {
+                offsets_r += start_r;
+                while (num_r--)
+                {
+                    std::iter_swap(offsets_r_base - offsets_r[num_r], first);
+                    ++first;
+                }
+                last = first;
+            }
+        }
+
+        T* pivot_pos = first - 1;
+        *begin = std::move(*pivot_pos);
+        *pivot_pos = std::move(pivot);
+
+        return std::make_pair(pivot_pos, already_partitioned);
+    }
+
+    // partition_right_branchless() with plain Hoare partitioning, for the expensive comparisons
+    template <typename T, typename Compare>
+    inline std::pair<T*, bool> partition_right(T* begin, T* end, Compare& comp)
+    {
+        T pivot(std::move(*begin));
+        T* first = begin;
+        T* last = end;
+
+        while (comp(*++first, pivot));
+
+        if (first - 1 == begin)
+            while (first < last && !comp(*--last, pivot));
+        else
+            while (!comp(*--last, pivot));
+
+        const bool already_partitioned = first >= last;
+
+        while (first < last)
+        {
+            std::iter_swap(first, last);
+            while (comp(*++first, pivot));
+            while (!comp(*--last, pivot));
+        }
+
+        T* pivot_pos = first - 1;
+        *begin = std::move(*pivot_pos);
+        *pivot_pos = std::move(pivot);
+
+        return std::make_pair(pivot_pos, already_partitioned);
+    }
+
+    // Elements equal to the pivot go left, used when the pivot equals its predecessor so
+    // runs of equal keys are finished in one step
+    template <typename T, typename Compare>
+    inline T* partition_left(T* begin, T* end, Compare& comp)
+    {
+        T pivot(std::move(*begin));
+        T* first = begin;
+        T* last = end;
+
+        while (comp(pivot, *--last));
+
+        if (last + 1 == end)
+            while (first < last && !comp(pivot, *++first));
+        else
+            while (!comp(pivot, *++first));
+
+        while (first < last)
+        {
+            std::iter_swap(first, last);
+            while (comp(pivot, *--last));
+            while (!comp(pivot, *++first));
+        }
+
+        T* pivot_pos = last;
+        *begin = std::move(*pivot_pos);
+        *pivot_pos = std::move(pivot);
+
+        return pivot_pos;
+    }
+
+    template <bool Branchless, typename T, typename Compare>
+    inline void pdqsort_loop(T* begin, T* end, Compare& comp, int bad_allowed, bool leftmost = true)
+    {
+        for (;;)
+        {
+            const std::size_t size = std::size_t(end - begin);
+
+            if (size < insertion_sort_threshold)
+            {
+                if (leftmost)
+                    insertion_sort(begin, end, comp);
+                else
+                    unguarded_insertion_sort(begin, end, comp);
+                return;
+            }
+
+            // Pivot: median of 3, or pseudomedian of 9 (Tukey's ninther) for the larger ranges
+            const std::size_t s2 = size / 2;
+            if (size > ninther_threshold)
+            {
+                sort3(begin, begin + s2, end - 1, comp);
+                sort3(begin + 1, begin + (s2 - 1), end - 2, comp);
+                sort3(begin + 2, begin + (s2 + 1), end - 3, comp);
+                sort3(begin + (s2 - 1), begin + s2, begin + (s2 + 1), comp);
+                std::iter_swap(begin, begin + s2);
+            }
+            else
+            {
+                sort3(begin + s2, begin, end - 1, comp);
+            }
+
+            // A pivot equal to the element before the range: everything equal to it is done
+            if (!leftmost && !comp(*(begin - 1), *begin))
+            {
+                begin = partition_left(begin, end, comp) + 1;
+                continue;
+            }
+
+            const std::pair<T*, bool> part = Branchless ? partition_right_branchless(begin, end, comp)
+                                                        : partition_right(begin, end, comp);
+            T* pivot_pos = part.first;
+            const bool already_partitioned = part.second;
+
+            const std::size_t l_size = std::size_t(pivot_pos - begin);
+            const std::size_t r_size = std::size_t(end - (pivot_pos + 1));
+            const bool highly_unbalanced = l_size < size / 8 || r_size < size / 8;
+
+            if (highly_unbalanced)
+            {
+                // Too many bad partitions, fall back to the guaranteed n log n heapsort
+                if (--bad_allowed == 0)
+                {
+                    std::make_heap(begin, end, comp);
+                    std::sort_heap(begin, end, comp);
+                    return;
+                }
+
+                // Break the patterns that fooled the pivot selection
+                if (l_size >= insertion_sort_threshold)
+                {
+                    std::iter_swap(begin, begin + l_size / 4);
+                    std::iter_swap(pivot_pos - 1, pivot_pos - l_size / 4);
+
+                    if (l_size > ninther_threshold)
+                    {
+                        std::iter_swap(begin + 1, begin + (l_size / 4 + 1));
+                        std::iter_swap(begin + 2, begin + (l_size / 4 + 2));
+                        std::iter_swap(pivot_pos - 2, pivot_pos - (l_size / 4 + 1));
+                        std::iter_swap(pivot_pos - 3, pivot_pos - (l_size / 4 + 2));
+                    }
+                }
+
+                if (r_size >= insertion_sort_threshold)
+                {
+                    std::iter_swap(pivot_pos + 1, pivot_pos + (1 + r_size / 4));
+                    std::iter_swap(end - 1, end - r_size / 4);
+
+                    if (r_size > ninther_threshold)
+                    {
+                        std::iter_swap(pivot_pos + 2, pivot_pos + (2 + r_size / 4));
+                        std::iter_swap(pivot_pos + 3, pivot_pos + (3 + r_size / 4));
+                        std::iter_swap(end - 2, end - (1 + r_size / 4));
+                        std::iter_swap(end - 3, end - (2 + r_size / 4));
+                    }
+                }
+            }
+            else
+            {
+                // A balanced split of an already partitioned range hints at sorted input,
+                // try to finish it with a few insertions
+                if (already_partitioned && partial_insertion_sort(begin, pivot_pos, comp) &&
+                    partial_insertion_sort(pivot_pos + 1, end, comp))
+                    return;
+            }
+
+            // Recurse into the left part, loop on the right one
+            pdqsort_loop<Branchless>(begin, pivot_pos, comp, bad_allowed, leftmost);
+            begin = pivot_pos + 1;
+            leftmost = false;
+        }
+    }
+
+    template <typename Compare, typename T>
+    inline constexpr bool is_builtin_compare_v =
+        std::is_same_v<Compare, std::less<T>> || std::is_same_v<Compare, std::less<>> ||
+        std::is_same_v<Compare, std::greater<T>> || std::is_same_v<Compare, std::greater<>>;
+} // namespace pdqsort_detail
+
+/**
+ * Unstable O(n log n) sort. Sorted, reversed and few-distinct-keys inputs run in about linear
+ * time and adversarial ones fall back to heapsort.
+ */
+template <bool Branchless, typename T, typename Compare>
+inline void pdqsort(T* begin, T* end, Compare comp)
+{
+    if (end - begin < 2)
+        return;
+
+    int bad_allowed = 0;
+    for (std::size_t n = std::size_t(end - begin); n >>= 1;)
+        bad_allowed++;
+
+    pdqsort_detail::pdqsort_loop<Branchless>(begin, end, comp, bad_allowed);
+}
+
+// Branchless block partitioning when the comparison is a cheap builtin one on arithmetic values
+template <typename T, typename Compare>
+inline void pdqsort(T* begin, T* end, Compare comp)
+{
+    constexpr bool branchless = (std::is_arithmetic_v<T> || std::is_pointer_v<T>) &&
+                                pdqsort_detail::is_builtin_compare_v<Compare, T>;
+
+    pdqsort<branchless>(begin, end, comp);
+}